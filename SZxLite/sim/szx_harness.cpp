@@ -0,0 +1,420 @@
+// Cycle-accurate co-simulation of the SZx accelerator (SZxBlockHarness around SZxAcceleratorCore) under Verilator.
+//
+// The testbench drives the harness with the RoCC commands of rocc.h and serves its memory requests from a
+// behavioral memory with a fixed latency and a limited number of requests in flight. It compresses the input with
+// COMPRESS_ARRAY, its full non-constant blocks with COMPRESS_MULTI and its first non-constant blocks with LOAD_BLOCK
+// and COMPRESS; every block is checked byte for byte against SZx_compress_one_block_float_sw, and the run reports
+// cycles per block, bytes per cycle and the stall breakdown of the COMPRESS_ARRAY pipeline.
+//
+//   szx_harness -i data.npy [-e 1e-3] [-b 64] [-l 20] [-q 16] [-n nbEle] [-k 16]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "VSZxBlockHarness.h"
+#include "verilated.h"
+
+extern "C" {
+#include "szx.h"
+#include "szx_timer.h"
+}
+
+// Harness commands (rocc.h)
+enum {
+    SZX_CONFIG = 0, SZX_SET_RADIUS = 1, SZX_COMPRESS = 2, SZX_COMPRESS_MULTI = 3, SZX_LOAD_BLOCK = 6,
+    SZX_SET_OUTPUT = 7, SZX_SET_MEDIANS = 8, SZX_COMPRESS_ARRAY = 9, SZX_SET_BLOCK = 10
+};
+
+// One block of a COMPRESS_MULTI batch (szx_rocc_desc_t)
+struct Descriptor {
+    uint64_t data;
+    uint32_t median, radius;
+};
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s -i <input> [options]\n", prog);
+    printf("  -i <file>     input: .npy (float32, C order) or raw little-endian float32\n");
+    printf("  -e <bound>    absolute error bound (default 1e-3)\n");
+    printf("  -b <size>     block size (default 64)\n");
+    printf("  -l <cycles>   memory latency (default 20)\n");
+    printf("  -q <n>        memory requests in flight (default 16)\n");
+    printf("  -n <nbEle>    use the first nbEle values only\n");
+    printf("  -k <n>        non-constant blocks also compressed with LOAD_BLOCK and COMPRESS (default 16)\n");
+}
+
+// .npy (version 1-3, '<f4', C order) or raw float32
+static bool readInput(const std::string &path, std::vector<float> &data)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t offset = 0;
+    if (bytes.size() >= 10 && memcmp(bytes.data(), "\x93NUMPY", 6) == 0) {
+        uint8_t major = bytes[6];
+        size_t headerLength = major == 1 ? (uint8_t) bytes[8] | (uint8_t) bytes[9] << 8
+                                         : (uint8_t) bytes[8] | (uint8_t) bytes[9] << 8 |
+                                           (uint8_t) bytes[10] << 16 | (size_t) (uint8_t) bytes[11] << 24;
+        offset = (major == 1 ? 10 : 12) + headerLength;
+        std::string header(bytes.data(), offset < bytes.size() ? offset : bytes.size());
+        if (offset > bytes.size() || header.find("'<f4'") == std::string::npos ||
+            header.find("'fortran_order': True") != std::string::npos) {
+            printf("Error: %s is not a C-order float32 array\n", path.c_str());
+            return false;
+        }
+    }
+    data.resize((bytes.size() - offset) / sizeof(float));
+    memcpy(data.data(), bytes.data() + offset, data.size() * sizeof(float));
+    return true;
+}
+
+// Flat memory from base, with the latency and the parallelism of a simple memory system; responses come back in
+// request order
+class Memory {
+public:
+    static constexpr uint64_t base = 0x80000000ULL;
+
+    Memory(size_t bytes, unsigned latency, unsigned slots) : data(bytes), latency(latency), slots(slots) {}
+
+    uint8_t *at(uint64_t addr) { return &data[addr - base]; }
+    bool ready() const { return pending.size() < slots; }
+
+    void request(uint64_t cycle, uint64_t addr, bool write, unsigned size, uint64_t wdata, unsigned tag)
+    {
+        unsigned bytes = 1u << size;
+        if (addr < base || addr + bytes > base + data.size()) {
+            printf("Error: access of %u bytes at 0x%llx outside the memory\n", bytes, (unsigned long long) addr);
+            exit(1);
+        }
+        uint64_t rdata = 0;
+        if (write)
+            memcpy(at(addr), &wdata, bytes); // the store data is replicated, its low bytes are the value
+        else
+            memcpy(&rdata, at(addr), bytes);
+        pending.push_back({cycle + latency, tag, rdata});
+        if (write)
+            stores++;
+        else
+            loads++;
+    }
+
+    // The response due this cycle, if any
+    bool response(uint64_t cycle, unsigned &tag, uint64_t &rdata)
+    {
+        if (pending.empty() || pending.front().due > cycle)
+            return false;
+        tag = pending.front().tag;
+        rdata = pending.front().data;
+        pending.pop_front();
+        return true;
+    }
+
+    uint64_t loads = 0, stores = 0;
+
+private:
+    struct Response {
+        uint64_t due;
+        unsigned tag;
+        uint64_t data;
+    };
+    std::vector<uint8_t> data;
+    std::deque<Response> pending;
+    unsigned latency, slots;
+};
+
+// Cycles in which each status flag of the harness was set
+struct StallCounters {
+    uint64_t loading = 0, bankWait = 0, statsWait = 0, inputStarved = 0, processing = 0, drainWait = 0,
+             memBackpressure = 0;
+};
+
+class Harness {
+public:
+    Harness(VerilatedContext *ctx, Memory &mem) : top(new VSZxBlockHarness{ctx}), mem(mem)
+    {
+        top->reset = 1;
+        for (int i = 0; i < 5; i++)
+            tick();
+        top->reset = 0;
+        cycle = 0;
+    }
+
+    ~Harness() { top->final(); }
+
+    // Issues a command and runs until its response; returns the response and the cycles it took
+    uint64_t command(unsigned funct, uint64_t rs1, uint64_t rs2, uint64_t &cycles, uint64_t timeout)
+    {
+        uint64_t start = cycle;
+        bool issued = false;
+        while (cycle - start < timeout) {
+            top->io_cmd_valid = !issued;
+            top->io_cmd_bits_funct = funct;
+            top->io_cmd_bits_rs1 = rs1;
+            top->io_cmd_bits_rs2 = rs2;
+            issued |= tick();
+            if (top->io_resp_valid && issued) {
+                uint64_t result = top->io_resp_bits;
+                top->io_cmd_valid = 0;
+                tick();
+                cycles = cycle - start;
+                return result;
+            }
+        }
+        printf("Error: command %u timed out after %llu cycles\n", funct, (unsigned long long) timeout);
+        exit(1);
+    }
+
+    StallCounters stalls;
+
+private:
+    // One clock cycle: the inputs are set, the combinational outputs sampled, then the clock rises.
+    // Returns whether a command was accepted
+    bool tick()
+    {
+        unsigned tag = 0;
+        uint64_t rdata = 0;
+        top->io_memResp_valid = mem.response(cycle, tag, rdata);
+        top->io_memResp_bits_tag = tag;
+        top->io_memResp_bits_data = rdata;
+        top->io_memReq_ready = mem.ready();
+        top->clock = 0;
+        top->eval();
+
+        bool fired = top->io_cmd_valid && top->io_cmd_ready;
+        if (top->io_memReq_valid && top->io_memReq_ready)
+            mem.request(cycle, top->io_memReq_bits_addr, top->io_memReq_bits_write, top->io_memReq_bits_size,
+                        top->io_memReq_bits_data, top->io_memReq_bits_tag);
+        if (top->io_status_active) {
+            stalls.loading += top->io_status_loading;
+            stalls.bankWait += top->io_status_bankWait;
+            stalls.statsWait += top->io_status_statsWait;
+            stalls.inputStarved += top->io_status_inputStarved;
+            stalls.processing += top->io_status_processing;
+            stalls.drainWait += top->io_status_drainWait;
+            stalls.memBackpressure += top->io_status_memBackpressure;
+        }
+
+        top->clock = 1;
+        top->eval();
+        cycle++;
+        return fired;
+    }
+
+    std::unique_ptr<VSZxBlockHarness> top;
+    Memory &mem;
+    uint64_t cycle = 0;
+};
+
+static uint32_t floatBits(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static void reportStall(const char *name, uint64_t count, uint64_t cycles)
+{
+    printf("  %-18s %12llu cycles  %6.2f%%\n", name, (unsigned long long) count, cycles ? 100.0 * count / cycles : 0);
+}
+
+int main(int argc, char **argv)
+{
+    std::string input;
+    float errorBound = 1e-3f;
+    int blockSize = 64;
+    unsigned latency = 20, slots = 16;
+    size_t limit = 0, singleBlocks = 16;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:e:b:l:q:n:k:h")) != -1) {
+        switch (opt) {
+        case 'i': input = optarg; break;
+        case 'e': errorBound = strtof(optarg, NULL); break;
+        case 'b': blockSize = atoi(optarg); break;
+        case 'l': latency = (unsigned) atoi(optarg); break;
+        case 'q': slots = (unsigned) atoi(optarg); break;
+        case 'n': limit = strtoull(optarg, NULL, 10); break;
+        case 'k': singleBlocks = strtoull(optarg, NULL, 10); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (input.empty() || blockSize < 1 || slots < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<float> data;
+    if (!readInput(input, data)) {
+        printf("Error: cannot read %s\n", input.c_str());
+        return 1;
+    }
+    if (limit > 0 && limit < data.size())
+        data.resize(limit);
+    size_t nbEle = data.size();
+    size_t nbBlocks = (nbEle + blockSize - 1) / blockSize;
+    if (nbEle == 0) {
+        printf("Error: %s holds no values\n", input.c_str());
+        return 1;
+    }
+
+    // Reference: the software kernel on every block, timed on the host
+    size_t maxBlockBytes = 5 + (blockSize + 3) / 4 + 4 * (size_t) blockSize;
+    std::vector<std::vector<unsigned char>> expected(nbBlocks);
+    std::vector<unsigned char> leadNumbers((size_t) blockSize * sizeof(int));
+    std::vector<unsigned char> blockState(nbBlocks);
+    std::vector<float> blockMedian(nbBlocks), blockRadius(nbBlocks);
+    double swSeconds = 0;
+    for (size_t block = 0; block < nbBlocks; block++) {
+        float *op = data.data() + block * blockSize;
+        size_t n = nbEle - block * blockSize < (size_t) blockSize ? nbEle - block * blockSize : blockSize;
+        double t0 = SZx_wtime();
+        blockState[block] = computeBlockStateMedianRadius_float(op, n, errorBound, &blockMedian[block],
+                                                                &blockRadius[block]);
+        int size = 0;
+        expected[block].resize(maxBlockBytes);
+        if (blockState[block])
+            SZx_compress_one_block_float_sw(op, n, errorBound, expected[block].data(), &size, leadNumbers.data(),
+                                            blockMedian[block], blockRadius[block]);
+        expected[block].resize(size);
+        swSeconds += SZx_wtime() - t0;
+    }
+    std::vector<size_t> multiBlocks; // COMPRESS_MULTI compresses full blocks of the SET_BLOCK size only
+    for (size_t block = 0; block < nbEle / blockSize; block++)
+        if (blockState[block])
+            multiBlocks.push_back(block);
+
+    // Memory layout: values, compressed blocks, uint16 sizes, float medians, then the descriptors, compressed
+    // blocks and sizes of COMPRESS_MULTI and the output of COMPRESS
+    auto align = [](size_t x) { return (x + 63) & ~(size_t) 63; };
+    uint64_t inAddr = Memory::base;
+    uint64_t outAddr = inAddr + align(nbEle * sizeof(float));
+    uint64_t sizesAddr = outAddr + align(nbBlocks * maxBlockBytes);
+    uint64_t mediansAddr = sizesAddr + align(nbBlocks * sizeof(uint16_t));
+    uint64_t descAddr = mediansAddr + align(nbBlocks * sizeof(float));
+    uint64_t multiOutAddr = descAddr + align(multiBlocks.size() * sizeof(Descriptor));
+    uint64_t multiSizesAddr = multiOutAddr + align(multiBlocks.size() * maxBlockBytes);
+    uint64_t singleOutAddr = multiSizesAddr + align(multiBlocks.size() * sizeof(uint16_t));
+    Memory mem(singleOutAddr + align(maxBlockBytes) - Memory::base, latency, slots);
+    memcpy(mem.at(inAddr), data.data(), nbEle * sizeof(float));
+    for (size_t i = 0; i < multiBlocks.size(); i++) {
+        Descriptor desc = {inAddr + multiBlocks[i] * blockSize * sizeof(float), floatBits(blockMedian[multiBlocks[i]]),
+                           floatBits(blockRadius[multiBlocks[i]])};
+        memcpy(mem.at(descAddr + i * sizeof(Descriptor)), &desc, sizeof(desc));
+    }
+
+    auto ctx = std::make_unique<VerilatedContext>();
+    ctx->commandArgs(argc, argv);
+    Harness harness(ctx.get(), mem);
+
+    uint64_t cycles, timeout = 10000;
+    uint64_t applied = harness.command(SZX_SET_BLOCK, blockSize, 0, cycles, timeout);
+    if (applied != (uint64_t) blockSize) {
+        printf("Error: the harness takes blocks of at most %llu values (MAX_BLOCK_SIZE), not %d\n",
+               (unsigned long long) applied, blockSize);
+        return 1;
+    }
+    harness.command(SZX_CONFIG, floatBits(errorBound), 0, cycles, timeout);
+    harness.command(SZX_SET_OUTPUT, outAddr, sizesAddr, cycles, timeout);
+    harness.command(SZX_SET_MEDIANS, mediansAddr, 0, cycles, timeout);
+    harness.stalls = StallCounters();
+    uint64_t arrayTimeout = timeout + 64 * (uint64_t) latency * nbBlocks + 16 * (uint64_t) nbEle;
+    uint64_t total = harness.command(SZX_COMPRESS_ARRAY, inAddr, nbEle, cycles, arrayTimeout);
+    StallCounters arrayStalls = harness.stalls;
+    uint64_t arrayLoads = mem.loads, arrayStores = mem.stores;
+
+    // COMPRESS_ARRAY: sizes, medians and the blocks back to back
+    uint16_t *sizes = (uint16_t *) mem.at(sizesAddr);
+    float *medians = (float *) mem.at(mediansAddr);
+    size_t offset = 0, mismatches = 0, nbConstant = 0;
+    for (size_t block = 0; block < nbBlocks; block++) {
+        size_t size = expected[block].size();
+        bool ok;
+        if (!blockState[block]) {
+            nbConstant++;
+            ok = sizes[block] == 0 && floatBits(medians[block]) == floatBits(blockMedian[block]);
+        } else {
+            ok = sizes[block] == size && offset + size <= total &&
+                 memcmp(mem.at(outAddr + offset), expected[block].data(), size) == 0;
+        }
+        if (!ok && mismatches++ < 10)
+            printf("Mismatch in block %zu: %s, size %u (expected %zu)\n", block,
+                   blockState[block] ? "non-constant" : "constant", sizes[block], size);
+        offset += sizes[block];
+    }
+    if (offset != total) {
+        printf("Mismatch: the block sizes add up to %zu bytes, COMPRESS_ARRAY returned %llu\n", offset,
+               (unsigned long long) total);
+        mismatches++;
+    }
+
+    // COMPRESS_MULTI on the full non-constant blocks, with the stats of the reference
+    uint64_t multiCycles = 0;
+    harness.command(SZX_SET_OUTPUT, multiOutAddr, multiSizesAddr, cycles, timeout);
+    uint64_t multiTotal = harness.command(SZX_COMPRESS_MULTI, descAddr, multiBlocks.size(), multiCycles, arrayTimeout);
+    uint16_t *multiSizes = (uint16_t *) mem.at(multiSizesAddr);
+    offset = 0;
+    for (size_t i = 0; i < multiBlocks.size(); i++) {
+        const std::vector<unsigned char> &block = expected[multiBlocks[i]];
+        if ((multiSizes[i] != block.size() || offset + block.size() > multiTotal ||
+             memcmp(mem.at(multiOutAddr + offset), block.data(), block.size()) != 0) && mismatches++ < 10)
+            printf("Mismatch in COMPRESS_MULTI block %zu: size %u (expected %zu)\n", multiBlocks[i], multiSizes[i],
+                   block.size());
+        offset += multiSizes[i];
+    }
+    if (offset != multiTotal) {
+        printf("Mismatch: the COMPRESS_MULTI sizes add up to %zu bytes, it returned %llu\n", offset,
+               (unsigned long long) multiTotal);
+        mismatches++;
+    }
+
+    // LOAD_BLOCK and COMPRESS on the first non-constant blocks, the last one possibly shorter
+    size_t nbSingle = 0;
+    for (size_t block = 0; block < nbBlocks && nbSingle < singleBlocks; block++) {
+        if (!blockState[block])
+            continue;
+        size_t n = nbEle - block * blockSize < (size_t) blockSize ? nbEle - block * blockSize : blockSize;
+        harness.command(SZX_CONFIG, floatBits(errorBound), floatBits(blockMedian[block]), cycles, timeout);
+        harness.command(SZX_SET_RADIUS, floatBits(blockRadius[block]), 0, cycles, timeout);
+        uint64_t loaded = harness.command(SZX_LOAD_BLOCK, inAddr + block * blockSize * sizeof(float), n, cycles,
+                                          timeout);
+        uint64_t size = harness.command(SZX_COMPRESS, 0, singleOutAddr, cycles, timeout);
+        const std::vector<unsigned char> &ref = expected[block];
+        if ((loaded != n || size != ref.size() || memcmp(mem.at(singleOutAddr), ref.data(), ref.size()) != 0) &&
+            mismatches++ < 10)
+            printf("Mismatch in COMPRESS of block %zu: %llu values loaded, size %llu (expected %zu)\n", block,
+                   (unsigned long long) loaded, (unsigned long long) size, ref.size());
+        nbSingle++;
+    }
+
+    const StallCounters &s = arrayStalls;
+    printf("=== SZxBlockHarness: %zu values, %zu blocks of %d, error bound %g ===\n", nbEle, nbBlocks, blockSize,
+           errorBound);
+    printf("Memory: latency %u cycles, %u requests in flight, %llu loads, %llu stores\n", latency, slots,
+           (unsigned long long) arrayLoads, (unsigned long long) arrayStores);
+    printf("Blocks: %zu constant, %zu compressed, %llu bytes of block data\n", nbConstant, nbBlocks - nbConstant,
+           (unsigned long long) total);
+    printf("Cycles: %llu, %.2f per block, %.3f per value\n", (unsigned long long) cycles, (double) cycles / nbBlocks,
+           (double) cycles / nbEle);
+    printf("Bytes per cycle: %.3f in, %.3f out\n", (double) nbEle * sizeof(float) / cycles, (double) total / cycles);
+    printf("Software kernel on the host: %.1f ns per block\n", swSeconds * 1e9 / nbBlocks);
+    printf("COMPRESS_MULTI: %zu blocks, %llu bytes, %llu cycles; LOAD_BLOCK and COMPRESS: %zu blocks\n",
+           multiBlocks.size(), (unsigned long long) multiTotal, (unsigned long long) multiCycles, nbSingle);
+    printf("Pipeline activity (share of the cycles):\n");
+    reportStall("processing", s.processing, cycles);
+    reportStall("loading", s.loading, cycles);
+    reportStall("stats", s.statsWait, cycles);
+    reportStall("input starved", s.inputStarved, cycles);
+    reportStall("load waits bank", s.bankWait, cycles);
+    reportStall("drain waits writer", s.drainWait, cycles);
+    reportStall("memory backpressure", s.memBackpressure, cycles);
+    printf("%s: %zu mismatching blocks\n", mismatches ? "FAIL" : "PASS", mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -2,6 +2,7 @@
 #include "szx.h"
 #include "rocc.h"
 #include "szx_rocc.h"
+#include "szx_trace.h"
 #include "test_data.h"
 #include <stdint.h>
 #include <stdlib.h> // Required for malloc and free
@@ -116,9 +117,12 @@ int main(void)
     g_use_hardware_acceleration = use_hardware;
 
     unsigned char* bytes;
+    szx_rocc_counters_t rocc_counters;
     if (use_hardware) {
         printf("Using RoCC hardware acceleration\n");
+        szx_read_counter(SZX_COUNTER_BUSY_CYCLES, 1); // the accelerator's counters restart from 0
         bytes = SZx_compress_float_rocc(data, &outSize, errBound, nbEle, blockSize); // Hardware
+        SZx_rocc_read_counters(&rocc_counters, 0);
     } else {
         // Use the flag-controlled software implementation
         printf("Using software SZx implementation\n");
@@ -165,6 +169,20 @@ int main(void)
     uint64_t num_blocks = (nbEle + blockSize - 1) / blockSize;
     uint64_t cycles_per_block = compression_cycles / num_blocks;
 
+    // With the accelerator its counters show where the cycles go; the L1 misses are not visible to it
+    profile_data_t profile = {0};
+    profile.total_cycles = total_cycles;
+    profile.total_instructions = total_instructions;
+    profile.block_processing_cycles = compression_cycles;
+    profile.memory_reads = mem_reads;
+    profile.memory_writes = mem_writes;
+    if (use_hardware) {
+        profile.block_processing_cycles = rocc_counters.events[SZX_COUNTER_PROCESSOR_CYCLES];
+        profile.memory_access_cycles = rocc_counters.events[SZX_COUNTER_MEM_STALL_CYCLES];
+        profile.memory_reads += rocc_counters.events[SZX_COUNTER_MEM_LOADS];
+        profile.memory_writes += rocc_counters.events[SZX_COUNTER_MEM_STORES];
+    }
+
     printf("=== Enhanced Performance Results ===\n");
     printf("Total cycles: %lu\n", total_cycles);
     printf("Total instructions: %lu\n", total_instructions);
@@ -180,11 +198,20 @@ int main(void)
     printf("Number of blocks: %lu\n", num_blocks);
     printf("Cycles per block: %lu\n", cycles_per_block);
     printf("\n=== Memory Access Patterns ===\n");
-    printf("Memory reads: %lu\n", mem_reads);
-    printf("Memory writes: %lu\n", mem_writes);
+    printf("Memory reads: %lu\n", profile.memory_reads);
+    printf("Memory writes: %lu\n", profile.memory_writes);
+    printf("Memory stall cycles: %lu\n", profile.memory_access_cycles);
+    printf("Block processing cycles: %lu\n", profile.block_processing_cycles);
     printf("Data loading percentage: %lu%%\n", (data_load_cycles * 100) / total_cycles);
     printf("Compression percentage: %lu%%\n", (compression_cycles * 100) / total_cycles);
 
+    if (use_hardware) {
+        printf("\n");
+        SZx_rocc_print_counters(stdout, &rocc_counters);
+    }
+
+    SZx_TRACE_DUMP(stdout);
+
     printf("\nCompression completed successfully!\n");
     free(data);
     free(bytes);
@@ -102,7 +102,42 @@
 #define SZX_COMPRESS_MULTI 3
 #define SZX_LOAD_DATA     4  // New command to load data to scratchpad
 #define SZX_GET_RESULT    5  // New command to get compressed result
-#define SZX_LOAD_BLOCK    6  // New command for bulk block loading
+#define SZX_LOAD_BLOCK    6  // Bulk block loading; returns the number of values loaded
+#define SZX_SET_OUTPUT    7  // Where COMPRESS_MULTI/COMPRESS_ARRAY write their blocks and their sizes
+#define SZX_SET_MEDIANS   8  // Where COMPRESS_ARRAY writes the medians of constant blocks
+#define SZX_COMPRESS_ARRAY 9 // Compress consecutive blocks, with the block stats computed by the accelerator
+#define SZX_SET_BLOCK     10 // Values per block of COMPRESS, COMPRESS_MULTI and COMPRESS_ARRAY; returns the size set
+#define SZX_READ_COUNTER  11 // Read (and clear) the accelerator's performance counters
+
+// Performance counters of SZX_READ_COUNTER (SZxAcceleratorCore.counterEvents, stateCounters, loadStateCounters)
+#define SZX_COUNTER_BUSY_CYCLES       0
+#define SZX_COUNTER_MEM_STALL_CYCLES  1  // a memory request waits for the L1 data cache
+#define SZX_COUNTER_MEM_LOADS         2
+#define SZX_COUNTER_MEM_STORES        3
+#define SZX_COUNTER_BLOCKS            4
+#define SZX_COUNTER_CONSTANT_BLOCKS   5
+#define SZX_COUNTER_BYTES_IN          6  // bytes of values loaded
+#define SZX_COUNTER_BYTES_OUT         7  // bytes of compressed blocks produced
+#define SZX_COUNTER_PROCESSOR_CYCLES  8  // the block processor holds a block
+#define SZX_COUNTER_LOADER_CYCLES     9  // a loader has loads to issue or in flight
+#define SZX_COUNTER_WRITER_CYCLES     10
+#define SZX_COUNTER_EVENTS            11
+#define SZX_COUNTER_STATE(s)          (16 + (s)) // cycles in state s of the command state machine
+#define SZX_COUNTER_STATES            11
+#define SZX_COUNTER_LOAD_STATE(s)     (32 + (s)) // cycles in state s of the COMPRESS_MULTI/COMPRESS_ARRAY load
+                                                 // stage, summed over its load units (one per block processor)
+#define SZX_COUNTER_LOAD_STATES       6
+
+// Largest block of the default accelerator (SZxRoCCAccelerator.maxBlockSize); a configuration with smaller
+// scratchpads clamps larger sizes, which szx_set_block_size and szx_load_block_bulk report
+#define SZX_ROCC_MAX_BLOCK_SIZE 1024
+
+// One block of a SZX_COMPRESS_MULTI batch (SZxAcceleratorCore.descriptorBytes)
+typedef struct {
+    uint64_t data;      // address of the block's first value
+    float medianValue;
+    float radius;
+} szx_rocc_desc_t;
 
 // Helper functions for SZx RoCC operations
 static inline void szx_config(float error_bound, float median_value) {
@@ -123,9 +158,13 @@ static inline void szx_load_data(uint32_t data_value, uint32_t index) {
     ROCC_INSTRUCTION_I_R_R(0, 0, data_value, index, SZX_LOAD_DATA, 10, 11);
 }
 
-// New function for bulk block loading
-static inline void szx_load_block_bulk(uint32_t block_start_addr, uint32_t block_size) {
-    ROCC_INSTRUCTION_I_R_R(0, 0, block_start_addr, block_size, SZX_LOAD_BLOCK, 10, 11);
+// Load block_size values from data into the scratchpad; the full 64-bit address goes to rs1.
+// Returns the number of values loaded, less than block_size if the block does not fit the scratchpad
+static inline uint32_t szx_load_block_bulk(const float* data, uint32_t block_size) {
+    uint64_t data_addr = (uint64_t)data;
+    uint64_t loaded;
+    ROCC_INSTRUCTION_DSS(0, loaded, data_addr, block_size, SZX_LOAD_BLOCK);
+    return (uint32_t)loaded;
 }
 
 // New function to get compressed result
@@ -143,11 +182,52 @@ static inline uint32_t szx_compress(float* input_data, uint8_t* output_data) {
     return compressed_size;
 }
 
-static inline uint32_t szx_compress_multi(float* input_data, uint8_t* output_data) {
-    uint64_t input_addr = (uint64_t)input_data;
-    uint64_t output_addr = (uint64_t)output_data;
-    uint32_t compressed_size;
-    ROCC_INSTRUCTION_DSS(0, compressed_size, input_addr, output_addr, SZX_COMPRESS_MULTI);
+// COMPRESS_MULTI writes its blocks back to back from output and the size of block i to sizes[i]
+static inline void szx_set_output(uint8_t* output, uint16_t* sizes) {
+    uint64_t output_addr = (uint64_t)output;
+    uint64_t sizes_addr = (uint64_t)sizes;
+    ROCC_INSTRUCTION_SS(0, output_addr, sizes_addr, SZX_SET_OUTPUT);
+}
+
+// Compress count blocks described by table back to back (the error bound comes from szx_config);
+// returns the total compressed size of the batch
+static inline uint64_t szx_compress_multi(const szx_rocc_desc_t* table, uint64_t count) {
+    uint64_t table_addr = (uint64_t)table;
+    uint64_t compressed_size;
+    ROCC_INSTRUCTION_DSS(0, compressed_size, table_addr, count, SZX_COMPRESS_MULTI);
+    return compressed_size;
+}
+
+// Block size (1 to the accelerator's maxBlockSize values) of the following commands; LOAD_BLOCK sets the size of
+// the block COMPRESS compresses, up to the next szx_set_block_size. Returns the size the accelerator applied,
+// which differs from block_size when that is out of range
+static inline uint32_t szx_set_block_size(uint32_t block_size) {
+    uint64_t applied;
+    ROCC_INSTRUCTION_DSS(0, applied, block_size, 0, SZX_SET_BLOCK);
+    return (uint32_t)applied;
+}
+
+// Value of counter index (SZX_COUNTER_*); with clear set all counters restart from 0 after the read
+static inline uint64_t szx_read_counter(uint32_t index, int clear) {
+    uint64_t value;
+    uint64_t clear_all = clear ? 1 : 0;
+    ROCC_INSTRUCTION_DSS(0, value, index, clear_all, SZX_READ_COUNTER);
+    return value;
+}
+
+// COMPRESS_ARRAY writes the median of constant block i to medians[i]
+static inline void szx_set_medians(float* medians) {
+    uint64_t medians_addr = (uint64_t)medians;
+    ROCC_INSTRUCTION_SS(0, medians_addr, 0, SZX_SET_MEDIANS);
+}
+
+// Compress the count values starting at data in blocks of the szx_set_block_size size, the last one possibly
+// shorter; the accelerator decides which blocks are constant: their size is 0 and their median goes to the
+// szx_set_medians array. Returns the total data size
+static inline uint64_t szx_compress_array(const float* data, uint64_t count) {
+    uint64_t data_addr = (uint64_t)data;
+    uint64_t compressed_size;
+    ROCC_INSTRUCTION_DSS(0, compressed_size, data_addr, count, SZX_COMPRESS_ARRAY);
     return compressed_size;
 }
 
@@ -1,5 +1,24 @@
+#ifndef _SZX_H
+#define _SZX_H
+
 #include "utility.h"
 
+/*growable scratch buffer owned by an SZx_context*/
+typedef struct SZx_arena {
+    unsigned char *buffer;
+    size_t capacity;
+} SZx_arena;
+
+/*reusable compressor state: every buffer SZx_compress_float_ctx needs is kept here and grown on demand,
+ *so repeated calls with the same or smaller sizes do not allocate*/
+typedef struct SZx_context {
+    SZx_arena scratch;       //leading numbers of the serial path
+    SZx_arena output;        //output when the caller's buffer is missing or smaller than the worst case
+    SZx_arena threadInfo;    //per-thread block counts and offsets of the block-parallel path
+    SZx_arena *threadArenas; //private block buffers of each thread of the block-parallel path
+    int nbThreadArenas;
+} SZx_context;
+
 void floatToBytes(unsigned char *b, float num);
 void sizeToBytes(unsigned char* outBytes, size_t size);
 void computeReqLength_float(double realPrecision, short radExpo, int *reqLength, float *medianValue);
@@ -10,7 +29,15 @@ size_t bytesToSize(unsigned char* bytes);
 void sizeToBytes(unsigned char* outBytes, size_t size);
 long bytesToLong_bigEndian(unsigned char* b);
 float bytesToFloat(unsigned char* bytes);
+void doubleToBytes(unsigned char *b, double num);
+double bytesToDouble(unsigned char* bytes);
+short getExponent_double(double value);
+void computeReqLength_double(double realPrecision, short radExpo, int *reqLength, double *medianValue);
 
+unsigned char computeBlockStateMedianRadius_float(float *op, size_t n, float absErrBound,
+                                                  float *medianValue, float *radius);
+unsigned char computeBlockStateMedianRadius_double(double *op, size_t n, double absErrBound,
+                                                   double *medianValue, double *radius);
 size_t computeStateMedianRadius_float(float *oriData, size_t nbEle, float absErrBound, int blockSize,
                                       unsigned char *stateArray, float *medianArray, float *radiusArray);
 
@@ -25,8 +52,46 @@ void SZx_compress_one_block_float(float *oriData, size_t nbEle, float absErrBoun
                                                                 unsigned char *outputBytes, int *outSize,
                                                                 unsigned char *leadNumberArray_int, float medianValue,
                                                                 float radius);
+void SZx_compress_one_block_float_sw(float *oriData, size_t nbEle, float absErrBound,
+                                     unsigned char *outputBytes, int *outSize,
+                                     unsigned char *leadNumberArray_int, float medianValue,
+                                     float radius);
 
 int SZx_decompress_one_block_float(float* newData, size_t blockSize, unsigned char* cmpBytes);
 
+size_t SZx_maxBlockBytes(int blockSize, size_t valueBytes);
+int SZx_validBlockSize(int blockSize, size_t valueBytes);
+size_t SZx_maxCompressedSize_float(size_t nbEle, int blockSize);
 unsigned char *SZx_compress_float(float *oriData, size_t *outSize, float absErrBound, size_t nbEle, int blockSize);
+unsigned char *SZx_compress_float_openmp(float *oriData, size_t *outSize, float absErrBound, size_t nbEle, int blockSize,
+                                         int nbThreads);
+unsigned char *SZx_reserve_arena(SZx_arena *arena, size_t size);
+void SZx_init_context(SZx_context *ctx);
+void SZx_free_context(SZx_context *ctx);
+unsigned char *SZx_compress_float_ctx(SZx_context *ctx, float *oriData, size_t *outSize, float absErrBound,
+                                      size_t nbEle, int blockSize, int nbThreads,
+                                      unsigned char *outputBytes, size_t outCapacity);
 void SZx_decompress_float(float** newData, size_t nbEle, unsigned char* cmpBytes);
+void SZx_decompress_float_openmp(float** newData, size_t nbEle, unsigned char* cmpBytes, int nbThreads);
+int SZx_decompress_float_blocks(float* newData, size_t nbEle, unsigned char* cmpBytes,
+                                size_t startBlock, size_t endBlock);
+
+void SZx_compress_one_block_double_sw(double *oriData, size_t nbEle, double absErrBound,
+                                      unsigned char *outputBytes, int *outSize,
+                                      unsigned char *leadNumberArray_int, double medianValue,
+                                      double radius);
+int SZx_decompress_one_block_double(double* newData, size_t blockSize, unsigned char* cmpBytes);
+
+size_t SZx_maxCompressedSize_double(size_t nbEle, int blockSize);
+unsigned char *SZx_compress_double(double *oriData, size_t *outSize, double absErrBound, size_t nbEle, int blockSize);
+unsigned char *SZx_compress_double_openmp(double *oriData, size_t *outSize, double absErrBound, size_t nbEle,
+                                          int blockSize, int nbThreads);
+unsigned char *SZx_compress_double_ctx(SZx_context *ctx, double *oriData, size_t *outSize, double absErrBound,
+                                       size_t nbEle, int blockSize, int nbThreads,
+                                       unsigned char *outputBytes, size_t outCapacity);
+void SZx_decompress_double(double** newData, size_t nbEle, unsigned char* cmpBytes);
+void SZx_decompress_double_openmp(double** newData, size_t nbEle, unsigned char* cmpBytes, int nbThreads);
+int SZx_decompress_double_blocks(double* newData, size_t nbEle, unsigned char* cmpBytes,
+                                 size_t startBlock, size_t endBlock);
+
+#endif /* ----- #ifndef _SZX_H  ----- */
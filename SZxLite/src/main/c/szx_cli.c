@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "szx.h"
+#include "szx_simd.h"
+#include "szx_timer.h"
+#include "szx_trace.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * Host driver for SZxLite: compresses / decompresses raw little-endian float32 (or, with -d,
+ * float64) files with the block-parallel software path and reports per-phase timing.
+ *
+ *   szx_cli -z -i data.f32 [-o data.szx]                  compress
+ *   szx_cli -x -i data.szx -n nbEle [-o out.f32] [-r data.f32]   decompress
+ *   szx_cli -z -x -i data.f32 [-o out.f32]                round trip in memory
+ */
+
+/*largest block whose compressed size fits the 16-bit sizes of the stream*/
+static int maxBlockSize(size_t valueBytes)
+{
+    int blockSize = 1;
+    while (SZx_validBlockSize(blockSize + 1, valueBytes))
+        blockSize++;
+    return blockSize;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-z] [-x] -i <input> [options]\n", prog);
+    printf("  -z            compress the raw float32 input\n");
+    printf("  -x            decompress (with -z: decompress the result of -z in memory)\n");
+    printf("  -i <file>     input file (raw float32 for -z, SZx stream for -x alone)\n");
+    printf("  -o <file>     output file of the last stage (SZx stream or raw float32)\n");
+    printf("  -n <nbEle>    number of values (required for -x alone, SZx streams do not store it)\n");
+    printf("  -r <file>     original raw float32 data, to report the error of -x alone\n");
+    printf("  -e <bound>    absolute error bound (default 1e-3)\n");
+    printf("  -b <size>     block size (default 64; at most %d float32 or %d float64 values)\n",
+           maxBlockSize(sizeof(float)), maxBlockSize(sizeof(double)));
+    printf("  -t <threads>  number of threads (default: all available)\n");
+    printf("  -s <level>    highest SIMD kernel: scalar, neon, avx2, avx512 (default: detected)\n");
+    printf("  -d            the raw data is float64 instead of float32\n");
+    printf("  -M            read input with fread instead of mmap\n");
+}
+
+typedef struct {
+    const char *name;
+    double seconds;
+    uint64_t cycles;
+    size_t bytes; //bytes of original data the phase processed, for the throughput column; 0 = none
+} phase_t;
+
+static void report(const phase_t *p)
+{
+    printf("%-11s %10.6f s", p->name, p->seconds);
+    if (p->bytes > 0 && p->seconds > 0)
+        printf("  %8.3f GB/s", p->bytes / p->seconds / 1e9);
+    if (p->cycles > 0)
+        printf("  %14llu cycles", (unsigned long long) p->cycles);
+    printf("\n");
+}
+
+static unsigned char *loadInput(char *path, size_t *byteLength, int useMmap, int *status)
+{
+    return useMmap ? mapByteData(path, byteLength, 1, status) : readByteData(path, byteLength, status);
+}
+
+static void releaseInput(unsigned char *bytes, size_t byteLength, int useMmap)
+{
+    if (useMmap)
+        unmapData(bytes, byteLength);
+    else
+        free(bytes);
+}
+
+static double maxAbsError(const void *ori, const void *dec, size_t nbEle, int useDouble)
+{
+    double maxErr = 0;
+    size_t i;
+    for (i = 0; i < nbEle; i++) {
+        double err = useDouble ? fabs(((const double *) ori)[i] - ((const double *) dec)[i])
+                               : fabs((double) ((const float *) ori)[i] - ((const float *) dec)[i]);
+        if (err > maxErr || err != err)
+            maxErr = err;
+    }
+    return maxErr;
+}
+
+int main(int argc, char *argv[])
+{
+    int doCompress = 0, doDecompress = 0, useDouble = 0, useMmap = 1;
+    char *inPath = NULL, *outPath = NULL, *refPath = NULL;
+    size_t nbEle = 0;
+    double errBound = 1E-3;
+    int blockSize = 64, nbThreads = 0, simdLevel = SZx_simd_detect();
+    int opt, status;
+
+    while ((opt = getopt(argc, argv, "zxi:o:n:r:e:b:t:s:dMh")) != -1) {
+        switch (opt) {
+        case 'z': doCompress = 1; break;
+        case 'x': doDecompress = 1; break;
+        case 'i': inPath = optarg; break;
+        case 'o': outPath = optarg; break;
+        case 'n': nbEle = strtoull(optarg, NULL, 10); break;
+        case 'r': refPath = optarg; break;
+        case 'e': errBound = strtod(optarg, NULL); break;
+        case 'b': blockSize = atoi(optarg); break;
+        case 't': nbThreads = atoi(optarg); break;
+        case 's':
+            for (simdLevel = SZx_SIMD_AVX512; simdLevel >= SZx_SIMD_NONE; simdLevel--)
+                if (strcmp(optarg, SZx_simd_name(simdLevel)) == 0)
+                    break;
+            if (simdLevel < SZx_SIMD_NONE) {
+                printf("Error: unknown SIMD level %s; use scalar, neon, avx2 or avx512\n", optarg);
+                return 1;
+            }
+            break;
+        case 'd': useDouble = 1; break;
+        case 'M': useMmap = 0; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if ((!doCompress && !doDecompress) || inPath == NULL || blockSize <= 0 || !(errBound > 0)
+        || (doDecompress && !doCompress && nbEle == 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    SZx_set_simd_level(simdLevel);
+    size_t valueBytes = useDouble ? sizeof(double) : sizeof(float);
+    if (doCompress && !SZx_validBlockSize(blockSize, valueBytes)) {
+        printf("Error: a block of %d values can compress to more than %d bytes; the largest %s block size is %d\n",
+               blockSize, UINT16_MAX, useDouble ? "float64" : "float32", maxBlockSize(valueBytes));
+        return 1;
+    }
+#ifdef _OPENMP
+    if (nbThreads <= 0)
+        nbThreads = omp_get_max_threads();
+#else
+    nbThreads = 1;
+#endif
+
+    phase_t phases[5];
+    int nbPhases = 0;
+    double t;
+    uint64_t c;
+
+    size_t inLength = 0;
+    t = SZx_wtime(); c = SZx_cycles();
+    unsigned char *in = loadInput(inPath, &inLength, useMmap, &status);
+    if (status != SZx_SCES)
+        return 1;
+    phases[nbPhases++] = (phase_t) {"read", SZx_wtime() - t, SZx_cycles() - c, 0};
+
+    void *oriData = NULL;
+    unsigned char *cmpBytes = in;
+    size_t cmpSize = inLength;
+    if (doCompress) {
+        oriData = in;
+        nbEle = inLength / valueBytes;
+        t = SZx_wtime(); c = SZx_cycles();
+        if (useDouble)
+            cmpBytes = SZx_compress_double_openmp((double *) oriData, &cmpSize, errBound, nbEle, blockSize, nbThreads);
+        else
+            cmpBytes = SZx_compress_float_openmp((float *) oriData, &cmpSize, errBound, nbEle, blockSize, nbThreads);
+        phases[nbPhases++] = (phase_t) {"compress", SZx_wtime() - t, SZx_cycles() - c, nbEle * valueBytes};
+        if (cmpBytes == NULL) {
+            printf("Error: cannot compress %s\n", inPath);
+            return 1;
+        }
+    }
+
+    void *decData = NULL;
+    if (doDecompress) {
+        t = SZx_wtime(); c = SZx_cycles();
+        if (useDouble)
+            SZx_decompress_double_openmp((double **) &decData, nbEle, cmpBytes, nbThreads);
+        else
+            SZx_decompress_float_openmp((float **) &decData, nbEle, cmpBytes, nbThreads);
+        phases[nbPhases++] = (phase_t) {"decompress", SZx_wtime() - t, SZx_cycles() - c, nbEle * valueBytes};
+        if (decData == NULL) {
+            printf("Error: %s is not an SZx stream\n", inPath);
+            return 1;
+        }
+    }
+
+    if (outPath != NULL) {
+        t = SZx_wtime(); c = SZx_cycles();
+        if (doDecompress)
+            writeByteData((unsigned char *) decData, nbEle * valueBytes, outPath, &status);
+        else
+            writeByteData(cmpBytes, cmpSize, outPath, &status);
+        phases[nbPhases++] = (phase_t) {"write", SZx_wtime() - t, SZx_cycles() - c, 0};
+        if (status != SZx_SCES)
+            return 1;
+    }
+
+    //the original data is in memory after -z; -x alone compares against -r if given
+    size_t refLength = 0;
+    unsigned char *ref = NULL;
+    if (doDecompress && !doCompress && refPath != NULL) {
+        ref = loadInput(refPath, &refLength, useMmap, &status);
+        if (status == SZx_SCES && refLength >= nbEle * valueBytes)
+            oriData = ref;
+    }
+
+    //-b and -e only apply to compression; -x alone takes the block size from the stream
+    printf("SZx %s: %s, %zu %s values, ",
+           doCompress && doDecompress ? "round trip" : doCompress ? "compress" : "decompress", inPath, nbEle, useDouble ? "float64" : "float32");
+    if (doCompress)
+        printf("block size %d, error bound %g, ", blockSize, errBound);
+    printf("%d thread(s), %s kernels\n", nbThreads, SZx_simd_name(SZx_simd_level()));
+    int i;
+    for (i = 0; i < nbPhases; i++)
+        report(&phases[i]);
+    printf("compressed size     = %zu bytes\n", cmpSize);
+    printf("compression ratio   = %f\n", cmpSize > 0 ? (double) nbEle * valueBytes / cmpSize : 0.0);
+    if (decData != NULL && oriData != NULL) {
+        double maxErr = maxAbsError(oriData, decData, nbEle, useDouble);
+        printf("max absolute error  = %g (%s)\n", maxErr, maxErr <= (useDouble ? errBound : (float) errBound) ? "within bound" : "EXCEEDS BOUND");
+    }
+    SZx_TRACE_DUMP(stdout);
+
+    if (ref != NULL)
+        releaseInput(ref, refLength, useMmap);
+    free(decData);
+    if (doCompress)
+        free(cmpBytes);
+    releaseInput(in, inLength, useMmap);
+    return 0;
+}
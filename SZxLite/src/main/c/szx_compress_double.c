@@ -0,0 +1,398 @@
+#include "define.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "szx.h"
+#include "szx_simd.h"
+#include "szx_trace.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * Double-precision counterpart of the software path in szx_compress_hw.c. The stream layout is the same
+ * (header, O[], state array, constant medians, non-constant blocks) with 8-byte medians, and a block is
+ * [reqLength][median (8 bytes)][2-bit leading numbers][residual bytes]. The leading numbers count the
+ * identical top bytes (at most 3) of the 64-bit XOR with the previous element.
+ */
+
+inline void doubleToBytes(unsigned char *b, double num)
+{
+        ldouble buf;
+        buf.value = num;
+        memcpy(b, buf.byte, 8);
+}
+
+inline short getExponent_double(double value)
+{
+        ldouble lbuf;
+        lbuf.value = value;
+        long lvalue = lbuf.lvalue;
+
+        int expValue = (int)((lvalue & 0x7FF0000000000000) >> 52);
+        expValue -= 1023;
+        return (short)expValue;
+}
+
+/*Compute the number of significant bits based on the user-required error bound (realPrecision)*/
+inline void computeReqLength_double(double realPrecision, short radExpo, int *reqLength, double *medianValue) {
+    short reqExpo = getPrecisionReqLength_double(realPrecision);
+    *reqLength = 12 + radExpo - reqExpo + 1; //radExpo-reqExpo == reqMantiLength
+    if (*reqLength < 12)
+        *reqLength = 12;
+    if (*reqLength > 64)
+    {
+        *reqLength = 64;
+        *medianValue = 0;
+    }
+}
+
+/*compute value range and mean of one block, return its state (0: constant block, 1: non-constant block)*/
+inline unsigned char computeBlockStateMedianRadius_double(double *op, size_t n, double absErrBound,
+                                                          double *medianValue, double *radius) {
+    size_t j = 0;
+    double min = op[0];
+    double max = op[0];
+    for (j = 1; j < n; j++) {
+        double v = op[j];
+        if (min > v)
+            min = v;
+        else if (max < v)
+            max = v;
+    }
+    double valueRange = max - min;
+    *radius = valueRange / 2;
+    *medianValue = min + *radius;
+    return *radius <= absErrBound ? 0 : 1;
+}
+
+inline void SZx_compress_one_block_double_sw(double *oriData, size_t nbEle, double absErrBound,
+                                            unsigned char *outputBytes, int *outSize,
+                                            unsigned char *leadNumberArray_int, double medianValue,
+                                            double radius) {
+    size_t i = 0;
+    int reqLength;
+
+    short radExpo = getExponent_double(radius);
+    computeReqLength_double(absErrBound, radExpo, &reqLength, &medianValue);
+
+    int reqBytesLength = reqLength / 8;
+    int resiBitsLength = reqLength % 8;
+    int rightShiftBits = 0;
+
+    size_t leadNumberArray_size = nbEle % 4 == 0 ? nbEle / 4 : nbEle / 4 + 1;
+
+    ldouble ldBuf_pre;
+    ldouble ldBuf_cur;
+
+    unsigned char *leadNumberArray = outputBytes + 1 + sizeof(double);
+    unsigned char *exactMidbyteArray = leadNumberArray + leadNumberArray_size;
+
+    if (resiBitsLength != 0) {
+        rightShiftBits = 8 - resiBitsLength;
+        reqBytesLength++;
+    }
+
+    unsigned char leadingNum = 0;
+    size_t residualMidBytes_size = 0;
+    int k, lowByte = 8 - reqBytesLength;
+
+    //the vector kernels handle as many elements as they can; the loop below finishes the tail
+    uint64_t preValue = 0;
+    i = SZx_compress_xor_double_simd(oriData, nbEle, medianValue, rightShiftBits, reqBytesLength, &preValue,
+                                     leadNumberArray_int, exactMidbyteArray, &residualMidBytes_size);
+    ldBuf_pre.lvalue = preValue;
+
+    for (; i < nbEle; i++) {
+        leadingNum = 0;
+        ldBuf_cur.value = oriData[i] - medianValue;
+
+        ldBuf_cur.lvalue = ldBuf_cur.lvalue >> rightShiftBits;
+
+        ldBuf_pre.lvalue = ldBuf_cur.lvalue ^ ldBuf_pre.lvalue;
+
+        if (ldBuf_pre.lvalue >> 40 == 0)
+            leadingNum = 3;
+        else if (ldBuf_pre.lvalue >> 48 == 0)
+            leadingNum = 2;
+        else if (ldBuf_pre.lvalue >> 56 == 0)
+            leadingNum = 1;
+
+        leadNumberArray_int[i] = leadingNum;
+
+        //the non-leading bytes among the top reqBytesLength ones, lowest first
+        for (k = lowByte; k < 8 - leadingNum; k++)
+            exactMidbyteArray[residualMidBytes_size++] = ldBuf_cur.byte[k];
+
+        ldBuf_pre = ldBuf_cur;
+    }
+
+    convertIntArray2ByteArray_fast_2b_args(leadNumberArray_int, nbEle, leadNumberArray);
+
+    outputBytes[0] = (unsigned char) reqLength;
+    doubleToBytes(&(outputBytes[1]), medianValue);
+
+    *outSize = 1 + sizeof(double) + leadNumberArray_size + residualMidBytes_size;
+}
+
+/*worst-case size of an SZx_compress_double stream*/
+size_t SZx_maxCompressedSize_double(size_t nbEle, int blockSize)
+{
+    size_t actualNBBlocks = (nbEle + blockSize - 1) / blockSize;
+    size_t stateNBBytes = (actualNBBlocks + 7) / 8;
+    size_t maxBlockHeader = 1 + sizeof(double) + (blockSize + 3) / 4;
+    return 4 + 2 * sizeof(size_t) + stateNBBytes +
+           actualNBBlocks * (sizeof(uint16_t) + sizeof(double) + maxBlockHeader) + sizeof(double) * nbEle;
+}
+
+/*serial compression into outputBytes, which must hold SZx_maxCompressedSize_double(nbEle, blockSize) bytes;
+ *returns the compressed size. Same single pass and staging as compressFloatInto.*/
+static size_t compressDoubleInto(double *oriData, double absErrBound, size_t nbEle, int blockSize,
+                                 unsigned char *outputBytes, unsigned char *leadNumberArray_int) {
+    double *op = oriData;
+    size_t i = 0;
+    int oSize = 0;
+
+    size_t nbBlocks = nbEle / blockSize;
+    size_t remainCount = nbEle % blockSize;
+    size_t actualNBBlocks = remainCount == 0 ? nbBlocks : nbBlocks + 1;
+
+    size_t stateNBBytes = (actualNBBlocks % 8 == 0 ? actualNBBlocks / 8 : actualNBBlocks / 8 + 1);
+
+    unsigned char *r = outputBytes + 4 + 2 * sizeof(size_t); //r is the starting address of 'block-size array'
+    uint16_t *O = (uint16_t*)r;
+    unsigned char *S = r + actualNBBlocks * sizeof(uint16_t); //staged state array
+    unsigned char *M = S + stateNBBytes; //staged constant median values
+    unsigned char *Q = M + sizeof(double) * actualNBBlocks; //staged non-constant data blocks
+    unsigned char *p = M;
+    unsigned char *q = Q;
+    memset(S, 0, stateNBBytes);
+
+    size_t nonConstantBlockID = 0, nbConstantBlocks = 0;
+
+    for (i = 0; i < actualNBBlocks; i++, op += blockSize) {
+        SZx_TRACE_START(blockCycles);
+        size_t n = i < nbBlocks ? (size_t) blockSize : remainCount;
+        double medianValue, radius;
+        unsigned char state = computeBlockStateMedianRadius_double(op, n, absErrBound, &medianValue, &radius);
+
+        if (state) {
+            SZx_compress_one_block_double_sw(op, n, absErrBound, q, &oSize,
+                                             leadNumberArray_int, medianValue, radius);
+            SZx_TRACE_BLOCK(i, SZx_TRACE_SW, state, q[0], oSize, blockCycles);
+            q += oSize;
+            O[nonConstantBlockID++] = oSize;
+            S[i >> 3] |= 1 << (7 - (i & 7));
+        } else {
+            SZx_TRACE_BLOCK(i, SZx_TRACE_SW, state, 0, sizeof(double), blockCycles);
+            doubleToBytes(p, medianValue);
+            p += sizeof(double);
+            nbConstantBlocks++;
+        }
+    }
+
+    size_t nbNonConstantBlocks = actualNBBlocks - nbConstantBlocks;
+
+    unsigned char *h = outputBytes;
+    h[0] = SZx_VER_MAJOR;
+    h[1] = SZx_VER_MINOR;
+    h[2] = 1;
+    h[3] = 1; //support random access decompression
+    h = h + 4;
+
+    sizeToBytes(h, blockSize);
+    h += sizeof(size_t);
+    sizeToBytes(h, nbConstantBlocks);
+
+    unsigned char *R = r + nbNonConstantBlocks*sizeof(uint16_t); //R is the starting address of the state array
+    unsigned char *P = R + stateNBBytes; //P is the starting address of constant median values.
+    unsigned char *D = P + sizeof(double) * nbConstantBlocks; //D is the starting address of the non-constant data sblocks
+    memmove(R, S, stateNBBytes);
+    memmove(P, M, p - M);
+    memmove(D, Q, q - Q);
+    return (D - outputBytes) + (q - Q);
+}
+
+unsigned char *
+SZx_compress_double(double *oriData, size_t *outSize, double absErrBound,
+    size_t nbEle, int blockSize) {
+    *outSize = 0;
+    if (!SZx_validBlockSize(blockSize, sizeof(double)))
+        return NULL;
+    unsigned char *outputBytes = (unsigned char *) malloc(SZx_maxCompressedSize_double(nbEle, blockSize));
+    unsigned char *leadNumberArray_int = (unsigned char *) malloc(blockSize * sizeof(int));
+
+    *outSize = compressDoubleInto(oriData, absErrBound, nbEle, blockSize, outputBytes, leadNumberArray_int);
+
+    free(leadNumberArray_int);
+    return outputBytes;
+}
+
+/*block-parallel version of SZx_compress_double, organized as compressFloatInto_openmp;
+ *the output is byte-identical to SZx_compress_double*/
+static size_t compressDoubleInto_openmp(SZx_context *ctx, double *oriData, double absErrBound,
+    size_t nbEle, int blockSize, int nbThreads, unsigned char *outputBytes) {
+#ifdef _OPENMP
+    if (nbThreads <= 0)
+        nbThreads = omp_get_max_threads();
+#else
+    nbThreads = 1;
+#endif
+
+    size_t outSize = 0;
+
+    size_t nbBlocks = nbEle / blockSize;
+    size_t remainCount = nbEle % blockSize;
+    size_t actualNBBlocks = remainCount == 0 ? nbBlocks : nbBlocks + 1;
+
+    size_t stateNBBytes = (actualNBBlocks % 8 == 0 ? actualNBBlocks / 8 : actualNBBlocks / 8 + 1);
+    //reqLength(1) + median(8) + 2-bit leading numbers + at most 8 residual bytes per element
+    size_t maxBlockBytes = 1 + sizeof(double) + (blockSize + 3) / 4 + sizeof(double) * blockSize;
+
+    if (ctx->nbThreadArenas < nbThreads) {
+        ctx->threadArenas = (SZx_arena *) realloc(ctx->threadArenas, nbThreads * sizeof(SZx_arena));
+        memset(ctx->threadArenas + ctx->nbThreadArenas, 0, (nbThreads - ctx->nbThreadArenas) * sizeof(SZx_arena));
+        ctx->nbThreadArenas = nbThreads;
+    }
+    size_t *threadInfo = (size_t *) SZx_reserve_arena(&ctx->threadInfo, 4 * nbThreads * sizeof(size_t));
+    size_t *threadNCBlocks = threadInfo; //non-constant blocks in each thread's range
+    size_t *threadNCStart = threadInfo + nbThreads; //exclusive prefix sum of threadNCBlocks
+    size_t *threadSize = threadInfo + 2 * nbThreads; //sum of O[] over each thread's range
+    size_t *threadOffset = threadInfo + 3 * nbThreads; //where each thread's blocks start in q
+
+    size_t nbConstantBlocks = 0, nbNonConstantBlocks = 0;
+    uint16_t *O = NULL;
+    unsigned char *R = NULL, *p = NULL, *q = NULL;
+
+#pragma omp parallel num_threads(nbThreads)
+    {
+        int tid = 0;
+        int nbT = 1; //the granted team, as in compressFloatInto_openmp
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        nbT = omp_get_num_threads();
+#endif
+        size_t lo = (actualNBBlocks * tid / nbT) & ~(size_t) 7;
+        size_t hi = tid == nbT - 1 ? actualNBBlocks : (actualNBBlocks * (tid + 1) / nbT) & ~(size_t) 7;
+        size_t i, nbNC = 0, nbC = 0;
+        int oSize = 0;
+
+        //medians first and O[] next keep both aligned within the arena
+        size_t nbLocal = hi - lo + 1;
+        size_t mediansSize = nbLocal * sizeof(double), localOSize = nbLocal * sizeof(uint16_t);
+        size_t bytesSize = (hi - lo) * maxBlockBytes + 1;
+        unsigned char *arena = SZx_reserve_arena(&ctx->threadArenas[tid],
+                                                 mediansSize + localOSize + bytesSize + nbLocal + blockSize * sizeof(int));
+        double *localMedians = (double *) arena;
+        uint16_t *localO = (uint16_t *) (arena + mediansSize);
+        unsigned char *localBytes = arena + mediansSize + localOSize;
+        unsigned char *localStates = localBytes + bytesSize;
+        unsigned char *leadNumberArray_int = localStates + nbLocal;
+        unsigned char *lq = localBytes;
+
+        for (i = lo; i < hi; i++) {
+            SZx_TRACE_START(blockCycles);
+            size_t n = i < nbBlocks ? (size_t) blockSize : remainCount;
+            double medianValue, radius;
+            localStates[i - lo] = computeBlockStateMedianRadius_double(oriData + i * blockSize, n, absErrBound,
+                                                                       &medianValue, &radius);
+            if (localStates[i - lo]) {
+                SZx_compress_one_block_double_sw(oriData + i * blockSize, n, absErrBound, lq, &oSize,
+                                                 leadNumberArray_int, medianValue, radius);
+                SZx_TRACE_BLOCK(i, SZx_TRACE_SW, 1, lq[0], oSize, blockCycles);
+                lq += oSize;
+                localO[nbNC++] = oSize;
+            } else {
+                SZx_TRACE_BLOCK(i, SZx_TRACE_SW, 0, 0, sizeof(double), blockCycles);
+                localMedians[nbC++] = medianValue;
+            }
+        }
+        threadNCBlocks[tid] = nbNC;
+        threadSize[tid] = lq - localBytes;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            int t;
+            size_t offset = 0;
+            for (t = 0; t < nbT; t++) {
+                threadNCStart[t] = nbNonConstantBlocks;
+                nbNonConstantBlocks += threadNCBlocks[t];
+                threadOffset[t] = offset;
+                offset += threadSize[t];
+            }
+            nbConstantBlocks = actualNBBlocks - nbNonConstantBlocks;
+
+            unsigned char *r = outputBytes;
+            r[0] = SZx_VER_MAJOR;
+            r[1] = SZx_VER_MINOR;
+            r[2] = 1;
+            r[3] = 1; //support random access decompression
+            r = r + 4;
+
+            sizeToBytes(r, blockSize);
+            r += sizeof(size_t);
+            sizeToBytes(r, nbConstantBlocks);
+            r += sizeof(size_t);
+            O = (uint16_t *) r;
+            R = r + nbNonConstantBlocks * sizeof(uint16_t);
+            p = R + stateNBBytes;
+            q = p + sizeof(double) * nbConstantBlocks;
+            outSize = (q - outputBytes) + offset;
+        }
+
+        unsigned char *lp = p + sizeof(double) * (lo - threadNCStart[tid]); //constant blocks before lo
+        for (i = 0; i < nbC; i++, lp += sizeof(double))
+            doubleToBytes(lp, localMedians[i]);
+        memcpy(O + threadNCStart[tid], localO, nbNC * sizeof(uint16_t));
+        convertIntArray2ByteArray_fast_1b_args(localStates, hi - lo, R + lo / 8);
+        memcpy(q + threadOffset[tid], localBytes, threadSize[tid]);
+    }
+
+    return outSize;
+}
+
+unsigned char *
+SZx_compress_double_openmp(double *oriData, size_t *outSize, double absErrBound,
+    size_t nbEle, int blockSize, int nbThreads) {
+    *outSize = 0;
+    if (!SZx_validBlockSize(blockSize, sizeof(double)))
+        return NULL;
+    SZx_context ctx;
+    SZx_init_context(&ctx);
+    unsigned char *outputBytes = (unsigned char *) malloc(SZx_maxCompressedSize_double(nbEle, blockSize));
+
+    *outSize = compressDoubleInto_openmp(&ctx, oriData, absErrBound, nbEle, blockSize, nbThreads, outputBytes);
+
+    SZx_free_context(&ctx);
+    return outputBytes;
+}
+
+/*double counterpart of SZx_compress_float_ctx*/
+unsigned char *
+SZx_compress_double_ctx(SZx_context *ctx, double *oriData, size_t *outSize, double absErrBound,
+    size_t nbEle, int blockSize, int nbThreads, unsigned char *outputBytes, size_t outCapacity) {
+    *outSize = 0;
+    if (!SZx_validBlockSize(blockSize, sizeof(double)))
+        return NULL;
+    size_t maxPreservedBufferSize = SZx_maxCompressedSize_double(nbEle, blockSize);
+    unsigned char *dst = outputBytes != NULL && outCapacity >= maxPreservedBufferSize ?
+                         outputBytes : SZx_reserve_arena(&ctx->output, maxPreservedBufferSize);
+    size_t size;
+
+    if (nbThreads == 1)
+        size = compressDoubleInto(oriData, absErrBound, nbEle, blockSize, dst,
+                                  SZx_reserve_arena(&ctx->scratch, blockSize * sizeof(int)));
+    else
+        size = compressDoubleInto_openmp(ctx, oriData, absErrBound, nbEle, blockSize, nbThreads, dst);
+
+    if (outputBytes != NULL && dst != outputBytes) {
+        if (size > outCapacity)
+            return NULL;
+        memcpy(outputBytes, dst, size);
+        dst = outputBytes;
+    }
+    *outSize = size;
+    return dst;
+}
@@ -5,10 +5,20 @@
 #include <stdlib.h>
 #include "szx.h"
 #include <time.h>
+#if defined(__riscv)
 #include "rocc.h"
+#define SZX_HAVE_ROCC 1
+#else
+#define SZX_HAVE_ROCC 0
+#endif
+#include "szx_simd.h"
+#include "szx_trace.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // Hardware acceleration control
-int g_use_hardware_acceleration = 1; // Global flag controlled from main (0 = use software, 1 = use hardware)
+int g_use_hardware_acceleration = SZX_HAVE_ROCC; // Global flag controlled from main (0 = use software, 1 = use hardware)
 
 // Helper function to convert float to uint32_t (bitwise)
 uint32_t float_to_bits(float f) {
@@ -82,61 +92,47 @@ inline short getPrecisionReqLength_double(double precision)
         return (short)expValue;
 }
 
+/*compute value range and mean of one block, return its state (0: constant block, 1: non-constant block)*/
+inline unsigned char computeBlockStateMedianRadius_float(float *op, size_t n, float absErrBound,
+                                                         float *medianValue, float *radius) {
+    size_t j = 0;
+    float min = op[0];
+    float max = op[0];
+    for (j = 1; j < n; j++) {
+        float v = op[j];
+        if (min > v)
+            min = v;
+        else if (max < v)
+            max = v;
+    }
+    float valueRange = max - min;
+    *radius = valueRange / 2;
+    *medianValue = min + *radius;
+    return *radius <= absErrBound ? 0 : 1;
+}
+
 /*compute value range and mean for each block of the whole dataset*/
 size_t computeStateMedianRadius_float(float *oriData, size_t nbEle, float absErrBound, int blockSize,
                                       unsigned char *stateArray, float *medianArray, float *radiusArray) {
     size_t nbConstantBlocks = 0;
-    size_t i = 0, j = 0;
+    size_t i = 0;
     size_t nbBlocks = nbEle / blockSize;
     size_t offset = 0;
 
     for (i = 0; i < nbBlocks; i++) {
-        float min = oriData[offset];
-        float max = oriData[offset];
-        for (j = 1; j < (size_t)blockSize; j++) {
-            float v = oriData[offset + j];
-            if (min > v)
-                min = v;
-            else if (max < v)
-                max = v;
-        }
-        float valueRange = max - min;
-        float radius = valueRange / 2;
-        float medianValue = min + radius;
-
-        if (radius <= absErrBound) {
-            stateArray[i] = 0;
+        stateArray[i] = computeBlockStateMedianRadius_float(oriData + offset, blockSize, absErrBound,
+                                                            &medianArray[i], &radiusArray[i]);
+        if (stateArray[i] == 0)
             nbConstantBlocks++;
-        } else
-            stateArray[i] = 1;
-
-        stateArray[i] = radius <= absErrBound ? 0 : 1;
-        medianArray[i] = medianValue;
-        radiusArray[i] = radius;
         offset += blockSize;
     }
 
     int remainCount = nbEle % blockSize;
     if (remainCount != 0) {
-        float min = oriData[offset];
-        float max = oriData[offset];
-        for (j = 1; j < (size_t)remainCount; j++) {
-            float v = oriData[offset + j];
-            if (min > v)
-                min = v;
-            else if (max < v)
-                max = v;
-        }
-        float valueRange = max - min;
-        float radius = valueRange / 2;
-        float medianValue = min + radius;
-        if (radius <= absErrBound) {
-            stateArray[i] = 0;
+        stateArray[i] = computeBlockStateMedianRadius_float(oriData + offset, remainCount, absErrBound,
+                                                            &medianArray[i], &radiusArray[i]);
+        if (stateArray[i] == 0)
             nbConstantBlocks++;
-        } else
-            stateArray[i] = 1;
-        medianArray[i] = medianValue;
-        radiusArray[i] = radius;
     }
     return nbConstantBlocks;
 }
@@ -153,23 +149,36 @@ void SZx_compress_one_block_float_hw(float *oriData, size_t nbEle, float absErrB
                                            unsigned char *leadNumberArray_int, float medianValue,
                                            float radius) {
 
-    printf("HW: Starting hardware compression\n");
+#if SZX_HAVE_ROCC
+    // LOAD_BLOCK clamps the block to the scratchpad, so larger blocks are compressed in software
+    if (nbEle > SZX_ROCC_MAX_BLOCK_SIZE) {
+        SZx_compress_one_block_float_sw(oriData, nbEle, absErrBound, outputBytes, outSize,
+                                        leadNumberArray_int, medianValue, radius);
+        return;
+    }
 
     // Configure the accelerator
     szx_config(absErrBound, medianValue);
     szx_set_radius(radius);
 
-    // Load data into RoCC accelerator using bulk loading
-    szx_load_block_bulk((uint32_t)oriData, (uint32_t)nbEle);
+    // Load data into RoCC accelerator using bulk loading; an accelerator built with smaller scratchpads loads less
+    if (szx_load_block_bulk(oriData, (uint32_t)nbEle) != nbEle) {
+        SZx_compress_one_block_float_sw(oriData, nbEle, absErrBound, outputBytes, outSize,
+                                        leadNumberArray_int, medianValue, radius);
+        return;
+    }
 
     // Perform compression using RoCC
     uint32_t compressed_size = szx_compress(oriData, outputBytes);
-
-    printf("HW: RoCC compression complete, size: %u\n", compressed_size);
     *outSize = compressed_size;
 
     // The RoCC accelerator should have written the compressed data to outputBytes
     // The size should be the actual compressed size from the hardware
+#else
+    // No RoCC accelerator on this host
+    SZx_compress_one_block_float_sw(oriData, nbEle, absErrBound, outputBytes, outSize,
+                                    leadNumberArray_int, medianValue, radius);
+#endif
 }
 
 // Original software block compression function
@@ -208,8 +217,14 @@ inline void SZx_compress_one_block_float_sw(float *oriData, size_t nbEle, float
     register unsigned char leadingNum = 0;
     size_t residualMidBytes_size = 0;
 
+    //the vector kernels handle as many elements as they can; the loops below finish the tail
+    unsigned int preValue = 0;
+    i = SZx_compress_xor_float_simd(oriData, nbEle, medianValue, rightShiftBits, reqBytesLength, &preValue,
+                                    leadNumberArray_int, exactMidbyteArray, &residualMidBytes_size);
+    lfBuf_pre.ivalue = preValue;
+
     if (reqBytesLength == 2) {
-        for (i = 0; i < nbEle; i++) {
+        for (; i < nbEle; i++) {
             leadingNum = 0;
             lfBuf_cur.value = oriData[i] - medianValue;
 
@@ -238,7 +253,7 @@ inline void SZx_compress_one_block_float_sw(float *oriData, size_t nbEle, float
             lfBuf_pre = lfBuf_cur;
         }
     } else if (reqBytesLength == 3) {
-        for (i = 0; i < nbEle; i++) {
+        for (; i < nbEle; i++) {
             leadingNum = 0;
             lfBuf_cur.value = oriData[i] - medianValue;
 
@@ -256,21 +271,57 @@ inline void SZx_compress_one_block_float_sw(float *oriData, size_t nbEle, float
             leadNumberArray_int[i] = leadingNum;
 
             if (leadingNum == 0) {
-                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[2];
-                exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[3];
-                exactMidbyteArray[residualMidBytes_size + 2] = lfBuf_cur.byte[0];
+                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[1];
+                exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[2];
+                exactMidbyteArray[residualMidBytes_size + 2] = lfBuf_cur.byte[3];
                 residualMidBytes_size += 3;
             } else if (leadingNum == 1) {
-                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[2];
-                exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[3];
+                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[1];
+                exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[2];
                 residualMidBytes_size += 2;
             } else if (leadingNum == 2) {
-                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[2];
+                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[1];
                 residualMidBytes_size++;
-            } else { // leadingNum == 3
+            }
+
+            lfBuf_pre = lfBuf_cur;
+        }
+    } else { // reqBytesLength == 4
+        for (; i < nbEle; i++) {
+            leadingNum = 0;
+            lfBuf_cur.value = oriData[i] - medianValue;
+
+            lfBuf_cur.ivalue = lfBuf_cur.ivalue >> rightShiftBits;
+
+            lfBuf_pre.ivalue = lfBuf_cur.ivalue ^ lfBuf_pre.ivalue;
+
+            if (lfBuf_pre.ivalue >> 8 == 0)
+                leadingNum = 3;
+            else if (lfBuf_pre.ivalue >> 16 == 0)
+                leadingNum = 2;
+            else if (lfBuf_pre.ivalue >> 24 == 0)
+                leadingNum = 1;
+
+            leadNumberArray_int[i] = leadingNum;
+
+            if (leadingNum == 0) {
+                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[0];
+                exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[1];
+                exactMidbyteArray[residualMidBytes_size + 2] = lfBuf_cur.byte[2];
+                exactMidbyteArray[residualMidBytes_size + 3] = lfBuf_cur.byte[3];
+                residualMidBytes_size += 4;
+            } else if (leadingNum == 1) {
+                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[0];
+                exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[1];
+                exactMidbyteArray[residualMidBytes_size + 2] = lfBuf_cur.byte[2];
+                residualMidBytes_size += 3;
+            } else if (leadingNum == 2) {
                 exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[0];
                 exactMidbyteArray[residualMidBytes_size + 1] = lfBuf_cur.byte[1];
                 residualMidBytes_size += 2;
+            } else { // leadingNum == 3
+                exactMidbyteArray[residualMidBytes_size] = lfBuf_cur.byte[0];
+                residualMidBytes_size++;
             }
 
             lfBuf_pre = lfBuf_cur;
@@ -395,18 +446,62 @@ inline size_t convertIntArray2ByteArray_fast_2b_args(unsigned char* timeStepType
         return byteLength;
 }
 
-unsigned char *
-SZx_compress_float(float *oriData, size_t *outSize, float absErrBound,
-    size_t nbEle, int blockSize) {
-    float *op = oriData;
+/*upper bound of the compressed size: header, O[]/constant medians and state bits of every block,
+ *plus reqLength, median, leading numbers and 4 residual bytes per element for every block*/
+size_t SZx_maxCompressedSize_float(size_t nbEle, int blockSize)
+{
+    size_t actualNBBlocks = (nbEle + blockSize - 1) / blockSize;
+    size_t stateNBBytes = (actualNBBlocks + 7) / 8;
+    size_t maxBlockHeader = 1 + sizeof(float) + (blockSize + 3) / 4;
+    return 4 + 2 * sizeof(size_t) + stateNBBytes +
+           actualNBBlocks * (sizeof(uint16_t) + sizeof(float) + maxBlockHeader) + sizeof(float) * nbEle;
+}
 
-    *outSize = 0;
-    size_t maxPreservedBufferSize =
-            sizeof(float) * nbEle; //assume that the compressed data size would not exceed the original size
-    unsigned char *outputBytes = (unsigned char *) malloc(maxPreservedBufferSize);
+/*worst-case bytes of one non-constant block: reqLength, median, 2-bit leading numbers and every residual byte*/
+size_t SZx_maxBlockBytes(int blockSize, size_t valueBytes)
+{
+    return 1 + valueBytes + (blockSize + 3) / 4 + valueBytes * blockSize;
+}
 
-    unsigned char *leadNumberArray_int = (unsigned char *) malloc(blockSize * sizeof(int));
+/*the size of every non-constant block is stored as a uint16_t in O[], which bounds the block size*/
+int SZx_validBlockSize(int blockSize, size_t valueBytes)
+{
+    return blockSize > 0 && SZx_maxBlockBytes(blockSize, valueBytes) <= UINT16_MAX;
+}
+
+/*make the arena hold at least size bytes; the contents are not preserved when it grows*/
+unsigned char *SZx_reserve_arena(SZx_arena *arena, size_t size)
+{
+    if (arena->capacity < size) {
+        free(arena->buffer);
+        arena->buffer = (unsigned char *) malloc(size);
+        arena->capacity = arena->buffer == NULL ? 0 : size;
+    }
+    return arena->buffer;
+}
+
+void SZx_init_context(SZx_context *ctx)
+{
+    memset(ctx, 0, sizeof(SZx_context));
+}
 
+void SZx_free_context(SZx_context *ctx)
+{
+    int t;
+    for (t = 0; t < ctx->nbThreadArenas; t++)
+        free(ctx->threadArenas[t].buffer);
+    free(ctx->threadArenas);
+    free(ctx->threadInfo.buffer);
+    free(ctx->output.buffer);
+    free(ctx->scratch.buffer);
+    memset(ctx, 0, sizeof(SZx_context));
+}
+
+/*serial compression into outputBytes, which must hold SZx_maxCompressedSize_float(nbEle, blockSize) bytes;
+ *returns the compressed size*/
+static size_t compressFloatInto(float *oriData, float absErrBound, size_t nbEle, int blockSize,
+                                unsigned char *outputBytes, unsigned char *leadNumberArray_int) {
+    float *op = oriData;
     size_t i = 0;
     int oSize = 0;
 
@@ -416,85 +511,255 @@ SZx_compress_float(float *oriData, size_t *outSize, float absErrBound,
 
     size_t stateNBBytes = (actualNBBlocks % 8 == 0 ? actualNBBlocks / 8 : actualNBBlocks / 8 + 1);
 
-    unsigned char *stateArray = (unsigned char *) malloc(actualNBBlocks);
-    float *medianArray = (float *) malloc(actualNBBlocks * sizeof(float));
-    float *radiusArray = (float *) malloc(actualNBBlocks * sizeof(float));
-
-    size_t nbConstantBlocks = computeStateMedianRadius_float(oriData, nbEle, absErrBound, blockSize, stateArray,
-                                                             medianArray, radiusArray);
+    unsigned char *r = outputBytes + 4 + 2 * sizeof(size_t); //r is the starting address of 'block-size array'
+    uint16_t *O = (uint16_t*)r;
+    //Each block's stats and compression are done in one pass while the block is in cache, so the number of
+    //constant blocks (and thus where the state array, the constant medians and the non-constant blocks start)
+    //is only known at the end. Until then they are staged right after their largest possible position and
+    //moved down once all blocks are done; O[] is written in place.
+    unsigned char *S = r + actualNBBlocks * sizeof(uint16_t); //staged state array
+    unsigned char *M = S + stateNBBytes; //staged constant median values
+    unsigned char *Q = M + sizeof(float) * actualNBBlocks; //staged non-constant data blocks
+    unsigned char *p = M;
+    unsigned char *q = Q;
+    memset(S, 0, stateNBBytes);
+
+    size_t nonConstantBlockID = 0, nbConstantBlocks = 0;
+
+    for (i = 0; i < actualNBBlocks; i++, op += blockSize) {
+        SZx_TRACE_START(blockCycles);
+        size_t n = i < nbBlocks ? (size_t) blockSize : remainCount;
+        float medianValue, radius;
+        unsigned char state = computeBlockStateMedianRadius_float(op, n, absErrBound, &medianValue, &radius);
+
+        if (state) {
+            SZx_compress_one_block_float(op, n, absErrBound, q, &oSize,
+                                       leadNumberArray_int, medianValue, radius);
+            SZx_TRACE_BLOCK(i, g_use_hardware_acceleration ? SZx_TRACE_HW : SZx_TRACE_SW, state, q[0], oSize,
+                            blockCycles);
+            q += oSize;
+            O[nonConstantBlockID++] = oSize;
+            S[i >> 3] |= 1 << (7 - (i & 7)); //same bit order as convertIntArray2ByteArray_fast_1b_args
+        } else {
+            SZx_TRACE_BLOCK(i, SZx_TRACE_SW, state, 0, sizeof(float), blockCycles);
+            floatToBytes(p, medianValue);
+            p += sizeof(float);
+            nbConstantBlocks++;
+        }
+    }
 
     size_t nbNonConstantBlocks = actualNBBlocks - nbConstantBlocks;
 
-    unsigned char *r = outputBytes; // + sizeof(size_t) + stateNBBytes;
-    r[0] = SZx_VER_MAJOR;
-    r[1] = SZx_VER_MINOR;
-    r[2] = 1;
-    r[3] = 1; //support random access decompression
-    r = r + 4; //1 byte
-
-    sizeToBytes(r, blockSize);
-    r += sizeof(size_t);
-    sizeToBytes(r, nbConstantBlocks);
-    r += sizeof(size_t); //r is the starting address of 'block-size array'
-    uint16_t *O=(uint16_t*)r;
+    unsigned char *h = outputBytes;
+    h[0] = SZx_VER_MAJOR;
+    h[1] = SZx_VER_MINOR;
+    h[2] = 1;
+    h[3] = 1; //support random access decompression
+    h = h + 4; //1 byte
+
+    sizeToBytes(h, blockSize);
+    h += sizeof(size_t);
+    sizeToBytes(h, nbConstantBlocks);
+
     unsigned char *R = r + nbNonConstantBlocks*sizeof(uint16_t); //R is the starting address of the state array
-    unsigned char *p = R + stateNBBytes; //p is the starting address of constant median values.
-    unsigned char *q =
-            p + sizeof(float) * nbConstantBlocks; //q is the starting address of the non-constant data sblocks
-    //3: versions, 1: metadata: state, 1: metadata: blockSize, sizeof(size_t): nbConstantBlocks, ....
-    *outSize = q-outputBytes;
-
-    size_t nonConstantBlockID = 0;
-    printf("nbConstantBlocks = %lu, percent = %f\n", (unsigned long)nbConstantBlocks, 1.0f*(nbConstantBlocks*blockSize)/nbEle);
-    printf("Processing %lu blocks, %lu non-constant blocks\n", nbBlocks, nbNonConstantBlocks);
-    fflush(stdout);
-
-    for (i = 0; i < nbBlocks; i++, op += blockSize) {
-        // Only print for first 5 blocks and then every 10th block
-        if (i < 5 || i % 10 == 0) {
-            printf("Processing block %lu (state: %d)\n", i, stateArray[i]);
-            fflush(stdout);
-        }
+    unsigned char *P = R + stateNBBytes; //P is the starting address of constant median values.
+    unsigned char *D = P + sizeof(float) * nbConstantBlocks; //D is the starting address of the non-constant data sblocks
+    //every destination is at or below its staging area and past the end of the previous section
+    memmove(R, S, stateNBBytes);
+    memmove(P, M, p - M);
+    memmove(D, Q, q - Q);
+    return (D - outputBytes) + (q - Q);
+}
 
-        if (stateArray[i]) {
-            if (i < 5 || i % 10 == 0) {
-                printf("Block %lu: Using software compression\n", i);
-                fflush(stdout);
-            }
-            SZx_compress_one_block_float(op, blockSize, absErrBound, q, &oSize,
-                                       leadNumberArray_int, medianArray[i], radiusArray[i]);
-            if (i < 5 || i % 10 == 0) {
-                printf("Block %lu: Software compression complete, size: %d\n", i, oSize);
-                fflush(stdout);
-            }
-            q += oSize;
-            *outSize += oSize;
-            O[nonConstantBlockID++] = oSize;
-        } else {
-            if (i < 5 || i % 10 == 0) {
-                printf("Block %lu: Using constant block (no compression needed)\n", i);
-                fflush(stdout);
+unsigned char *
+SZx_compress_float(float *oriData, size_t *outSize, float absErrBound,
+    size_t nbEle, int blockSize) {
+    *outSize = 0;
+    if (!SZx_validBlockSize(blockSize, sizeof(float)))
+        return NULL;
+    size_t maxPreservedBufferSize = SZx_maxCompressedSize_float(nbEle, blockSize);
+    unsigned char *outputBytes = (unsigned char *) malloc(maxPreservedBufferSize);
+    unsigned char *leadNumberArray_int = (unsigned char *) malloc(blockSize * sizeof(int));
+
+    *outSize = compressFloatInto(oriData, absErrBound, nbEle, blockSize, outputBytes, leadNumberArray_int);
+
+    free(leadNumberArray_int);
+    return outputBytes;
+}
+
+/*block-parallel version of SZx_compress_float; the output is byte-identical to the serial software path.
+ *Each thread takes a contiguous range of blocks (a multiple of 8, so it owns whole bytes of the state array),
+ *computes the stats of each block and compresses it right away into a private buffer.
+ *The prefix sum of the block sizes in O[] then gives the final offset of every thread's blocks,
+ *which are scattered into place together with their O[] entries, state bits and constant medians.
+ *nbThreads <= 0 uses the OpenMP default; without OpenMP the blocks are processed by the calling thread.
+ *The private buffers live in per-thread arenas of ctx; outputBytes must hold SZx_maxCompressedSize_float bytes.*/
+static size_t compressFloatInto_openmp(SZx_context *ctx, float *oriData, float absErrBound,
+    size_t nbEle, int blockSize, int nbThreads, unsigned char *outputBytes) {
+#ifdef _OPENMP
+    if (nbThreads <= 0)
+        nbThreads = omp_get_max_threads();
+#else
+    nbThreads = 1;
+#endif
+
+    size_t outSize = 0;
+
+    size_t nbBlocks = nbEle / blockSize;
+    size_t remainCount = nbEle % blockSize;
+    size_t actualNBBlocks = remainCount == 0 ? nbBlocks : nbBlocks + 1;
+
+    size_t stateNBBytes = (actualNBBlocks % 8 == 0 ? actualNBBlocks / 8 : actualNBBlocks / 8 + 1);
+    //reqLength(1) + median(4) + 2-bit leading numbers + at most 4 residual bytes per element
+    size_t maxBlockBytes = 1 + sizeof(float) + (blockSize + 3) / 4 + sizeof(float) * blockSize;
+
+    if (ctx->nbThreadArenas < nbThreads) {
+        ctx->threadArenas = (SZx_arena *) realloc(ctx->threadArenas, nbThreads * sizeof(SZx_arena));
+        memset(ctx->threadArenas + ctx->nbThreadArenas, 0, (nbThreads - ctx->nbThreadArenas) * sizeof(SZx_arena));
+        ctx->nbThreadArenas = nbThreads;
+    }
+    size_t *threadInfo = (size_t *) SZx_reserve_arena(&ctx->threadInfo, 4 * nbThreads * sizeof(size_t));
+    size_t *threadNCBlocks = threadInfo; //non-constant blocks in each thread's range
+    size_t *threadNCStart = threadInfo + nbThreads; //exclusive prefix sum of threadNCBlocks
+    size_t *threadSize = threadInfo + 2 * nbThreads; //sum of O[] over each thread's range
+    size_t *threadOffset = threadInfo + 3 * nbThreads; //where each thread's blocks start in q
+
+    size_t nbConstantBlocks = 0, nbNonConstantBlocks = 0;
+    uint16_t *O = NULL;
+    unsigned char *R = NULL, *p = NULL, *q = NULL;
+
+#pragma omp parallel num_threads(nbThreads)
+    {
+        int tid = 0;
+        int nbT = 1; //the team may be smaller than nbThreads (nested regions, dynamic teams, thread limits)
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        nbT = omp_get_num_threads();
+#endif
+        size_t lo = (actualNBBlocks * tid / nbT) & ~(size_t) 7;
+        size_t hi = tid == nbT - 1 ? actualNBBlocks : (actualNBBlocks * (tid + 1) / nbT) & ~(size_t) 7;
+        size_t i, nbNC = 0, nbC = 0;
+        int oSize = 0;
+
+        //medians first and O[] next keep both aligned within the arena
+        size_t nbLocal = hi - lo + 1;
+        size_t mediansSize = nbLocal * sizeof(float), localOSize = nbLocal * sizeof(uint16_t);
+        size_t bytesSize = (hi - lo) * maxBlockBytes + 1;
+        unsigned char *arena = SZx_reserve_arena(&ctx->threadArenas[tid],
+                                            mediansSize + localOSize + bytesSize + nbLocal + blockSize * sizeof(int));
+        float *localMedians = (float *) arena;
+        uint16_t *localO = (uint16_t *) (arena + mediansSize);
+        unsigned char *localBytes = arena + mediansSize + localOSize;
+        unsigned char *localStates = localBytes + bytesSize;
+        unsigned char *leadNumberArray_int = localStates + nbLocal;
+        unsigned char *lq = localBytes;
+
+        for (i = lo; i < hi; i++) {
+            SZx_TRACE_START(blockCycles);
+            size_t n = i < nbBlocks ? (size_t) blockSize : remainCount;
+            float medianValue, radius;
+            localStates[i - lo] = computeBlockStateMedianRadius_float(oriData + i * blockSize, n, absErrBound,
+                                                                      &medianValue, &radius);
+            if (localStates[i - lo]) {
+                SZx_compress_one_block_float_sw(oriData + i * blockSize, n, absErrBound, lq, &oSize,
+                                                leadNumberArray_int, medianValue, radius);
+                SZx_TRACE_BLOCK(i, SZx_TRACE_SW, 1, lq[0], oSize, blockCycles);
+                lq += oSize;
+                localO[nbNC++] = oSize;
+            } else {
+                SZx_TRACE_BLOCK(i, SZx_TRACE_SW, 0, 0, sizeof(float), blockCycles);
+                localMedians[nbC++] = medianValue;
             }
-            floatToBytes(p, medianArray[i]);
-            p += sizeof(float);
         }
-    }
+        threadNCBlocks[tid] = nbNC;
+        threadSize[tid] = lq - localBytes;
 
-    if (remainCount != 0) {
-        if (stateArray[i]) {
-            SZx_compress_one_block_float(op, remainCount, absErrBound, q, &oSize,
-                                       leadNumberArray_int, medianArray[i], radiusArray[i]);
-            *outSize += oSize;
-            O[nonConstantBlockID] = oSize;
-        } else {
-            floatToBytes(p, medianArray[i]);
+#pragma omp barrier
+#pragma omp single
+        {
+            int t;
+            size_t offset = 0;
+            for (t = 0; t < nbT; t++) {
+                threadNCStart[t] = nbNonConstantBlocks;
+                nbNonConstantBlocks += threadNCBlocks[t];
+                threadOffset[t] = offset;
+                offset += threadSize[t];
+            }
+            nbConstantBlocks = actualNBBlocks - nbNonConstantBlocks;
+
+            unsigned char *r = outputBytes;
+            r[0] = SZx_VER_MAJOR;
+            r[1] = SZx_VER_MINOR;
+            r[2] = 1;
+            r[3] = 1; //support random access decompression
+            r = r + 4;
+
+            sizeToBytes(r, blockSize);
+            r += sizeof(size_t);
+            sizeToBytes(r, nbConstantBlocks);
+            r += sizeof(size_t);
+            O = (uint16_t *) r;
+            R = r + nbNonConstantBlocks * sizeof(uint16_t);
+            p = R + stateNBBytes;
+            q = p + sizeof(float) * nbConstantBlocks;
+            outSize = (q - outputBytes) + offset;
         }
 
+        unsigned char *lp = p + sizeof(float) * (lo - threadNCStart[tid]); //constant blocks before lo
+        for (i = 0; i < nbC; i++, lp += sizeof(float))
+            floatToBytes(lp, localMedians[i]);
+        memcpy(O + threadNCStart[tid], localO, nbNC * sizeof(uint16_t));
+        convertIntArray2ByteArray_fast_1b_args(localStates, hi - lo, R + lo / 8);
+        memcpy(q + threadOffset[tid], localBytes, threadSize[tid]);
     }
 
-    convertIntArray2ByteArray_fast_1b_args(stateArray, actualNBBlocks, R);
+    return outSize;
+}
 
-    free(leadNumberArray_int);
+unsigned char *
+SZx_compress_float_openmp(float *oriData, size_t *outSize, float absErrBound,
+    size_t nbEle, int blockSize, int nbThreads) {
+    *outSize = 0;
+    if (!SZx_validBlockSize(blockSize, sizeof(float)))
+        return NULL;
+    SZx_context ctx;
+    SZx_init_context(&ctx);
+    unsigned char *outputBytes = (unsigned char *) malloc(SZx_maxCompressedSize_float(nbEle, blockSize));
 
+    *outSize = compressFloatInto_openmp(&ctx, oriData, absErrBound, nbEle, blockSize, nbThreads, outputBytes);
+
+    SZx_free_context(&ctx);
     return outputBytes;
 }
+
+/*compress with the scratch buffers of ctx, which grow on demand and are reused by later calls.
+ *The result goes to outputBytes if given: it is written in place when outCapacity is at least
+ *SZx_maxCompressedSize_float, otherwise it is built in ctx and copied, and NULL is returned if it does not fit.
+ *Without outputBytes the result stays in ctx and is valid until the next call with ctx.
+ *nbThreads == 1 runs the serial path (SZx_compress_float), anything else the block-parallel one.*/
+unsigned char *
+SZx_compress_float_ctx(SZx_context *ctx, float *oriData, size_t *outSize, float absErrBound,
+    size_t nbEle, int blockSize, int nbThreads, unsigned char *outputBytes, size_t outCapacity) {
+    *outSize = 0;
+    if (!SZx_validBlockSize(blockSize, sizeof(float)))
+        return NULL;
+    size_t maxPreservedBufferSize = SZx_maxCompressedSize_float(nbEle, blockSize);
+    unsigned char *dst = outputBytes != NULL && outCapacity >= maxPreservedBufferSize ?
+                         outputBytes : SZx_reserve_arena(&ctx->output, maxPreservedBufferSize);
+    size_t size;
+
+    if (nbThreads == 1)
+        size = compressFloatInto(oriData, absErrBound, nbEle, blockSize, dst,
+                                 SZx_reserve_arena(&ctx->scratch, blockSize * sizeof(int)));
+    else
+        size = compressFloatInto_openmp(ctx, oriData, absErrBound, nbEle, blockSize, nbThreads, dst);
+
+    if (outputBytes != NULL && dst != outputBytes) {
+        if (size > outCapacity)
+            return NULL;
+        memcpy(outputBytes, dst, size);
+        dst = outputBytes;
+    }
+    *outSize = size;
+    return dst;
+}
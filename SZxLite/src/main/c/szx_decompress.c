@@ -0,0 +1,431 @@
+#include "define.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "szx.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+inline long bytesToLong_bigEndian(unsigned char* b)
+{
+        long temp = 0;
+        long res = 0;
+
+        res <<= 8;
+        temp = b[0] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[1] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[2] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[3] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[4] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[5] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[6] & 0xff;
+        res |= temp;
+
+        res <<= 8;
+        temp = b[7] & 0xff;
+        res |= temp;
+
+        return res;
+}
+
+inline size_t bytesToSize(unsigned char* bytes)
+{
+        return bytesToLong_bigEndian(bytes);//8
+}
+
+inline float bytesToFloat(unsigned char* bytes)
+{
+        lfloat buf;
+        memcpy(buf.byte, bytes, 4);
+        return buf.value;
+}
+
+inline double bytesToDouble(unsigned char* bytes)
+{
+        ldouble buf;
+        memcpy(buf.byte, bytes, 8);
+        return buf.value;
+}
+
+/*inverse of convertIntArray2ByteArray_fast_2b_args; *intArray is allocated here*/
+void convertByteArray2IntArray_fast_2b(size_t stepLength, unsigned char* byteArray, size_t byteArrayLength, unsigned char **intArray)
+{
+        if(stepLength > byteArrayLength*4)
+        {
+                printf("Error: stepLength > byteArray.length*4\n");
+                printf("stepLength=%zu, byteArray.length=%zu\n", stepLength, byteArrayLength);
+                exit(0);
+        }
+        if(stepLength > 0)
+                *intArray = (unsigned char*)malloc(stepLength*sizeof(unsigned char));
+        else
+                *intArray = NULL;
+        size_t i, n = 0;
+
+        for (i = 0; i < byteArrayLength; i++) {
+                unsigned char tmp = byteArray[i];
+                (*intArray)[n++] = (tmp & 0xC0) >> 6;
+                if(n==stepLength)
+                        break;
+                (*intArray)[n++] = (tmp & 0x30) >> 4;
+                if(n==stepLength)
+                        break;
+                (*intArray)[n++] = (tmp & 0x0C) >> 2;
+                if(n==stepLength)
+                        break;
+                (*intArray)[n++] = tmp & 0x03;
+                if(n==stepLength)
+                        break;
+        }
+}
+
+/*inverse of convertIntArray2ByteArray_fast_1b_args*/
+void convertByteArray2IntArray_fast_1b_args(size_t intArrayLength, unsigned char* byteArray, size_t byteArrayLength, unsigned char* intArray)
+{
+        size_t n = 0, i;
+        int tmp;
+        if (byteArrayLength == 0)
+                return;
+        for (i = 0; i < byteArrayLength-1; i++)
+        {
+                tmp = byteArray[i];
+                intArray[n++] = (tmp & 0x80) >> 7;
+                intArray[n++] = (tmp & 0x40) >> 6;
+                intArray[n++] = (tmp & 0x20) >> 5;
+                intArray[n++] = (tmp & 0x10) >> 4;
+                intArray[n++] = (tmp & 0x08) >> 3;
+                intArray[n++] = (tmp & 0x04) >> 2;
+                intArray[n++] = (tmp & 0x02) >> 1;
+                intArray[n++] = (tmp & 0x01) >> 0;
+        }
+
+        tmp = byteArray[i];
+        for(int j = 7; j >= 0 && n < intArrayLength; j--)
+        {
+                intArray[n++] = (tmp & (1 << j)) >> j;
+        }
+}
+
+/*decode one non-constant block written by SZx_compress_one_block_float_sw; returns the number of bytes consumed.
+ *Each element stores the bytes below its leading (unchanged) ones, down to the lowest of the reqBytesLength
+ *top bytes; the leading bytes are those of the previous element and the bytes below reqBytesLength are 0.*/
+int SZx_decompress_one_block_float(float* newData, size_t blockSize, unsigned char* cmpBytes)
+{
+    int reqLength = cmpBytes[0];
+    float medianValue = bytesToFloat(cmpBytes + 1);
+
+    int reqBytesLength = reqLength / 8;
+    int resiBitsLength = reqLength % 8;
+    int rightShiftBits = 0;
+    if (resiBitsLength != 0) {
+        rightShiftBits = 8 - resiBitsLength;
+        reqBytesLength++;
+    }
+
+    size_t leadNumberArray_size = blockSize % 4 == 0 ? blockSize / 4 : blockSize / 4 + 1;
+    unsigned char *leadNumberArray = cmpBytes + 1 + sizeof(float);
+    unsigned char *q = leadNumberArray + leadNumberArray_size;
+
+    int lowByte = 4 - reqBytesLength;
+    lfloat lfBuf_cur, lfBuf_out;
+    lfBuf_cur.ivalue = 0;
+
+    size_t i;
+    int k;
+    for (i = 0; i < blockSize; i++) {
+        int leadingNum = (leadNumberArray[i >> 2] >> (6 - ((i & 3) << 1))) & 3;
+        for (k = lowByte; k < 4 - leadingNum; k++)
+            lfBuf_cur.byte[k] = *q++;
+
+        lfBuf_out.ivalue = lfBuf_cur.ivalue << rightShiftBits;
+        newData[i] = lfBuf_out.value + medianValue;
+    }
+
+    return (int) (q - cmpBytes);
+}
+
+/*double counterpart of SZx_decompress_one_block_float (blocks of SZx_compress_one_block_double_sw)*/
+int SZx_decompress_one_block_double(double* newData, size_t blockSize, unsigned char* cmpBytes)
+{
+    int reqLength = cmpBytes[0];
+    double medianValue = bytesToDouble(cmpBytes + 1);
+
+    int reqBytesLength = reqLength / 8;
+    int resiBitsLength = reqLength % 8;
+    int rightShiftBits = 0;
+    if (resiBitsLength != 0) {
+        rightShiftBits = 8 - resiBitsLength;
+        reqBytesLength++;
+    }
+
+    size_t leadNumberArray_size = blockSize % 4 == 0 ? blockSize / 4 : blockSize / 4 + 1;
+    unsigned char *leadNumberArray = cmpBytes + 1 + sizeof(double);
+    unsigned char *q = leadNumberArray + leadNumberArray_size;
+
+    int lowByte = 8 - reqBytesLength;
+    ldouble ldBuf_cur, ldBuf_out;
+    ldBuf_cur.lvalue = 0;
+
+    size_t i;
+    int k;
+    for (i = 0; i < blockSize; i++) {
+        int leadingNum = (leadNumberArray[i >> 2] >> (6 - ((i & 3) << 1))) & 3;
+        for (k = lowByte; k < 8 - leadingNum; k++)
+            ldBuf_cur.byte[k] = *q++;
+
+        ldBuf_out.lvalue = ldBuf_cur.lvalue << rightShiftBits;
+        newData[i] = ldBuf_out.value + medianValue;
+    }
+
+    return (int) (q - cmpBytes);
+}
+
+/*where the sections of an SZx_compress_float/SZx_compress_double stream start, see the header written there*/
+typedef struct {
+    size_t valueBytes; //sizeof(float) or sizeof(double), also the size of a constant median
+    size_t blockSize;
+    size_t nbBlocks;
+    size_t remainCount;
+    size_t actualNBBlocks;
+    size_t nbConstantBlocks;
+    size_t nbNonConstantBlocks;
+    uint16_t *O; //compressed size of each non-constant block
+    unsigned char *R; //state array, 1 bit per block (1 = non-constant)
+    unsigned char *P; //constant median values
+    unsigned char *D; //non-constant data blocks
+} SZx_layout;
+
+static int parseLayout(unsigned char *cmpBytes, size_t nbEle, size_t valueBytes, SZx_layout *l)
+{
+    if (cmpBytes[0] != SZx_VER_MAJOR || cmpBytes[1] != SZx_VER_MINOR)
+        return SZx_FERR;
+
+    l->valueBytes = valueBytes;
+    l->blockSize = bytesToSize(cmpBytes + 4);
+    l->nbConstantBlocks = bytesToSize(cmpBytes + 4 + sizeof(size_t));
+    if (l->blockSize == 0)
+        return SZx_FERR;
+
+    l->nbBlocks = nbEle / l->blockSize;
+    l->remainCount = nbEle % l->blockSize;
+    l->actualNBBlocks = l->remainCount == 0 ? l->nbBlocks : l->nbBlocks + 1;
+    if (l->nbConstantBlocks > l->actualNBBlocks)
+        return SZx_FERR;
+    l->nbNonConstantBlocks = l->actualNBBlocks - l->nbConstantBlocks;
+
+    size_t stateNBBytes = (l->actualNBBlocks % 8 == 0 ? l->actualNBBlocks / 8 : l->actualNBBlocks / 8 + 1);
+    unsigned char *r = cmpBytes + 4 + 2 * sizeof(size_t);
+    l->O = (uint16_t *) r;
+    l->R = r + l->nbNonConstantBlocks * sizeof(uint16_t);
+    l->P = l->R + stateNBBytes;
+    l->D = l->P + valueBytes * l->nbConstantBlocks;
+    return SZx_SCES;
+}
+
+/*number of non-constant blocks in [lo, hi), from the state bits*/
+static size_t countNonConstantBlocks(const unsigned char *R, size_t lo, size_t hi)
+{
+    size_t i = lo, count = 0;
+    for (; i < hi && (i & 7); i++)
+        count += (R[i >> 3] >> (7 - (i & 7))) & 1;
+    for (; i + 8 <= hi; i += 8)
+        count += __builtin_popcount(R[i >> 3]);
+    for (; i < hi; i++)
+        count += (R[i >> 3] >> (7 - (i & 7))) & 1;
+    return count;
+}
+
+/*bytes taken by the non-constant blocks [from, to) in O[] order*/
+static size_t sumBlockSizes(const uint16_t *O, size_t from, size_t to)
+{
+    size_t i, size = 0;
+    for (i = from; i < to; i++)
+        size += O[i];
+    return size;
+}
+
+/*decode blocks [lo, hi) into newData (float or double as l->valueBytes), given the number of
+ *non-constant blocks before lo and where the first of them starts in D*/
+static void decompressBlockRange(const SZx_layout *l, size_t lo, size_t hi,
+                                 size_t nonConstantBlockID, size_t offset, void *newData)
+{
+    size_t i, j;
+    size_t constantBlockID = lo - nonConstantBlockID;
+    unsigned char *op = (unsigned char *) newData;
+
+    for (i = lo; i < hi; i++) {
+        size_t n = i < l->nbBlocks ? l->blockSize : l->remainCount;
+        int nonConstant = (l->R[i >> 3] >> (7 - (i & 7))) & 1;
+        unsigned char *median = l->P + l->valueBytes * constantBlockID;
+        if (l->valueBytes == sizeof(float)) {
+            if (nonConstant) {
+                SZx_decompress_one_block_float((float *) op, n, l->D + offset);
+            } else {
+                float medianValue = bytesToFloat(median);
+                for (j = 0; j < n; j++)
+                    ((float *) op)[j] = medianValue;
+            }
+        } else {
+            if (nonConstant) {
+                SZx_decompress_one_block_double((double *) op, n, l->D + offset);
+            } else {
+                double medianValue = bytesToDouble(median);
+                for (j = 0; j < n; j++)
+                    ((double *) op)[j] = medianValue;
+            }
+        }
+        if (nonConstant)
+            offset += l->O[nonConstantBlockID++];
+        else
+            constantBlockID++;
+        op += n * l->valueBytes;
+    }
+}
+
+/*random access decode of blocks [startBlock, endBlock): only the state bits and O[] entries before
+ *startBlock are read to locate the first block; no other block is touched*/
+static int decompressBlocks(unsigned char *cmpBytes, size_t nbEle, size_t valueBytes,
+                            size_t startBlock, size_t endBlock, void *newData)
+{
+    SZx_layout l;
+    if (parseLayout(cmpBytes, nbEle, valueBytes, &l) != SZx_SCES)
+        return SZx_FERR;
+    if (endBlock > l.actualNBBlocks)
+        endBlock = l.actualNBBlocks;
+    if (startBlock >= endBlock)
+        return SZx_SCES;
+
+    size_t nonConstantBlockID = countNonConstantBlocks(l.R, 0, startBlock);
+    size_t offset = sumBlockSizes(l.O, 0, nonConstantBlockID);
+    decompressBlockRange(&l, startBlock, endBlock, nonConstantBlockID, offset, newData);
+    return SZx_SCES;
+}
+
+/*block-parallel decode. Each thread takes the same block range as in SZx_compress_float_openmp,
+ *counts its non-constant blocks from the state bits and sums their O[] entries; the prefix sums
+ *of both locate the thread's first block and every thread then decodes its range independently.
+ *nbThreads <= 0 uses the OpenMP default; without OpenMP the blocks are decoded by the calling thread.*/
+static void *decompress_openmp(unsigned char *cmpBytes, size_t nbEle, size_t valueBytes, int nbThreads)
+{
+#ifdef _OPENMP
+    if (nbThreads <= 0)
+        nbThreads = omp_get_max_threads();
+#else
+    nbThreads = 1;
+#endif
+
+    SZx_layout l;
+    if (parseLayout(cmpBytes, nbEle, valueBytes, &l) != SZx_SCES)
+        return NULL;
+
+    unsigned char *out = (unsigned char *) malloc(nbEle * valueBytes);
+    size_t *threadNCStart = (size_t *) malloc((nbThreads + 1) * sizeof(size_t)); //non-constant blocks before each range
+    size_t *threadOffset = (size_t *) malloc((nbThreads + 1) * sizeof(size_t)); //where each range starts in D
+
+#pragma omp parallel num_threads(nbThreads)
+    {
+        int tid = 0;
+        int nbT = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        nbT = omp_get_num_threads();
+#endif
+        size_t lo = (l.actualNBBlocks * tid / nbT) & ~(size_t) 7;
+        size_t hi = tid == nbT - 1 ? l.actualNBBlocks : (l.actualNBBlocks * (tid + 1) / nbT) & ~(size_t) 7;
+
+        threadNCStart[tid + 1] = countNonConstantBlocks(l.R, lo, hi);
+#pragma omp barrier
+#pragma omp single
+        {
+            int t;
+            threadNCStart[0] = 0;
+            for (t = 0; t < nbT; t++)
+                threadNCStart[t + 1] += threadNCStart[t];
+        }
+
+        threadOffset[tid + 1] = sumBlockSizes(l.O, threadNCStart[tid], threadNCStart[tid + 1]);
+#pragma omp barrier
+#pragma omp single
+        {
+            int t;
+            threadOffset[0] = 0;
+            for (t = 0; t < nbT; t++)
+                threadOffset[t + 1] += threadOffset[t];
+        }
+
+        decompressBlockRange(&l, lo, hi, threadNCStart[tid], threadOffset[tid], out + lo * l.blockSize * valueBytes);
+    }
+
+    free(threadOffset);
+    free(threadNCStart);
+    return out;
+}
+
+/*decode a whole stream of nbEle values produced by SZx_compress_float(_openmp); *newData is allocated here*/
+void SZx_decompress_float(float** newData, size_t nbEle, unsigned char* cmpBytes)
+{
+    SZx_layout l;
+    *newData = NULL;
+    if (parseLayout(cmpBytes, nbEle, sizeof(float), &l) != SZx_SCES)
+        return;
+
+    *newData = (float *) malloc(nbEle * sizeof(float));
+    decompressBlockRange(&l, 0, l.actualNBBlocks, 0, 0, *newData);
+}
+
+/*random access: decode only blocks [startBlock, endBlock) of a stream of nbEle values into newData, which must
+ *hold the values of those blocks (endBlock - startBlock blocks, the last one possibly shorter)*/
+int SZx_decompress_float_blocks(float* newData, size_t nbEle, unsigned char* cmpBytes,
+                                size_t startBlock, size_t endBlock)
+{
+    return decompressBlocks(cmpBytes, nbEle, sizeof(float), startBlock, endBlock, newData);
+}
+
+/*block-parallel version of SZx_decompress_float*/
+void SZx_decompress_float_openmp(float** newData, size_t nbEle, unsigned char* cmpBytes, int nbThreads)
+{
+    *newData = (float *) decompress_openmp(cmpBytes, nbEle, sizeof(float), nbThreads);
+}
+
+/*decode a whole stream of nbEle values produced by SZx_compress_double(_openmp); *newData is allocated here*/
+void SZx_decompress_double(double** newData, size_t nbEle, unsigned char* cmpBytes)
+{
+    SZx_layout l;
+    *newData = NULL;
+    if (parseLayout(cmpBytes, nbEle, sizeof(double), &l) != SZx_SCES)
+        return;
+
+    *newData = (double *) malloc(nbEle * sizeof(double));
+    decompressBlockRange(&l, 0, l.actualNBBlocks, 0, 0, *newData);
+}
+
+int SZx_decompress_double_blocks(double* newData, size_t nbEle, unsigned char* cmpBytes,
+                                 size_t startBlock, size_t endBlock)
+{
+    return decompressBlocks(cmpBytes, nbEle, sizeof(double), startBlock, endBlock, newData);
+}
+
+void SZx_decompress_double_openmp(double** newData, size_t nbEle, unsigned char* cmpBytes, int nbThreads)
+{
+    *newData = (double *) decompress_openmp(cmpBytes, nbEle, sizeof(double), nbThreads);
+}
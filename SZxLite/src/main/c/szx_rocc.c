@@ -1,67 +1,249 @@
 #include "szx_rocc.h"
+#include "szx.h"
 #include "rocc.h"
+#include "szx_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-// Hardware-accelerated compression function using RoCC with scratchpad
-unsigned char* SZx_compress_float_rocc(float *oriData, size_t *outSize, float absErrBound, size_t nbEle, int blockSize) {
-    printf("Using RoCC hardware acceleration with scratchpad!\n");
+int g_rocc_hardware_stats = 1; // 1 = COMPRESS_ARRAY (block stats in the accelerator), 0 = COMPRESS_MULTI descriptors
+
+// Descriptor path: the stats of all blocks are computed first, which fixes where each section of the stream
+// starts, so the accelerator can write the non-constant full blocks straight into the data section and their
+// sizes into O[]. A non-constant trailing partial block is compressed in software after them.
+static unsigned char* compressWithDescriptors(float *oriData, size_t *outSize, float absErrBound, size_t nbEle,
+                                              int blockSize) {
+    // Calculate number of blocks
+    size_t nbBlocks = nbEle / blockSize;
+    size_t remainCount = nbEle % blockSize;
+    size_t actualNBBlocks = remainCount == 0 ? nbBlocks : nbBlocks + 1;
+    size_t stateNBBytes = (actualNBBlocks + 7) / 8;
 
-    // Allocate output buffer (worst case: 4 bytes per float)
-    unsigned char* outputBytes = (unsigned char*)malloc(nbEle * 4);
-    if (!outputBytes) {
-        printf("Error: failed to allocate output buffer!\n");
+    unsigned char* outputBytes = (unsigned char*)malloc(SZx_maxCompressedSize_float(nbEle, blockSize));
+    unsigned char* stateArray = (unsigned char*)malloc(actualNBBlocks + 1);
+    float* medianArray = (float*)malloc((actualNBBlocks + 1) * sizeof(float));
+    float* radiusArray = (float*)malloc((actualNBBlocks + 1) * sizeof(float));
+    szx_rocc_desc_t* table = (szx_rocc_desc_t*)malloc((nbBlocks + 1) * sizeof(szx_rocc_desc_t));
+    if (!outputBytes || !stateArray || !medianArray || !radiusArray || !table) {
+        printf("Error: failed to allocate output buffers!\n");
+        free(outputBytes);
+        free(stateArray);
+        free(medianArray);
+        free(radiusArray);
+        free(table);
         return NULL;
     }
 
-    // Calculate number of blocks
-    size_t numBlocks = (nbEle + blockSize - 1) / blockSize;
-    size_t totalCompressedSize = 0;
+    // Calculate state, median and radius of each block
+    size_t nbConstantBlocks = computeStateMedianRadius_float(oriData, nbEle, absErrBound, blockSize,
+                                                             stateArray, medianArray, radiusArray);
+    size_t nbNonConstantBlocks = actualNBBlocks - nbConstantBlocks;
+
+    unsigned char *h = outputBytes;
+    h[0] = SZx_VER_MAJOR;
+    h[1] = SZx_VER_MINOR;
+    h[2] = 1;
+    h[3] = 1; //support random access decompression
+    sizeToBytes(h + 4, blockSize);
+    sizeToBytes(h + 4 + sizeof(size_t), nbConstantBlocks);
 
-    printf("Processing %lu blocks with RoCC accelerator...\n", (unsigned long)numBlocks);
+    unsigned char *r = outputBytes + 4 + 2 * sizeof(size_t);
+    uint16_t *O = (uint16_t*)r; //block sizes, written by the accelerator
+    unsigned char *R = r + nbNonConstantBlocks * sizeof(uint16_t); //state array
+    unsigned char *P = R + stateNBBytes; //constant median values
+    unsigned char *D = P + sizeof(float) * nbConstantBlocks; //non-constant data blocks, written by the accelerator
+    convertIntArray2ByteArray_fast_1b_args(stateArray, actualNBBlocks, R);
 
-    // Process each block using RoCC accelerator
-    for (size_t block = 0; block < numBlocks; block++) {
-        // Progress indicator every 10 blocks
-        if (block % 10 == 0) {
-            printf("Processing block %lu/%lu...\n", (unsigned long)(block + 1), (unsigned long)numBlocks);
-            printf("Using bulk loading for block %lu (64 elements)\n", (unsigned long)block);
+    size_t nbHWBlocks = 0;
+    unsigned char *p = P;
+    for (size_t block = 0; block < actualNBBlocks; block++) {
+        if (stateArray[block] == 0) {
+            floatToBytes(p, medianArray[block]);
+            p += sizeof(float);
+        } else if (block < nbBlocks) {
+            table[nbHWBlocks].data = (uint64_t)(uintptr_t)(oriData + block * blockSize);
+            table[nbHWBlocks].medianValue = medianArray[block];
+            table[nbHWBlocks].radius = radiusArray[block];
+            nbHWBlocks++;
         }
+    }
 
-        size_t blockStart = block * blockSize;
-        size_t blockEnd = (blockStart + blockSize < nbEle) ? blockStart + blockSize : nbEle;
-        size_t blockEle = blockEnd - blockStart;
+    // Configure the error bound once; each descriptor carries its block's median and radius
+    size_t dataSize = 0;
+    if (nbHWBlocks > 0) {
+        SZx_TRACE_START(batchCycles);
+        asm volatile("fence" ::: "memory"); // the table and the data are visible to the accelerator's loads
+        szx_config(absErrBound, 0.0f);
+        szx_set_output(D, O);
+        dataSize = szx_compress_multi(table, nbHWBlocks);
+        asm volatile("fence" ::: "memory");
+        // one record for the whole batch, under the id of its first block
+        SZx_TRACE_BLOCK(0, SZx_TRACE_ROCC, 1, 0, dataSize, batchCycles);
+    }
 
-        // Calculate median and radius for this block
-        float min = oriData[blockStart];
-        float max = oriData[blockStart];
-        for (size_t i = blockStart + 1; i < blockEnd; i++) {
-            if (oriData[i] < min) min = oriData[i];
-            if (oriData[i] > max) max = oriData[i];
-        }
-        float radius = (max - min) / 2.0f;
-        float medianValue = min + radius;
+    if (remainCount != 0 && stateArray[nbBlocks]) {
+        SZx_TRACE_START(blockCycles);
+        unsigned char leadNumberArray_int[SZX_ROCC_MAX_BLOCK_SIZE * sizeof(int)];
+        int compressedSize;
+        SZx_compress_one_block_float_sw(oriData + nbBlocks * blockSize, remainCount, absErrBound, D + dataSize,
+                                        &compressedSize, leadNumberArray_int, medianArray[nbBlocks],
+                                        radiusArray[nbBlocks]);
+        SZx_TRACE_BLOCK(nbBlocks, SZx_TRACE_SW, 1, D[dataSize], compressedSize, blockCycles);
+        O[nbNonConstantBlocks - 1] = compressedSize;
+        dataSize += compressedSize;
+    }
 
-        // Configure RoCC accelerator for this block
-        szx_config(absErrBound, medianValue);
-        szx_set_radius(radius);
+    free(table);
+    free(radiusArray);
+    free(medianArray);
+    free(stateArray);
+    *outSize = (D - outputBytes) + dataSize;
+    return outputBytes;
+}
+
+// Hardware-stats path: the accelerator computes each block's median and radius, the trailing partial block's too,
+// and decides whether it is constant, so the host only passes the array. It reports the size of every block (0 = constant) and the medians
+// of the constant blocks; since the number of constant blocks is known only then, the blocks are written to a
+// staging area past their largest possible position and the stream is assembled afterwards, as compressFloatInto.
+static unsigned char* compressWithHardwareStats(float *oriData, size_t *outSize, float absErrBound, size_t nbEle,
+                                                int blockSize) {
+    size_t nbBlocks = nbEle / blockSize;
+    size_t remainCount = nbEle % blockSize;
+    size_t actualNBBlocks = remainCount == 0 ? nbBlocks : nbBlocks + 1;
+    size_t stateNBBytes = (actualNBBlocks + 7) / 8;
+
+    unsigned char* outputBytes = (unsigned char*)malloc(SZx_maxCompressedSize_float(nbEle, blockSize));
+    uint16_t* sizes = (uint16_t*)malloc((actualNBBlocks + 1) * sizeof(uint16_t));
+    float* medians = (float*)malloc((actualNBBlocks + 1) * sizeof(float));
+    if (!outputBytes || !sizes || !medians) {
+        printf("Error: failed to allocate output buffers!\n");
+        free(outputBytes);
+        free(sizes);
+        free(medians);
+        return NULL;
+    }
 
-        // Use bulk loading instead of individual data transfers
-        // This eliminates 64 individual RoCC calls per block
-        szx_load_block_bulk((uint32_t)(oriData + blockStart), blockEle);
+    unsigned char *r = outputBytes + 4 + 2 * sizeof(size_t);
+    uint16_t *O = (uint16_t*)r;
+    unsigned char *S = r + actualNBBlocks * sizeof(uint16_t); //staged state array
+    unsigned char *M = S + stateNBBytes; //staged constant median values
+    unsigned char *Q = M + sizeof(float) * actualNBBlocks; //staged non-constant data blocks, written by the accelerator
 
-        // Call compression function
-        uint32_t compressedSize = szx_compress(0, 0); // Dummy addresses, data is in scratchpad
+    size_t dataSize = 0;
+    if (nbEle > 0) {
+        SZx_TRACE_START(batchCycles);
+        asm volatile("fence" ::: "memory"); // the data is visible to the accelerator's loads
+        szx_config(absErrBound, 0.0f);
+        szx_set_output(Q, sizes);
+        szx_set_medians(medians);
+        dataSize = szx_compress_array(oriData, nbEle);
+        asm volatile("fence" ::: "memory");
+        SZx_TRACE_BLOCK(0, SZx_TRACE_ROCC, 1, 0, dataSize, batchCycles);
+    }
 
-        // Only print results for first few blocks and every 10th block
-        if (block < 5 || block % 10 == 0) {
-            printf("Block %lu: %lu elements, compressed to %u bytes\n", (unsigned long)block, (unsigned long)blockEle, compressedSize);
+    // A non-constant block is never empty, so a zero size marks a constant block
+    memset(S, 0, stateNBBytes);
+    unsigned char *p = M;
+    size_t nbNonConstantBlocks = 0;
+    for (size_t block = 0; block < actualNBBlocks; block++) {
+        if (sizes[block] == 0) {
+            floatToBytes(p, medians[block]);
+            p += sizeof(float);
+        } else {
+            O[nbNonConstantBlocks++] = sizes[block];
+            S[block >> 3] |= 1 << (7 - (block & 7)); //same bit order as convertIntArray2ByteArray_fast_1b_args
         }
-
-        totalCompressedSize += compressedSize;
     }
+    size_t nbConstantBlocks = actualNBBlocks - nbNonConstantBlocks;
 
-    printf("All blocks processed. Total compressed size: %lu bytes\n", (unsigned long)totalCompressedSize);
-    *outSize = totalCompressedSize;
+    unsigned char *h = outputBytes;
+    h[0] = SZx_VER_MAJOR;
+    h[1] = SZx_VER_MINOR;
+    h[2] = 1;
+    h[3] = 1; //support random access decompression
+    sizeToBytes(h + 4, blockSize);
+    sizeToBytes(h + 4 + sizeof(size_t), nbConstantBlocks);
+
+    unsigned char *R = r + nbNonConstantBlocks * sizeof(uint16_t); //state array
+    unsigned char *P = R + stateNBBytes; //constant median values
+    unsigned char *D = P + sizeof(float) * nbConstantBlocks; //non-constant data blocks
+    memmove(R, S, stateNBBytes);
+    memmove(P, M, p - M);
+    memmove(D, Q, dataSize);
+
+    free(medians);
+    free(sizes);
+    *outSize = (D - outputBytes) + dataSize;
     return outputBytes;
 }
+
+// Hardware-accelerated compression function using RoCC with scratchpad; produces the same stream as SZx_compress_float
+unsigned char* SZx_compress_float_rocc(float *oriData, size_t *outSize, float absErrBound, size_t nbEle, int blockSize) {
+    if (blockSize < 1 || blockSize > SZX_ROCC_MAX_BLOCK_SIZE) {
+        printf("Error: the accelerator compresses blocks of 1 to %d values, not %d!\n", SZX_ROCC_MAX_BLOCK_SIZE,
+               blockSize);
+        return NULL;
+    }
+    // The accelerator may have been built with smaller scratchpads than SZX_ROCC_MAX_BLOCK_SIZE; it then clamps
+    // the block size, which would give blocks of the wrong length
+    uint32_t applied = szx_set_block_size(blockSize);
+    if (applied != (uint32_t)blockSize) {
+        printf("Error: the accelerator compresses blocks of at most %u values, not %d!\n", applied, blockSize);
+        return NULL;
+    }
+    if (g_rocc_hardware_stats) {
+        return compressWithHardwareStats(oriData, outSize, absErrBound, nbEle, blockSize);
+    }
+    return compressWithDescriptors(oriData, outSize, absErrBound, nbEle, blockSize);
+}
+
+void SZx_rocc_read_counters(szx_rocc_counters_t *counters, int clear) {
+    for (int i = 0; i < SZX_COUNTER_EVENTS; i++)
+        counters->events[i] = szx_read_counter(i, 0);
+    for (int s = 0; s < SZX_COUNTER_STATES; s++)
+        counters->stateCycles[s] = szx_read_counter(SZX_COUNTER_STATE(s), 0);
+    for (int s = 0; s < SZX_COUNTER_LOAD_STATES; s++)
+        counters->loadStateCycles[s] = szx_read_counter(SZX_COUNTER_LOAD_STATE(s), 0);
+    if (clear)
+        szx_read_counter(0, 1);
+}
+
+static void printShare(FILE *f, const char *name, uint64_t cycles, uint64_t busy) {
+    fprintf(f, "  %-22s %14lu cycles  %3lu%%\n", name, (unsigned long) cycles,
+            (unsigned long) (busy ? cycles * 100 / busy : 0));
+}
+
+void SZx_rocc_print_counters(FILE *f, const szx_rocc_counters_t *counters) {
+    static const char *stateNames[SZX_COUNTER_STATES] = {
+        "idle", "process block", "store result", "complete", "wait response", "load data", "get result",
+        "bulk load", "wait load", "multi", "write back"
+    };
+    static const char *loadStateNames[SZX_COUNTER_LOAD_STATES] = {
+        "idle", "fetch descriptor", "wait descriptor", "load", "wait load", "stats"
+    };
+    const uint64_t *e = counters->events;
+    uint64_t busy = e[SZX_COUNTER_BUSY_CYCLES];
+
+    fprintf(f, "=== RoCC Accelerator Counters ===\n");
+    fprintf(f, "Busy cycles: %lu\n", (unsigned long) busy);
+    fprintf(f, "Blocks: %lu (%lu constant)\n", (unsigned long) e[SZX_COUNTER_BLOCKS],
+            (unsigned long) e[SZX_COUNTER_CONSTANT_BLOCKS]);
+    fprintf(f, "Bytes in: %lu, bytes out: %lu\n", (unsigned long) e[SZX_COUNTER_BYTES_IN],
+            (unsigned long) e[SZX_COUNTER_BYTES_OUT]);
+    fprintf(f, "Memory: %lu loads, %lu stores\n", (unsigned long) e[SZX_COUNTER_MEM_LOADS],
+            (unsigned long) e[SZX_COUNTER_MEM_STORES]);
+    if (e[SZX_COUNTER_BLOCKS] > 0)
+        fprintf(f, "Busy cycles per block: %lu\n", (unsigned long) (busy / e[SZX_COUNTER_BLOCKS]));
+    printShare(f, "memory stalls", e[SZX_COUNTER_MEM_STALL_CYCLES], busy);
+    printShare(f, "block processor", e[SZX_COUNTER_PROCESSOR_CYCLES], busy);
+    printShare(f, "loader", e[SZX_COUNTER_LOADER_CYCLES], busy);
+    printShare(f, "writer", e[SZX_COUNTER_WRITER_CYCLES], busy);
+    fprintf(f, "Command states (share of the busy cycles):\n");
+    for (int s = 1; s < SZX_COUNTER_STATES; s++) // idle is not busy
+        if (counters->stateCycles[s] > 0)
+            printShare(f, stateNames[s], counters->stateCycles[s], busy);
+    fprintf(f, "Load stage states (summed over the load units):\n");
+    for (int s = 1; s < SZX_COUNTER_LOAD_STATES; s++)
+        if (counters->loadStateCycles[s] > 0)
+            printShare(f, loadStateNames[s], counters->loadStateCycles[s], busy);
+}
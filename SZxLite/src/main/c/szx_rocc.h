@@ -2,8 +2,27 @@
 #define SZX_ROCC_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 1 (default): the accelerator computes the block stats and the constant-block decision (SZX_COMPRESS_ARRAY);
+// 0: the host computes them and passes them with each block (SZX_COMPRESS_MULTI)
+extern int g_rocc_hardware_stats;
 
 // Hardware-accelerated compression function using RoCC
 unsigned char* SZx_compress_float_rocc(float *oriData, size_t *outSize, float absErrBound, size_t nbEle, int blockSize);
 
+// The accelerator's performance counters (SZX_READ_COUNTER), indexed by SZX_COUNTER_*
+typedef struct {
+    uint64_t events[11];
+    uint64_t stateCycles[11];     // command state machine: idle, process, store, complete, response, load data,
+                                  // get result, bulk load, wait load, multi, write back
+    uint64_t loadStateCycles[6];  // load stage, summed over its units: idle, fetch descriptor, wait descriptor,
+                                  // load, wait load, stats
+} szx_rocc_counters_t;
+
+// Reads all counters; with clear set they restart from 0
+void SZx_rocc_read_counters(szx_rocc_counters_t *counters, int clear);
+void SZx_rocc_print_counters(FILE *f, const szx_rocc_counters_t *counters);
+
 #endif // SZX_ROCC_H
@@ -0,0 +1,493 @@
+#include <stdint.h>
+#include <string.h>
+#include "szx_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SZX_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SZX_SIMD_NEON 1
+#endif
+
+/*
+ * The kernels compute 8 (AVX2), 16 (AVX-512) or 4 (NEON) elements at a time:
+ * subtract the median, shift, XOR with the previous element, and classify the
+ * XOR result into the 2-bit leading-byte number with three compares.
+ *
+ * The leading numbers of 4 consecutive elements form an 8-bit index (packed
+ * the same way as leadNumberArray, ln0 in the top two bits), which selects a
+ * precomputed byte shuffle. The shuffle gathers the residual bytes of those
+ * 4 elements from one 128-bit register in the order the scalar loop stores them
+ * and packs them to the front. One unaligned 16-byte store then advances the
+ * output by the number of valid bytes (the stream compaction).
+ */
+
+typedef struct {
+    uint8_t shuf[256][16]; // pshufb/tbl control per 4-element leading-number index
+    uint8_t len[256];      // number of residual bytes produced by those 4 elements
+    size_t maxLen;         // len[0], i.e. 4 * reqBytesLength
+} residual_lut_t;
+
+static residual_lut_t residualLUT[3]; // reqBytesLength 2, 3 and 4
+
+/*same for doubles: 2 elements per 128-bit register, so a 4-bit index (ln0 in the top two bits)*/
+typedef struct {
+    uint8_t shuf[16][16];
+    uint8_t len[16];
+    size_t maxLen;         // len[0], i.e. 2 * reqBytesLength
+} residual_lut_double_t;
+
+static residual_lut_double_t residualLUTDouble[7]; // reqBytesLength 2 to 8
+static uint32_t leadNumberBytes[256]; // the 4 leading numbers of an index, one byte each
+static uint8_t spreadMSB[16];         // bit j of a 4-lane mask -> bit 6-2j
+
+/*the residual bytes (as lfloat.byte[] / ldouble.byte[] indices) that the scalar loop stores for one element
+ * of wordBytes bytes: the non-leading bytes among the top reqBytesLength ones, lowest first*/
+static int residualByteOrder(int wordBytes, int reqBytesLength, int leadingNum, int *byteIdx)
+{
+    int k, n = reqBytesLength - leadingNum;
+    for (k = 0; k < n; k++)
+        byteIdx[k] = wordBytes - reqBytesLength + k;
+    return n > 0 ? n : 0;
+}
+
+static void buildTables(void)
+{
+    int m, idx, j, k;
+    for (idx = 0; idx < 16; idx++) {
+        spreadMSB[idx] = 0;
+        for (j = 0; j < 4; j++)
+            spreadMSB[idx] |= ((idx >> j) & 1) << (6 - 2 * j);
+    }
+    for (idx = 0; idx < 256; idx++) {
+        uint8_t lns[4];
+        for (j = 0; j < 4; j++)
+            lns[j] = (idx >> (6 - 2 * j)) & 3;
+        memcpy(&leadNumberBytes[idx], lns, 4);
+    }
+    for (m = 0; m < 3; m++) {
+        for (idx = 0; idx < 256; idx++) {
+            int pos = 0;
+            memset(residualLUT[m].shuf[idx], 0x80, 16); // 0x80 zeroes the byte (pshufb and tbl)
+            for (j = 0; j < 4; j++) {
+                int byteIdx[4];
+                int n = residualByteOrder(4, m + 2, (idx >> (6 - 2 * j)) & 3, byteIdx);
+                for (k = 0; k < n; k++)
+                    residualLUT[m].shuf[idx][pos++] = (uint8_t) (4 * j + byteIdx[k]);
+            }
+            residualLUT[m].len[idx] = (uint8_t) pos;
+        }
+        residualLUT[m].maxLen = residualLUT[m].len[0];
+    }
+    for (m = 0; m < 7; m++) {
+        for (idx = 0; idx < 16; idx++) {
+            int pos = 0;
+            memset(residualLUTDouble[m].shuf[idx], 0x80, 16);
+            for (j = 0; j < 2; j++) {
+                int byteIdx[8];
+                int n = residualByteOrder(8, m + 2, (idx >> (2 - 2 * j)) & 3, byteIdx);
+                for (k = 0; k < n; k++)
+                    residualLUTDouble[m].shuf[idx][pos++] = (uint8_t) (8 * j + byteIdx[k]);
+            }
+            residualLUTDouble[m].len[idx] = (uint8_t) pos;
+        }
+        residualLUTDouble[m].maxLen = residualLUTDouble[m].len[0];
+    }
+}
+
+#ifdef SZX_SIMD_X86
+
+__attribute__((target("avx2")))
+static size_t xor_float_avx2(const float *oriData, size_t nbEle, float medianValue, int rightShiftBits,
+                             const residual_lut_t *lut, unsigned int *prevValue,
+                             unsigned char *leadNumberArray_int, unsigned char *dst, unsigned char *end,
+                             unsigned char **dstOut)
+{
+    const __m256 med = _mm256_set1_ps(medianValue);
+    const __m128i shift = _mm_cvtsi32_si128(rightShiftBits);
+    const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i last = _mm256_set1_epi32(7);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = _mm256_set1_epi32((int) *prevValue);
+    size_t i = 0;
+
+    // the second store lands at most maxLen bytes after dst
+    for (; i + 8 <= nbEle && (size_t) (end - dst) >= lut->maxLen + 16; i += 8) {
+        __m256 v = _mm256_sub_ps(_mm256_loadu_ps(oriData + i), med);
+        __m256i cur = _mm256_srl_epi32(_mm256_castps_si256(v), shift);
+        __m256i pre = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(cur, rotate), carry, 0x01);
+        __m256i x = _mm256_xor_si256(cur, pre);
+
+        unsigned ge3 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_srli_epi32(x, 8), zero)));
+        unsigned ge2 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_srli_epi32(x, 16), zero)));
+        unsigned ge1 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_srli_epi32(x, 24), zero)));
+        unsigned bit0 = ge1 ^ ge2 ^ ge3, bit1 = ge2;
+        unsigned idx0 = spreadMSB[bit0 & 15] | spreadMSB[bit1 & 15] << 1;
+        unsigned idx1 = spreadMSB[bit0 >> 4] | spreadMSB[bit1 >> 4] << 1;
+
+        memcpy(leadNumberArray_int + i, &leadNumberBytes[idx0], 4);
+        memcpy(leadNumberArray_int + i + 4, &leadNumberBytes[idx1], 4);
+
+        __m128i lo = _mm_shuffle_epi8(_mm256_castsi256_si128(cur), _mm_loadu_si128((const __m128i *) lut->shuf[idx0]));
+        __m128i hi = _mm_shuffle_epi8(_mm256_extracti128_si256(cur, 1), _mm_loadu_si128((const __m128i *) lut->shuf[idx1]));
+        _mm_storeu_si128((__m128i *) dst, lo);
+        dst += lut->len[idx0];
+        _mm_storeu_si128((__m128i *) dst, hi);
+        dst += lut->len[idx1];
+
+        carry = _mm256_permutevar8x32_epi32(cur, last);
+    }
+
+    *prevValue = (unsigned int) _mm_cvtsi128_si32(_mm256_castsi256_si128(carry));
+    *dstOut = dst;
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t xor_float_avx512(const float *oriData, size_t nbEle, float medianValue, int rightShiftBits,
+                               const residual_lut_t *lut, unsigned int *prevValue,
+                               unsigned char *leadNumberArray_int, unsigned char *dst, unsigned char *end,
+                               unsigned char **dstOut)
+{
+    const __m512 med = _mm512_set1_ps(medianValue);
+    const __m128i shift = _mm_cvtsi32_si128(rightShiftBits);
+    const __m512i rotate = _mm512_setr_epi32(15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14);
+    const __m512i last = _mm512_set1_epi32(15);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i carry = _mm512_set1_epi32((int) *prevValue);
+    size_t i = 0;
+
+    // the fourth store lands at most 3 * maxLen bytes after dst
+    for (; i + 16 <= nbEle && (size_t) (end - dst) >= 3 * lut->maxLen + 16; i += 16) {
+        __m512 v = _mm512_sub_ps(_mm512_loadu_ps(oriData + i), med);
+        __m512i cur = _mm512_srl_epi32(_mm512_castps_si512(v), shift);
+        __m512i pre = _mm512_mask_blend_epi32(0x0001, _mm512_permutexvar_epi32(rotate, cur), carry);
+        __m512i x = _mm512_xor_si512(cur, pre);
+
+        unsigned ge3 = _mm512_cmpeq_epi32_mask(_mm512_srli_epi32(x, 8), zero);
+        unsigned ge2 = _mm512_cmpeq_epi32_mask(_mm512_srli_epi32(x, 16), zero);
+        unsigned ge1 = _mm512_cmpeq_epi32_mask(_mm512_srli_epi32(x, 24), zero);
+        unsigned bit0 = ge1 ^ ge2 ^ ge3, bit1 = ge2;
+        unsigned idx[4];
+        __m128i lanes[4];
+        int q;
+
+        lanes[0] = _mm512_extracti32x4_epi32(cur, 0);
+        lanes[1] = _mm512_extracti32x4_epi32(cur, 1);
+        lanes[2] = _mm512_extracti32x4_epi32(cur, 2);
+        lanes[3] = _mm512_extracti32x4_epi32(cur, 3);
+        for (q = 0; q < 4; q++) {
+            idx[q] = spreadMSB[(bit0 >> (4 * q)) & 15] | spreadMSB[(bit1 >> (4 * q)) & 15] << 1;
+            memcpy(leadNumberArray_int + i + 4 * q, &leadNumberBytes[idx[q]], 4);
+        }
+        for (q = 0; q < 4; q++) {
+            __m128i r = _mm_shuffle_epi8(lanes[q], _mm_loadu_si128((const __m128i *) lut->shuf[idx[q]]));
+            _mm_storeu_si128((__m128i *) dst, r);
+            dst += lut->len[idx[q]];
+        }
+
+        carry = _mm512_permutexvar_epi32(last, cur);
+    }
+
+    *prevValue = (unsigned int) _mm_cvtsi128_si32(_mm512_castsi512_si128(carry));
+    *dstOut = dst;
+    return i;
+}
+
+/*double kernels: the leading-number index of 4 elements is built as for floats, and each half of it
+ *(2 elements, one 128-bit register) selects the shuffle*/
+__attribute__((target("avx2")))
+static size_t xor_double_avx2(const double *oriData, size_t nbEle, double medianValue, int rightShiftBits,
+                              const residual_lut_double_t *lut, uint64_t *prevValue,
+                              unsigned char *leadNumberArray_int, unsigned char *dst, unsigned char *end,
+                              unsigned char **dstOut)
+{
+    const __m256d med = _mm256_set1_pd(medianValue);
+    const __m128i shift = _mm_cvtsi32_si128(rightShiftBits);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = _mm256_set1_epi64x((long long) *prevValue);
+    size_t i = 0;
+
+    // the second store lands at most maxLen bytes after dst
+    for (; i + 4 <= nbEle && (size_t) (end - dst) >= lut->maxLen + 16; i += 4) {
+        __m256d v = _mm256_sub_pd(_mm256_loadu_pd(oriData + i), med);
+        __m256i cur = _mm256_srl_epi64(_mm256_castpd_si256(v), shift);
+        __m256i pre = _mm256_blend_epi32(_mm256_permute4x64_epi64(cur, 0x93), carry, 0x03);
+        __m256i x = _mm256_xor_si256(cur, pre);
+
+        unsigned ge3 = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_srli_epi64(x, 40), zero)));
+        unsigned ge2 = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_srli_epi64(x, 48), zero)));
+        unsigned ge1 = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_srli_epi64(x, 56), zero)));
+        unsigned idx = spreadMSB[ge1 ^ ge2 ^ ge3] | spreadMSB[ge2] << 1;
+
+        memcpy(leadNumberArray_int + i, &leadNumberBytes[idx], 4);
+
+        __m128i lo = _mm_shuffle_epi8(_mm256_castsi256_si128(cur), _mm_loadu_si128((const __m128i *) lut->shuf[idx >> 4]));
+        __m128i hi = _mm_shuffle_epi8(_mm256_extracti128_si256(cur, 1), _mm_loadu_si128((const __m128i *) lut->shuf[idx & 15]));
+        _mm_storeu_si128((__m128i *) dst, lo);
+        dst += lut->len[idx >> 4];
+        _mm_storeu_si128((__m128i *) dst, hi);
+        dst += lut->len[idx & 15];
+
+        carry = _mm256_permute4x64_epi64(cur, 0xFF);
+    }
+
+    *prevValue = (uint64_t) _mm_cvtsi128_si64(_mm256_castsi256_si128(carry));
+    *dstOut = dst;
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t xor_double_avx512(const double *oriData, size_t nbEle, double medianValue, int rightShiftBits,
+                                const residual_lut_double_t *lut, uint64_t *prevValue,
+                                unsigned char *leadNumberArray_int, unsigned char *dst, unsigned char *end,
+                                unsigned char **dstOut)
+{
+    const __m512d med = _mm512_set1_pd(medianValue);
+    const __m128i shift = _mm_cvtsi32_si128(rightShiftBits);
+    const __m512i rotate = _mm512_setr_epi64(7, 0, 1, 2, 3, 4, 5, 6);
+    const __m512i last = _mm512_set1_epi64(7);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i carry = _mm512_set1_epi64((long long) *prevValue);
+    size_t i = 0;
+
+    // the fourth store lands at most 3 * maxLen bytes after dst
+    for (; i + 8 <= nbEle && (size_t) (end - dst) >= 3 * lut->maxLen + 16; i += 8) {
+        __m512d v = _mm512_sub_pd(_mm512_loadu_pd(oriData + i), med);
+        __m512i cur = _mm512_srl_epi64(_mm512_castpd_si512(v), shift);
+        __m512i pre = _mm512_mask_blend_epi64(0x01, _mm512_permutexvar_epi64(rotate, cur), carry);
+        __m512i x = _mm512_xor_si512(cur, pre);
+
+        unsigned ge3 = _mm512_cmpeq_epi64_mask(_mm512_srli_epi64(x, 40), zero);
+        unsigned ge2 = _mm512_cmpeq_epi64_mask(_mm512_srli_epi64(x, 48), zero);
+        unsigned ge1 = _mm512_cmpeq_epi64_mask(_mm512_srli_epi64(x, 56), zero);
+        unsigned bit0 = ge1 ^ ge2 ^ ge3, bit1 = ge2;
+        unsigned idx0 = spreadMSB[bit0 & 15] | spreadMSB[bit1 & 15] << 1;
+        unsigned idx1 = spreadMSB[bit0 >> 4] | spreadMSB[bit1 >> 4] << 1;
+        unsigned sub[4] = {idx0 >> 4, idx0 & 15, idx1 >> 4, idx1 & 15};
+        __m128i lanes[4];
+        int q;
+
+        memcpy(leadNumberArray_int + i, &leadNumberBytes[idx0], 4);
+        memcpy(leadNumberArray_int + i + 4, &leadNumberBytes[idx1], 4);
+
+        lanes[0] = _mm512_extracti32x4_epi32(cur, 0);
+        lanes[1] = _mm512_extracti32x4_epi32(cur, 1);
+        lanes[2] = _mm512_extracti32x4_epi32(cur, 2);
+        lanes[3] = _mm512_extracti32x4_epi32(cur, 3);
+        for (q = 0; q < 4; q++) {
+            __m128i r = _mm_shuffle_epi8(lanes[q], _mm_loadu_si128((const __m128i *) lut->shuf[sub[q]]));
+            _mm_storeu_si128((__m128i *) dst, r);
+            dst += lut->len[sub[q]];
+        }
+
+        carry = _mm512_permutexvar_epi64(last, cur);
+    }
+
+    *prevValue = (uint64_t) _mm_cvtsi128_si64(_mm512_castsi512_si128(carry));
+    *dstOut = dst;
+    return i;
+}
+
+#endif // SZX_SIMD_X86
+
+#ifdef SZX_SIMD_NEON
+
+static size_t xor_float_neon(const float *oriData, size_t nbEle, float medianValue, int rightShiftBits,
+                             const residual_lut_t *lut, unsigned int *prevValue,
+                             unsigned char *leadNumberArray_int, unsigned char *dst, unsigned char *end,
+                             unsigned char **dstOut)
+{
+    static const uint32_t laneBits[4] = {1, 2, 4, 8};
+    const float32x4_t med = vdupq_n_f32(medianValue);
+    const int32x4_t shift = vdupq_n_s32(-rightShiftBits);
+    const uint32x4_t bits = vld1q_u32(laneBits);
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t carry = vdupq_n_u32(*prevValue);
+    size_t i = 0;
+
+    for (; i + 4 <= nbEle && (size_t) (end - dst) >= 16; i += 4) {
+        float32x4_t v = vsubq_f32(vld1q_f32(oriData + i), med);
+        uint32x4_t cur = vshlq_u32(vreinterpretq_u32_f32(v), shift);
+        uint32x4_t x = veorq_u32(cur, vextq_u32(carry, cur, 3));
+
+        unsigned ge3 = vaddvq_u32(vandq_u32(vceqq_u32(vshrq_n_u32(x, 8), zero), bits));
+        unsigned ge2 = vaddvq_u32(vandq_u32(vceqq_u32(vshrq_n_u32(x, 16), zero), bits));
+        unsigned ge1 = vaddvq_u32(vandq_u32(vceqq_u32(vshrq_n_u32(x, 24), zero), bits));
+        unsigned idx = spreadMSB[ge1 ^ ge2 ^ ge3] | spreadMSB[ge2] << 1;
+
+        memcpy(leadNumberArray_int + i, &leadNumberBytes[idx], 4);
+        vst1q_u8(dst, vqtbl1q_u8(vreinterpretq_u8_u32(cur), vld1q_u8(lut->shuf[idx])));
+        dst += lut->len[idx];
+
+        carry = cur;
+    }
+
+    *prevValue = vgetq_lane_u32(carry, 3);
+    *dstOut = dst;
+    return i;
+}
+
+static size_t xor_double_neon(const double *oriData, size_t nbEle, double medianValue, int rightShiftBits,
+                              const residual_lut_double_t *lut, uint64_t *prevValue,
+                              unsigned char *leadNumberArray_int, unsigned char *dst, unsigned char *end,
+                              unsigned char **dstOut)
+{
+    const float64x2_t med = vdupq_n_f64(medianValue);
+    const int64x2_t shift = vdupq_n_s64(-rightShiftBits);
+    const uint64x2_t zero = vdupq_n_u64(0);
+    uint64x2_t carry = vdupq_n_u64(*prevValue);
+    size_t i = 0;
+
+    for (; i + 2 <= nbEle && (size_t) (end - dst) >= 16; i += 2) {
+        float64x2_t v = vsubq_f64(vld1q_f64(oriData + i), med);
+        uint64x2_t cur = vshlq_u64(vreinterpretq_u64_f64(v), shift);
+        uint64x2_t x = veorq_u64(cur, vextq_u64(carry, cur, 1));
+
+        uint64x2_t m3 = vceqq_u64(vshrq_n_u64(x, 40), zero);
+        uint64x2_t m2 = vceqq_u64(vshrq_n_u64(x, 48), zero);
+        uint64x2_t m1 = vceqq_u64(vshrq_n_u64(x, 56), zero);
+        unsigned ge3 = (vgetq_lane_u64(m3, 0) & 1) | (vgetq_lane_u64(m3, 1) & 2);
+        unsigned ge2 = (vgetq_lane_u64(m2, 0) & 1) | (vgetq_lane_u64(m2, 1) & 2);
+        unsigned ge1 = (vgetq_lane_u64(m1, 0) & 1) | (vgetq_lane_u64(m1, 1) & 2);
+        unsigned idx = (spreadMSB[ge1 ^ ge2 ^ ge3] | spreadMSB[ge2] << 1) >> 4;
+
+        leadNumberArray_int[i] = idx >> 2;
+        leadNumberArray_int[i + 1] = idx & 3;
+        vst1q_u8(dst, vqtbl1q_u8(vreinterpretq_u8_u64(cur), vld1q_u8(lut->shuf[idx])));
+        dst += lut->len[idx];
+
+        carry = cur;
+    }
+
+    *prevValue = vgetq_lane_u64(carry, 1);
+    *dstOut = dst;
+    return i;
+}
+
+#endif // SZX_SIMD_NEON
+
+static int detectedLevel = SZx_SIMD_NONE;
+static int activeLevel = SZx_SIMD_NONE;
+
+__attribute__((constructor))
+static void SZx_simd_init(void)
+{
+    buildTables();
+#ifdef SZX_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        detectedLevel = SZx_SIMD_AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        detectedLevel = SZx_SIMD_AVX2;
+#elif defined(SZX_SIMD_NEON)
+    detectedLevel = SZx_SIMD_NEON;
+#endif
+    activeLevel = detectedLevel;
+}
+
+int SZx_simd_detect(void)
+{
+    return detectedLevel;
+}
+
+int SZx_simd_level(void)
+{
+    return activeLevel;
+}
+
+void SZx_set_simd_level(int level)
+{
+    activeLevel = level < detectedLevel ? level : detectedLevel;
+#ifdef SZX_SIMD_X86
+    if (activeLevel == SZx_SIMD_NEON)
+        activeLevel = SZx_SIMD_NONE;
+#endif
+}
+
+const char *SZx_simd_name(int level)
+{
+    switch (level) {
+    case SZx_SIMD_NEON:   return "neon";
+    case SZx_SIMD_AVX2:   return "avx2";
+    case SZx_SIMD_AVX512: return "avx512";
+    default:              return "scalar";
+    }
+}
+
+size_t SZx_compress_xor_float_simd(const float *oriData, size_t nbEle, float medianValue,
+                                   int rightShiftBits, int reqBytesLength, unsigned int *prevValue,
+                                   unsigned char *leadNumberArray_int, unsigned char *exactMidbyteArray,
+                                   size_t *residualMidBytes_size)
+{
+    if (reqBytesLength < 2 || reqBytesLength > 4)
+        return 0;
+
+    const residual_lut_t *lut = &residualLUT[reqBytesLength - 2];
+    unsigned char *dst = exactMidbyteArray + *residualMidBytes_size;
+    unsigned char *end = exactMidbyteArray + (size_t) reqBytesLength * nbEle;
+    size_t n = 0;
+
+    switch (activeLevel) {
+#ifdef SZX_SIMD_X86
+    case SZx_SIMD_AVX512:
+        n = xor_float_avx512(oriData, nbEle, medianValue, rightShiftBits, lut, prevValue,
+                             leadNumberArray_int, dst, end, &dst);
+        break;
+    case SZx_SIMD_AVX2:
+        n = xor_float_avx2(oriData, nbEle, medianValue, rightShiftBits, lut, prevValue,
+                           leadNumberArray_int, dst, end, &dst);
+        break;
+#endif
+#ifdef SZX_SIMD_NEON
+    case SZx_SIMD_NEON:
+        n = xor_float_neon(oriData, nbEle, medianValue, rightShiftBits, lut, prevValue,
+                           leadNumberArray_int, dst, end, &dst);
+        break;
+#endif
+    default:
+        return 0;
+    }
+
+    *residualMidBytes_size = dst - exactMidbyteArray;
+    return n;
+}
+
+size_t SZx_compress_xor_double_simd(const double *oriData, size_t nbEle, double medianValue,
+                                    int rightShiftBits, int reqBytesLength, uint64_t *prevValue,
+                                    unsigned char *leadNumberArray_int, unsigned char *exactMidbyteArray,
+                                    size_t *residualMidBytes_size)
+{
+    if (reqBytesLength < 2 || reqBytesLength > 8)
+        return 0;
+
+    const residual_lut_double_t *lut = &residualLUTDouble[reqBytesLength - 2];
+    unsigned char *dst = exactMidbyteArray + *residualMidBytes_size;
+    unsigned char *end = exactMidbyteArray + (size_t) reqBytesLength * nbEle;
+    size_t n = 0;
+
+    switch (activeLevel) {
+#ifdef SZX_SIMD_X86
+    case SZx_SIMD_AVX512:
+        n = xor_double_avx512(oriData, nbEle, medianValue, rightShiftBits, lut, prevValue,
+                              leadNumberArray_int, dst, end, &dst);
+        break;
+    case SZx_SIMD_AVX2:
+        n = xor_double_avx2(oriData, nbEle, medianValue, rightShiftBits, lut, prevValue,
+                            leadNumberArray_int, dst, end, &dst);
+        break;
+#endif
+#ifdef SZX_SIMD_NEON
+    case SZx_SIMD_NEON:
+        n = xor_double_neon(oriData, nbEle, medianValue, rightShiftBits, lut, prevValue,
+                            leadNumberArray_int, dst, end, &dst);
+        break;
+#endif
+    default:
+        return 0;
+    }
+
+    *residualMidBytes_size = dst - exactMidbyteArray;
+    return n;
+}
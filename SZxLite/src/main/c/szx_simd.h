@@ -0,0 +1,45 @@
+#ifndef SZX_SIMD_H
+#define SZX_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SZx_SIMD_NONE   0
+#define SZx_SIMD_NEON   1
+#define SZx_SIMD_AVX2   2
+#define SZx_SIMD_AVX512 3
+
+// Highest kernel level supported by the running CPU (detected once at load time)
+int SZx_simd_detect(void);
+// Kernel level currently in use, and a way to cap it (e.g. SZx_SIMD_NONE to force the scalar loop)
+int SZx_simd_level(void);
+void SZx_set_simd_level(int level);
+const char *SZx_simd_name(int level);
+
+// Vectorized subtract/shift/XOR + leading-byte loop of SZx_compress_one_block_float_sw for
+// reqBytesLength 2 to 4. It fills leadNumberArray_int[0..k) and appends the residual bytes of
+// those k elements at exactMidbyteArray + *residualMidBytes_size, where k (the return value) is
+// the number of elements handled; the caller finishes elements k..nbEle-1 with the scalar loop.
+// *prevValue carries the shifted value of the element before the first one, and is updated
+// to the shifted value of element k-1. Writes never go past the block's worst-case residual
+// area (reqBytesLength * nbEle bytes).
+size_t SZx_compress_xor_float_simd(const float *oriData, size_t nbEle, float medianValue,
+                                   int rightShiftBits, int reqBytesLength, unsigned int *prevValue,
+                                   unsigned char *leadNumberArray_int, unsigned char *exactMidbyteArray,
+                                   size_t *residualMidBytes_size);
+
+// Same for SZx_compress_one_block_double_sw (reqBytesLength 2 to 8, 64-bit leading numbers)
+size_t SZx_compress_xor_double_simd(const double *oriData, size_t nbEle, double medianValue,
+                                    int rightShiftBits, int reqBytesLength, uint64_t *prevValue,
+                                    unsigned char *leadNumberArray_int, unsigned char *exactMidbyteArray,
+                                    size_t *residualMidBytes_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SZX_SIMD_H
@@ -0,0 +1,106 @@
+#include "define.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include "szx.h"
+#include "szx_stream.h"
+
+/*compress nbEle values into one frame and hand it to the write callback*/
+static int writeFrame_float(SZx_stream_float *stream, const float *data, size_t nbEle)
+{
+    size_t cmpSize = 0;
+    unsigned char header[SZx_FRAME_HEADER_SIZE];
+    unsigned char *cmpBytes = SZx_compress_float_ctx(&stream->ctx, (float *) data, &cmpSize, stream->absErrBound,
+                                                     nbEle, stream->blockSize, stream->nbThreads, NULL, 0);
+    if (cmpBytes == NULL)
+        return SZx_FERR;
+
+    sizeToBytes(header, nbEle);
+    sizeToBytes(header + sizeof(size_t), cmpSize);
+    int status = stream->write(header, SZx_FRAME_HEADER_SIZE, stream->userData);
+    if (status == SZx_SCES)
+        status = stream->write(cmpBytes, cmpSize, stream->userData);
+
+    stream->totalOutSize += SZx_FRAME_HEADER_SIZE + cmpSize;
+    stream->nbFrames++;
+    return status;
+}
+
+int SZx_stream_init_float(SZx_stream_float *stream, float absErrBound, int blockSize, size_t frameBlocks,
+                          int nbThreads, SZx_stream_write_fn write, void *userData)
+{
+    memset(stream, 0, sizeof(SZx_stream_float));
+    if (!SZx_validBlockSize(blockSize, sizeof(float)) || frameBlocks == 0 || write == NULL)
+        return SZx_FERR;
+
+    stream->absErrBound = absErrBound;
+    stream->blockSize = blockSize;
+    stream->nbThreads = nbThreads;
+    stream->frameNBEle = frameBlocks * blockSize;
+    stream->write = write;
+    stream->userData = userData;
+    SZx_init_context(&stream->ctx);
+    stream->frame = (float *) malloc(stream->frameNBEle * sizeof(float));
+    return stream->frame == NULL ? SZx_FERR : SZx_SCES;
+}
+
+int SZx_stream_push_float(SZx_stream_float *stream, const float *data, size_t nbEle)
+{
+    int status = SZx_SCES;
+    stream->totalNBEle += nbEle;
+
+    //top up a partially filled frame first
+    if (stream->frameFill > 0) {
+        size_t n = stream->frameNBEle - stream->frameFill;
+        if (n > nbEle)
+            n = nbEle;
+        memcpy(stream->frame + stream->frameFill, data, n * sizeof(float));
+        stream->frameFill += n;
+        data += n;
+        nbEle -= n;
+        if (stream->frameFill < stream->frameNBEle)
+            return SZx_SCES;
+        status = writeFrame_float(stream, stream->frame, stream->frameNBEle);
+        stream->frameFill = 0;
+    }
+
+    //whole frames are compressed straight from the caller's buffer
+    for (; status == SZx_SCES && nbEle >= stream->frameNBEle; data += stream->frameNBEle, nbEle -= stream->frameNBEle)
+        status = writeFrame_float(stream, data, stream->frameNBEle);
+
+    if (status == SZx_SCES && nbEle > 0) {
+        memcpy(stream->frame, data, nbEle * sizeof(float));
+        stream->frameFill = nbEle;
+    }
+    return status;
+}
+
+int SZx_stream_finish_float(SZx_stream_float *stream)
+{
+    int status = SZx_SCES;
+    if (stream->frameFill > 0)
+        status = writeFrame_float(stream, stream->frame, stream->frameFill);
+    stream->frameFill = 0;
+    free(stream->frame);
+    stream->frame = NULL;
+    SZx_free_context(&stream->ctx);
+    return status;
+}
+
+int SZx_stream_decompress_frame_float(float **newData, size_t *nbEle, unsigned char *frameBytes,
+                                      size_t bytesLength, size_t *frameSize)
+{
+    *newData = NULL;
+    if (bytesLength < SZx_FRAME_HEADER_SIZE)
+        return SZx_FERR;
+
+    *nbEle = bytesToSize(frameBytes);
+    size_t cmpSize = bytesToSize(frameBytes + sizeof(size_t));
+    if (cmpSize > bytesLength - SZx_FRAME_HEADER_SIZE)
+        return SZx_FERR;
+    *frameSize = SZx_FRAME_HEADER_SIZE + cmpSize;
+
+    SZx_decompress_float(newData, *nbEle, frameBytes + SZx_FRAME_HEADER_SIZE);
+    return *newData == NULL ? SZx_FERR : SZx_SCES;
+}
@@ -0,0 +1,62 @@
+#ifndef SZX_STREAM_H
+#define SZX_STREAM_H
+
+#include <stddef.h>
+#include "szx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming SZx compression for inputs that do not fit in memory.
+ *
+ * An SZx stream stores the number of constant blocks and the O[]/state arrays of
+ * all blocks ahead of the data, so a single stream cannot be written before the
+ * last block is known. The stream compressor therefore cuts the input into frames
+ * of frameBlocks blocks and compresses each frame as a standalone SZx stream as
+ * soon as it is full. Each frame is handed to the write callback as
+ *
+ *   [nbEle (8 bytes, big endian)][cmpSize (8 bytes, big endian)][SZx stream of nbEle values]
+ *
+ * and every frame but the last holds exactly frameBlocks * blockSize values.
+ * Memory is one frame of input plus one frame of output, whatever the stream length.
+ */
+
+#define SZx_FRAME_HEADER_SIZE 16
+
+// Consumes size bytes; returns SZx_SCES, or SZx_FERR to abort the stream
+typedef int (*SZx_stream_write_fn)(const unsigned char *bytes, size_t size, void *userData);
+
+typedef struct SZx_stream_float {
+    float absErrBound;
+    int blockSize;
+    int nbThreads;          // passed to SZx_compress_float_ctx
+    size_t frameNBEle;      // frameBlocks * blockSize
+    float *frame;           // values of the frame being filled
+    SZx_context ctx;        // compressed frames are built here, so steady-state frames do not allocate
+    size_t frameFill;
+    SZx_stream_write_fn write;
+    void *userData;
+    size_t totalNBEle;      // values pushed so far
+    size_t totalOutSize;    // bytes handed to write so far, frame headers included
+    size_t nbFrames;
+} SZx_stream_float;
+
+int SZx_stream_init_float(SZx_stream_float *stream, float absErrBound, int blockSize, size_t frameBlocks,
+                          int nbThreads, SZx_stream_write_fn write, void *userData);
+// Appends nbEle values; every frame completed by them is compressed and written before returning
+int SZx_stream_push_float(SZx_stream_float *stream, const float *data, size_t nbEle);
+// Writes the last (partial) frame and releases the context
+int SZx_stream_finish_float(SZx_stream_float *stream);
+
+// Decodes the frame at frameBytes (at least bytesLength bytes available). On success *newData holds the
+// *nbEle values (allocated here) and *frameSize is the number of bytes the frame takes, header included.
+int SZx_stream_decompress_frame_float(float **newData, size_t *nbEle, unsigned char *frameBytes,
+                                      size_t bytesLength, size_t *frameSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SZX_STREAM_H
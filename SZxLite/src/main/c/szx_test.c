@@ -0,0 +1,497 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "szx.h"
+#include "szx_stream.h"
+#include "szx_trace.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * Host regression tests of the software SZx path, run by ctest; also under OMP_THREAD_LIMIT=2.
+ * The block-parallel compressor must give the serial stream whatever team OpenMP grants it.
+ */
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);         \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+            failures++;                                         \
+        }                                                       \
+    } while (0)
+
+static float *testData_float(size_t nbEle)
+{
+    float *data = (float *) malloc(nbEle * sizeof(float));
+    size_t i;
+    srand(1);
+    for (i = 0; i < nbEle; i++)
+        data[i] = (float) (100 * sin(i / 500.0)) + (float) rand() / RAND_MAX;
+    return data;
+}
+
+/*compress with nbThreads, then check the stream against the serial one and the decoded error*/
+static void checkFloat(const char *what, float *data, size_t nbEle, float eb, int blockSize, int nbThreads)
+{
+    size_t refSize = 0, cmpSize = 0, i;
+    unsigned char *ref = SZx_compress_float(data, &refSize, eb, nbEle, blockSize);
+    unsigned char *cmp = SZx_compress_float_openmp(data, &cmpSize, eb, nbEle, blockSize, nbThreads);
+    CHECK(cmpSize == refSize && memcmp(cmp, ref, refSize) == 0,
+          "%s: float stream of %zu bytes, serial %zu bytes", what, cmpSize, refSize);
+
+    float *dec = NULL;
+    double maxErr = 0;
+    SZx_decompress_float(&dec, nbEle, cmp);
+    for (i = 0; i < nbEle; i++)
+        maxErr = fmax(maxErr, fabs((double) data[i] - dec[i]));
+    CHECK(maxErr <= eb, "%s: float max error %g over the bound %g", what, maxErr, eb);
+    free(dec);
+    free(cmp);
+    free(ref);
+}
+
+static void checkDouble(const char *what, double *data, size_t nbEle, double eb, int blockSize, int nbThreads)
+{
+    size_t refSize = 0, cmpSize = 0, i;
+    unsigned char *ref = SZx_compress_double(data, &refSize, eb, nbEle, blockSize);
+    unsigned char *cmp = SZx_compress_double_openmp(data, &cmpSize, eb, nbEle, blockSize, nbThreads);
+    CHECK(cmpSize == refSize && memcmp(cmp, ref, refSize) == 0,
+          "%s: double stream of %zu bytes, serial %zu bytes", what, cmpSize, refSize);
+
+    double *dec = NULL;
+    double maxErr = 0;
+    SZx_decompress_double(&dec, nbEle, cmp);
+    for (i = 0; i < nbEle; i++)
+        maxErr = fmax(maxErr, fabs(data[i] - dec[i]));
+    CHECK(maxErr <= eb, "%s: double max error %g over the bound %g", what, maxErr, eb);
+    free(dec);
+    free(cmp);
+    free(ref);
+}
+
+static void testTeamSize(void)
+{
+    size_t nbEle = 1000003, i;
+    float *data = testData_float(nbEle);
+    double *data64 = (double *) malloc(nbEle * sizeof(double));
+    for (i = 0; i < nbEle; i++)
+        data64[i] = data[i] + 1e-9 * (double) i;
+    checkFloat("8 threads", data, nbEle, 1e-3f, 64, 8);
+    checkFloat("3 threads", data, nbEle, 1e-3f, 128, 3);
+    checkDouble("8 threads", data64, nbEle, 1e-6, 64, 8);
+#ifdef _OPENMP
+    //an inner region without nesting gets a team of one
+    int saved = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+#pragma omp parallel num_threads(2)
+    {
+#pragma omp single
+        {
+            checkFloat("nested", data, nbEle, 1e-3f, 64, 8);
+            checkDouble("nested", data64, nbEle, 1e-6, 64, 8);
+        }
+    }
+    omp_set_max_active_levels(saved);
+
+    omp_set_dynamic(1);
+    checkFloat("dynamic", data, nbEle, 1e-3f, 64, 8);
+    checkDouble("dynamic", data64, nbEle, 1e-6, 64, 8);
+    omp_set_dynamic(0);
+#endif
+    free(data64);
+    free(data);
+}
+
+/*O[] stores every non-constant block size as a uint16_t: larger blocks are rejected, the largest one round trips*/
+static void testBlockSizeLimit(void)
+{
+    size_t nbEle = 100000, cmpSize = 1, i;
+    float *data = (float *) malloc(nbEle * sizeof(float));
+    double *data64 = (double *) malloc(nbEle * sizeof(double));
+    srand(2);
+    for (i = 0; i < nbEle; i++)
+        data64[i] = data[i] = (float) rand() / RAND_MAX; //random data compresses to the worst case
+
+    CHECK(SZx_compress_float(data, &cmpSize, 1e-7f, nbEle, 20000) == NULL && cmpSize == 0, "float block of 20000");
+    CHECK(SZx_compress_float_openmp(data, &cmpSize, 1e-7f, nbEle, 20000, 2) == NULL, "float openmp block of 20000");
+    CHECK(SZx_compress_double(data64, &cmpSize, 1e-7, nbEle, 10000) == NULL, "double block of 10000");
+    CHECK(SZx_compress_double_openmp(data64, &cmpSize, 1e-7, nbEle, 10000, 2) == NULL, "double openmp block of 10000");
+    CHECK(!SZx_validBlockSize(0, sizeof(float)), "empty blocks");
+
+    int bs = 1, bs64 = 1;
+    while (SZx_validBlockSize(bs + 1, sizeof(float)))
+        bs++;
+    while (SZx_validBlockSize(bs64 + 1, sizeof(double)))
+        bs64++;
+    CHECK(SZx_maxBlockBytes(bs, sizeof(float)) <= UINT16_MAX && SZx_maxBlockBytes(bs + 1, sizeof(float)) > UINT16_MAX,
+          "largest float block size %d", bs);
+    checkFloat("largest float block", data, nbEle, 1e-7f, bs, 1);
+    checkFloat("largest float block", data, nbEle, 1e-7f, bs, 2);
+    checkDouble("largest double block", data64, nbEle, 1e-12, bs64, 2);
+    free(data64);
+    free(data);
+}
+
+/*random access decode: block ranges, constant blocks and the last partial block among them, against the full decode*/
+static void testBlockRanges(void)
+{
+    size_t nbEle = 100003, cmpSize = 0, cmpSize64 = 0, i, r;
+    int blockSize = 128;
+    size_t nbBlocks = (nbEle + blockSize - 1) / blockSize; //the last one holds 35 values
+    float *data = testData_float(nbEle);
+    double *data64 = (double *) malloc(nbEle * sizeof(double));
+    for (i = 0; i < nbEle; i++) {
+        if (i / blockSize % 5 == 0)
+            data[i] = 1.5f; //constant blocks
+        data64[i] = data[i];
+    }
+    unsigned char *cmp = SZx_compress_float(data, &cmpSize, 1e-3f, nbEle, blockSize);
+    unsigned char *cmp64 = SZx_compress_double(data64, &cmpSize64, 1e-6, nbEle, blockSize);
+    float *full = NULL, *part = (float *) malloc(nbEle * sizeof(float));
+    double *full64 = NULL, *part64 = (double *) malloc(nbEle * sizeof(double));
+    SZx_decompress_float(&full, nbEle, cmp);
+    SZx_decompress_double(&full64, nbEle, cmp64);
+
+    size_t ranges[][2] = {{0, 1}, {0, nbBlocks}, {3, 17}, {5, 6}, {400, 650}, {nbBlocks - 40, nbBlocks},
+                          {nbBlocks - 1, nbBlocks}, {nbBlocks - 2, nbBlocks + 10}}; //the last one is clipped
+    for (r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        size_t lo = ranges[r][0], hi = ranges[r][1];
+        size_t from = lo * blockSize, to = hi * blockSize < nbEle ? hi * blockSize : nbEle;
+        CHECK(SZx_decompress_float_blocks(part, nbEle, cmp, lo, hi) == SZx_SCES &&
+              memcmp(part, full + from, (to - from) * sizeof(float)) == 0, "float blocks [%zu, %zu)", lo, hi);
+        CHECK(SZx_decompress_double_blocks(part64, nbEle, cmp64, lo, hi) == SZx_SCES &&
+              memcmp(part64, full64 + from, (to - from) * sizeof(double)) == 0, "double blocks [%zu, %zu)", lo, hi);
+    }
+
+    //empty ranges and ranges past the last block decode nothing
+    size_t empty[][2] = {{7, 7}, {9, 3}, {nbBlocks, nbBlocks + 1}, {nbBlocks + 5, nbBlocks + 9}};
+    for (r = 0; r < sizeof(empty) / sizeof(empty[0]); r++) {
+        part[0] = -7.0f;
+        part64[0] = -7.0;
+        CHECK(SZx_decompress_float_blocks(part, nbEle, cmp, empty[r][0], empty[r][1]) == SZx_SCES &&
+              part[0] == -7.0f, "float blocks [%zu, %zu)", empty[r][0], empty[r][1]);
+        CHECK(SZx_decompress_double_blocks(part64, nbEle, cmp64, empty[r][0], empty[r][1]) == SZx_SCES &&
+              part64[0] == -7.0, "double blocks [%zu, %zu)", empty[r][0], empty[r][1]);
+    }
+
+    //not an SZx stream
+    cmp[0] ^= 0xff;
+    CHECK(SZx_decompress_float_blocks(part, nbEle, cmp, 0, 1) == SZx_FERR, "float blocks of a bad stream");
+    cmp[0] ^= 0xff;
+    free(part64);
+    free(full64);
+    free(part);
+    free(full);
+    free(cmp64);
+    free(cmp);
+    free(data64);
+    free(data);
+}
+
+/*bytes handed to the stream's write callback*/
+typedef struct {
+    unsigned char *bytes;
+    size_t size, capacity;
+    int fail; //return SZx_FERR from the next write
+} testSink;
+
+static int testSink_write(const unsigned char *bytes, size_t size, void *userData)
+{
+    testSink *sink = (testSink *) userData;
+    if (sink->fail)
+        return SZx_FERR;
+    if (sink->size + size > sink->capacity) {
+        sink->capacity = 2 * (sink->size + size);
+        sink->bytes = (unsigned char *) realloc(sink->bytes, sink->capacity);
+    }
+    memcpy(sink->bytes + sink->size, bytes, size);
+    sink->size += size;
+    return SZx_SCES;
+}
+
+/*stream round trip with pushes that are not multiples of the frame or the block size: every frame is the stream
+ *SZx_compress_float gives for its values and the frames decode back to the input*/
+static void testStream(void)
+{
+    int blockSize = 64;
+    size_t frameBlocks = 16, frameNBEle = frameBlocks * blockSize;
+    size_t pushes[] = {1, 37, 1000, frameNBEle - 38, 0, 3 * frameNBEle + 5, 63, 2 * frameNBEle - 68, 777};
+    size_t nbEle = 0, i, p;
+    for (p = 0; p < sizeof(pushes) / sizeof(pushes[0]); p++)
+        nbEle += pushes[p];
+    float *data = testData_float(nbEle);
+    float eb = 1e-3f;
+
+    testSink sink = {NULL, 0, 0, 0};
+    SZx_stream_float stream;
+    CHECK(SZx_stream_init_float(&stream, eb, blockSize, frameBlocks, 2, testSink_write, &sink) == SZx_SCES,
+          "stream init");
+    for (p = 0, i = 0; p < sizeof(pushes) / sizeof(pushes[0]); i += pushes[p++])
+        CHECK(SZx_stream_push_float(&stream, data + i, pushes[p]) == SZx_SCES, "push of %zu values", pushes[p]);
+    size_t nbFrames = stream.nbFrames;
+    CHECK(SZx_stream_finish_float(&stream) == SZx_SCES, "stream finish");
+    CHECK(stream.nbFrames == (nbEle + frameNBEle - 1) / frameNBEle && stream.nbFrames == nbFrames + 1,
+          "%zu frames", stream.nbFrames);
+    CHECK(stream.totalNBEle == nbEle && stream.totalOutSize == sink.size, "stream totals");
+
+    size_t offset = 0, frame = 0;
+    i = 0;
+    while (offset < sink.size && frame < stream.nbFrames) {
+        float *dec = NULL;
+        size_t frameEle = 0, frameSize = 0, refSize = 0, k;
+        CHECK(SZx_stream_decompress_frame_float(&dec, &frameEle, sink.bytes + offset, sink.size - offset,
+                                                &frameSize) == SZx_SCES, "frame %zu", frame);
+        if (dec == NULL)
+            break;
+        CHECK(frameEle == (nbEle - i < frameNBEle ? nbEle - i : frameNBEle), "frame %zu of %zu values", frame,
+              frameEle);
+        unsigned char *ref = SZx_compress_float(data + i, &refSize, eb, frameEle, blockSize);
+        CHECK(frameSize == SZx_FRAME_HEADER_SIZE + refSize &&
+              memcmp(sink.bytes + offset + SZx_FRAME_HEADER_SIZE, ref, refSize) == 0, "frame %zu stream", frame);
+        double maxErr = 0;
+        for (k = 0; k < frameEle; k++)
+            maxErr = fmax(maxErr, fabs((double) data[i + k] - dec[k]));
+        CHECK(maxErr <= eb, "frame %zu max error %g", frame, maxErr);
+        free(ref);
+        free(dec);
+        offset += frameSize;
+        i += frameEle;
+        frame++;
+    }
+    CHECK(offset == sink.size && i == nbEle && frame == stream.nbFrames, "%zu of %zu values decoded", i, nbEle);
+
+    //an empty stream, and one of whole frames, write nothing more on finish
+    sink.size = 0;
+    CHECK(SZx_stream_init_float(&stream, eb, blockSize, frameBlocks, 1, testSink_write, &sink) == SZx_SCES &&
+          SZx_stream_finish_float(&stream) == SZx_SCES && stream.nbFrames == 0 && sink.size == 0, "empty stream");
+    SZx_stream_init_float(&stream, eb, blockSize, frameBlocks, 1, testSink_write, &sink);
+    SZx_stream_push_float(&stream, data, 2 * frameNBEle);
+    size_t size = sink.size;
+    CHECK(SZx_stream_finish_float(&stream) == SZx_SCES && stream.nbFrames == 2 && sink.size == size,
+          "stream of whole frames");
+
+    //a failing write aborts the stream
+    sink.fail = 1;
+    SZx_stream_init_float(&stream, eb, blockSize, frameBlocks, 1, testSink_write, &sink);
+    CHECK(SZx_stream_push_float(&stream, data, frameNBEle + 1) == SZx_FERR, "failing write");
+    SZx_stream_finish_float(&stream);
+    CHECK(SZx_stream_init_float(&stream, eb, 0, frameBlocks, 1, testSink_write, &sink) == SZx_FERR, "empty blocks");
+    free(sink.bytes);
+    free(data);
+}
+
+/*mapped input files: contents and length for both mapping modes; the huge page request is only a hint, so it
+ *must give the same mapping when the kernel ignores it*/
+static void testMapData(void)
+{
+    const char *path = "szx_test_map.bin", *emptyPath = "szx_test_map_empty.bin";
+    size_t nbEle = 300001, i;
+    float *data = testData_float(nbEle);
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL && fwrite(data, sizeof(float), nbEle, f) == nbEle && fputc(0x5a, f) != EOF, "writing %s", path);
+    if (f != NULL)
+        fclose(f);
+
+    int hugePages;
+    for (hugePages = 0; hugePages <= 1; hugePages++) {
+        size_t mappedEle = 0, byteLength = 0;
+        int status = 0;
+        float *mapped = mapFloatData((char *) path, &mappedEle, hugePages, &status);
+        CHECK(status == SZx_SCES && mapped != NULL && mappedEle == nbEle, "mapFloatData(hugePages=%d): %zu values",
+              hugePages, mappedEle);
+        if (mapped != NULL) {
+            CHECK(memcmp(mapped, data, nbEle * sizeof(float)) == 0, "mapFloatData(hugePages=%d) contents", hugePages);
+            unmapData(mapped, mappedEle * sizeof(float));
+        }
+
+        status = 0;
+        unsigned char *bytes = mapByteData((char *) path, &byteLength, hugePages, &status);
+        CHECK(status == SZx_SCES && bytes != NULL && byteLength == nbEle * sizeof(float) + 1,
+              "mapByteData(hugePages=%d): %zu bytes", hugePages, byteLength);
+        if (bytes != NULL) {
+            CHECK(memcmp(bytes, data, nbEle * sizeof(float)) == 0 && bytes[byteLength - 1] == 0x5a,
+                  "mapByteData(hugePages=%d) contents", hugePages);
+            unmapData(bytes, byteLength);
+        }
+    }
+
+    //missing and empty files are errors
+    f = fopen(emptyPath, "wb");
+    if (f != NULL)
+        fclose(f);
+    for (i = 0; i < 2; i++) {
+        size_t byteLength = 0;
+        int status = 0;
+        unsigned char *bytes = mapByteData((char *) (i == 0 ? "szx_test_missing.bin" : emptyPath), &byteLength, 1,
+                                           &status);
+        CHECK(status == SZx_FERR, "mapByteData of a %s file", i == 0 ? "missing" : "empty");
+        unmapData(bytes, byteLength);
+    }
+    unmapData(NULL, 0);
+    remove(emptyPath);
+    remove(path);
+    free(data);
+}
+
+/*one context across calls of growing sizes, block sizes and team sizes: every stream must be the one of
+ *SZx_compress_float, and a call no larger than an earlier one must reuse the buffers*/
+static void testContextReuse(void)
+{
+    size_t sizes[] = {100, 5000, 200003, 1000003, 1000};
+    int blockSizes[] = {64, 128, 32, 64, 128}, threads[] = {1, 4, 1, 3, 2};
+    size_t nbMax = 1000003, c, i;
+    float *data = testData_float(nbMax);
+    double *data64 = (double *) malloc(nbMax * sizeof(double));
+    for (i = 0; i < nbMax; i++)
+        data64[i] = data[i];
+    SZx_context ctx, ctx64;
+    SZx_init_context(&ctx);
+    SZx_init_context(&ctx64);
+
+    for (c = 0; c < sizeof(sizes) / sizeof(sizes[0]); c++) {
+        size_t refSize = 0, cmpSize = 0, refSize64 = 0, cmpSize64 = 0;
+        unsigned char *outputBuffer = ctx.output.buffer;
+        unsigned char *ref = SZx_compress_float(data, &refSize, 1e-3f, sizes[c], blockSizes[c]);
+        unsigned char *cmp = SZx_compress_float_ctx(&ctx, data, &cmpSize, 1e-3f, sizes[c], blockSizes[c], threads[c],
+                                                    NULL, 0);
+        CHECK(cmp != NULL && cmpSize == refSize && memcmp(cmp, ref, refSize) == 0,
+              "context call %zu: float stream of %zu bytes, SZx_compress_float %zu bytes", c, cmpSize, refSize);
+        if (c > 0 && sizes[c] < sizes[c - 1] && blockSizes[c] >= blockSizes[c - 1])
+            CHECK(cmp == outputBuffer, "context call %zu grew the output buffer", c);
+
+        unsigned char *ref64 = SZx_compress_double(data64, &refSize64, 1e-6, sizes[c], blockSizes[c]);
+        unsigned char *cmp64 = SZx_compress_double_ctx(&ctx64, data64, &cmpSize64, 1e-6, sizes[c], blockSizes[c],
+                                                       threads[c], NULL, 0);
+        CHECK(cmp64 != NULL && cmpSize64 == refSize64 && memcmp(cmp64, ref64, refSize64) == 0,
+              "context call %zu: double stream of %zu bytes, SZx_compress_double %zu bytes", c, cmpSize64, refSize64);
+
+        //the caller's buffer: in place with room for the worst case, copied when the result fits, refused otherwise
+        size_t maxSize = SZx_maxCompressedSize_float(sizes[c], blockSizes[c]);
+        unsigned char *out = (unsigned char *) malloc(maxSize);
+        CHECK(SZx_compress_float_ctx(&ctx, data, &cmpSize, 1e-3f, sizes[c], blockSizes[c], threads[c], out,
+                                     maxSize) == out && cmpSize == refSize && memcmp(out, ref, refSize) == 0,
+              "context call %zu in place", c);
+        memset(out, 0, maxSize);
+        CHECK(SZx_compress_float_ctx(&ctx, data, &cmpSize, 1e-3f, sizes[c], blockSizes[c], threads[c], out,
+                                     refSize) == out && cmpSize == refSize && memcmp(out, ref, refSize) == 0,
+              "context call %zu into an exact buffer", c);
+        CHECK(SZx_compress_float_ctx(&ctx, data, &cmpSize, 1e-3f, sizes[c], blockSizes[c], threads[c], out,
+                                     refSize - 1) == NULL, "context call %zu into a short buffer", c);
+        free(out);
+        free(ref64);
+        free(ref);
+    }
+    SZx_free_context(&ctx64);
+    SZx_free_context(&ctx);
+    free(data64);
+    free(data);
+}
+
+#ifdef SZx_ENABLE_TRACE
+/*parses the SZx_TRACE_DUMP of a compression of nbEle values and checks one record per block against the stream:
+ *its state bit, and for a non-constant block its O[] size and the reqLength byte that starts it in D*/
+static void checkTrace(const char *what, unsigned char *cmp, size_t nbEle, int blockSize)
+{
+    size_t nbBlocks = (nbEle + blockSize - 1) / blockSize, nbConstant = bytesToSize(cmp + 4 + sizeof(size_t)), i;
+    size_t stateBytes = (nbBlocks + 7) / 8, nbNonConstant = nbBlocks - nbConstant;
+    uint16_t *O = (uint16_t *) (cmp + 4 + 2 * sizeof(size_t));
+    unsigned char *R = (unsigned char *) (O + nbNonConstant);
+    unsigned char *D = R + stateBytes + nbConstant * sizeof(float);
+    int *seen = (int *) calloc(nbBlocks, sizeof(int));
+    unsigned char **blockData = (unsigned char **) malloc(nbBlocks * sizeof(unsigned char *));
+    uint16_t *blockSizes = (uint16_t *) calloc(nbBlocks, sizeof(uint16_t));
+    unsigned char *d = D;
+    size_t k = 0;
+    for (i = 0; i < nbBlocks; i++)
+        if (R[i >> 3] >> (7 - (i & 7)) & 1) {
+            blockData[i] = d;
+            blockSizes[i] = O[k];
+            d += O[k++];
+        }
+
+    FILE *f = tmpfile();
+    SZx_TRACE_DUMP(f);
+    rewind(f);
+    unsigned long long head = 0, kept = 0, blockID, cycles, blocks = 0, constant = 0, bytes = 0;
+    unsigned int state, reqLength, size;
+    char path[8], line[256];
+    CHECK(fscanf(f, "SZx trace: %llu blocks, last %llu kept\n", &head, &kept) == 2 && head == nbBlocks &&
+          kept == nbBlocks, "%s: %llu blocks traced, %zu compressed", what, head, nbBlocks);
+    CHECK(fgets(line, sizeof(line), f) != NULL, "%s: trace columns", what);
+    size_t records = 0, mismatches = 0, traceBytes = 0;
+    while (records < kept && fscanf(f, "%llu %7s %u %u %u %llu\n", &blockID, path, &state, &reqLength, &size,
+                                    &cycles) == 6) {
+        int nonConstant = blockID < nbBlocks && R[blockID >> 3] >> (7 - (blockID & 7)) & 1;
+        if (blockID >= nbBlocks || seen[blockID]++ || strcmp(path, "sw") != 0 || (int) state != nonConstant ||
+            (nonConstant ? size != blockSizes[blockID] || reqLength != blockData[blockID][0]
+                         : size != sizeof(float) || reqLength != 0))
+            mismatches++;
+        traceBytes += size;
+        records++;
+    }
+    CHECK(records == nbBlocks && mismatches == 0, "%s: %zu of %zu records, %zu wrong", what, records, nbBlocks,
+          mismatches);
+    CHECK(fscanf(f, "sw: %llu blocks (%llu constant), %llu bytes", &blocks, &constant, &bytes) == 3 &&
+          blocks == nbBlocks && constant == nbConstant && bytes == traceBytes &&
+          bytes == (size_t) (d - D) + nbConstant * sizeof(float), "%s: trace totals", what);
+    fclose(f);
+    free(blockSizes);
+    free(blockData);
+    free(seen);
+}
+
+/*the trace records every block of the serial and the block-parallel path once, and a reset clears it*/
+static void testTrace(void)
+{
+    size_t nbEle = 20035, cmpSize = 0, i;
+    int blockSize = 64;
+    float *data = testData_float(nbEle);
+    for (i = 0; i < nbEle; i++)
+        if (i / blockSize % 4 == 0)
+            data[i] = 2.0f; //constant blocks
+    unsigned char *cmp = SZx_compress_float(data, &cmpSize, 1e-3f, nbEle, blockSize);
+
+    SZx_TRACE_RESET();
+    free(SZx_compress_float(data, &cmpSize, 1e-3f, nbEle, blockSize));
+    checkTrace("serial", cmp, nbEle, blockSize);
+    SZx_TRACE_RESET();
+    free(SZx_compress_float_openmp(data, &cmpSize, 1e-3f, nbEle, blockSize, 4));
+    checkTrace("openmp", cmp, nbEle, blockSize);
+
+    SZx_TRACE_RESET();
+    FILE *f = tmpfile();
+    SZx_TRACE_DUMP(f);
+    long dumpSize = ftell(f);
+    rewind(f);
+    unsigned long long head = 1, kept = 1;
+    char line[256];
+    CHECK(fscanf(f, "SZx trace: %llu blocks, last %llu kept\n", &head, &kept) == 2 && head == 0 && kept == 0,
+          "reset trace: %llu blocks", head);
+    CHECK(fgets(line, sizeof(line), f) != NULL && ftell(f) == dumpSize, "reset trace: records or totals left");
+    fclose(f);
+    free(cmp);
+    free(data);
+}
+#endif
+
+int main(void)
+{
+    testTeamSize();
+    testBlockSizeLimit();
+    testBlockRanges();
+    testStream();
+    testMapData();
+    testContextReuse();
+#ifdef SZx_ENABLE_TRACE
+    testTrace();
+#endif
+    if (failures == 0)
+        printf("all tests passed\n");
+    return failures == 0 ? 0 : 1;
+}
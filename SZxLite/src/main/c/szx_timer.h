@@ -0,0 +1,46 @@
+#ifndef SZX_TIMER_H
+#define SZX_TIMER_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Wall-clock seconds from a monotonic clock
+static inline double SZx_wtime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Cycle counter of the running core: rdtsc on x86 (reference cycles), rdcycle on RISC-V,
+// the virtual counter on AArch64 (a fixed-frequency timer, not core cycles); 0 elsewhere
+static inline uint64_t SZx_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__riscv)
+    uint64_t cycles;
+    asm volatile ("rdcycle %0" : "=r" (cycles));
+    return cycles;
+#elif defined(__aarch64__)
+    uint64_t cycles;
+    asm volatile ("mrs %0, cntvct_el0" : "=r" (cycles));
+    return cycles;
+#else
+    return 0;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SZX_TIMER_H
@@ -0,0 +1,77 @@
+#include "szx_trace.h"
+
+#ifdef SZx_ENABLE_TRACE
+
+#include <string.h>
+
+typedef struct {
+    uint64_t blocks;
+    uint64_t constantBlocks;
+    uint64_t bytes;
+    uint64_t cycles;
+} SZx_trace_totals;
+
+static SZx_trace_record traceRing[SZx_TRACE_CAPACITY];
+static uint64_t traceHead; // number of records ever appended
+static SZx_trace_totals traceTotals[3];
+
+static const char *pathName(int path)
+{
+    switch (path) {
+    case SZx_TRACE_HW:   return "hw";
+    case SZx_TRACE_ROCC: return "rocc";
+    default:             return "sw";
+    }
+}
+
+//blocks may be traced from several OpenMP threads at once
+void SZx_trace_block(size_t blockID, int path, int state, int reqLength, size_t size, uint64_t cycles)
+{
+    uint64_t slot = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED) % SZx_TRACE_CAPACITY;
+    SZx_trace_record *r = &traceRing[slot];
+    r->blockID = blockID;
+    r->cycles = cycles;
+    r->size = (uint32_t) size;
+    r->path = (uint8_t) path;
+    r->state = (uint8_t) state;
+    r->reqLength = (uint8_t) reqLength;
+
+    SZx_trace_totals *t = &traceTotals[path];
+    __atomic_fetch_add(&t->blocks, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&t->constantBlocks, state == 0, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&t->bytes, size, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&t->cycles, cycles, __ATOMIC_RELAXED);
+}
+
+void SZx_trace_reset(void)
+{
+    traceHead = 0;
+    memset(traceTotals, 0, sizeof(traceTotals));
+}
+
+void SZx_trace_dump(FILE *f)
+{
+    uint64_t head = traceHead;
+    uint64_t first = head > SZx_TRACE_CAPACITY ? head - SZx_TRACE_CAPACITY : 0;
+    uint64_t i;
+    int p;
+
+    fprintf(f, "SZx trace: %llu blocks, last %llu kept\n", (unsigned long long) head,
+            (unsigned long long) (head - first));
+    fprintf(f, "%10s %5s %5s %9s %10s %12s\n", "block", "path", "state", "reqLength", "size", "cycles");
+    for (i = first; i < head; i++) {
+        const SZx_trace_record *r = &traceRing[i % SZx_TRACE_CAPACITY];
+        fprintf(f, "%10llu %5s %5u %9u %10u %12llu\n", (unsigned long long) r->blockID, pathName(r->path),
+                r->state, r->reqLength, r->size, (unsigned long long) r->cycles);
+    }
+    for (p = 0; p < 3; p++) {
+        const SZx_trace_totals *t = &traceTotals[p];
+        if (t->blocks == 0)
+            continue;
+        fprintf(f, "%s: %llu blocks (%llu constant), %llu bytes, %llu cycles, %.1f cycles/block\n", pathName(p),
+                (unsigned long long) t->blocks, (unsigned long long) t->constantBlocks,
+                (unsigned long long) t->bytes, (unsigned long long) t->cycles, (double) t->cycles / t->blocks);
+    }
+}
+
+#endif // SZx_ENABLE_TRACE
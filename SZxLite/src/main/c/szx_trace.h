@@ -0,0 +1,63 @@
+#ifndef SZX_TRACE_H
+#define SZX_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "szx_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-block tracing of the compression paths. Built with SZx_ENABLE_TRACE, every block
+ * appends a record (path, state, reqLength, compressed size, cycles) to an in-memory ring
+ * buffer holding the last SZx_TRACE_CAPACITY blocks, and running totals are kept for all
+ * blocks; SZx_TRACE_DUMP prints both once the run is over. Without SZx_ENABLE_TRACE the
+ * macros expand to nothing, so release builds do no I/O and read no counters in the loops.
+ */
+
+#define SZx_TRACE_SW   0 // SZx_compress_one_block_float_sw
+#define SZx_TRACE_HW   1 // SZx_compress_one_block_float_hw
+#define SZx_TRACE_ROCC 2 // SZx_compress_float_rocc
+
+typedef struct {
+    uint64_t blockID;
+    uint64_t cycles;
+    uint32_t size;      // bytes the block takes in the output (the median for a constant block)
+    uint8_t path;
+    uint8_t state;      // 0 = constant block
+    uint8_t reqLength;  // 0 when unknown (constant block, RoCC)
+} SZx_trace_record;
+
+#ifdef SZx_ENABLE_TRACE
+
+#ifndef SZx_TRACE_CAPACITY
+#define SZx_TRACE_CAPACITY 4096
+#endif
+
+void SZx_trace_block(size_t blockID, int path, int state, int reqLength, size_t size, uint64_t cycles);
+void SZx_trace_reset(void);
+void SZx_trace_dump(FILE *f);
+
+#define SZx_TRACE_START(t) uint64_t t = SZx_cycles()
+#define SZx_TRACE_BLOCK(blockID, path, state, reqLength, size, t) \
+    SZx_trace_block(blockID, path, state, reqLength, size, SZx_cycles() - (t))
+#define SZx_TRACE_RESET() SZx_trace_reset()
+#define SZx_TRACE_DUMP(f) SZx_trace_dump(f)
+
+#else
+
+#define SZx_TRACE_START(t)
+#define SZx_TRACE_BLOCK(blockID, path, state, reqLength, size, t) ((void) 0)
+#define SZx_TRACE_RESET() ((void) 0)
+#define SZx_TRACE_DUMP(f) ((void) 0)
+
+#endif // SZx_ENABLE_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SZX_TRACE_H
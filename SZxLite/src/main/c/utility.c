@@ -1,6 +1,13 @@
 #include "define.h"
 #include "utility.h"
 #include <time.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SZX_HAVE_MMAP 1
+#endif
 
 
 //write compressed data in bytes
@@ -14,94 +21,137 @@ void writeByteData(unsigned char *bytes, size_t byteLength, char *tgtFilePath, i
         return;
     }
 
-    fwrite(bytes, 1, byteLength, pFile); //write outSize bytes
+    size_t written = fwrite(bytes, 1, byteLength, pFile); //write outSize bytes
     fclose(pFile);
-    *status = SZx_SCES;
+    *status = written == byteLength ? SZx_SCES : SZx_FERR;
 }
 
 //write float data in bytes (e.g., write decompressed data into a file)
+//lfloat.byte[] is the in-memory byte order, so the array is written as is without a staging copy
 void writeFloatData_inBytes(float *data, size_t nbEle, char* tgtFilePath, int *status)
 {
-        size_t i = 0;
-        int state = SZx_SCES;
-        lfloat buf;
-        unsigned char* bytes = (unsigned char*)malloc(nbEle*sizeof(float));
-        for(i=0;i<nbEle;i++)
-        {
-                buf.value = data[i];
-                bytes[i*4+0] = buf.byte[0];
-                bytes[i*4+1] = buf.byte[1];
-                bytes[i*4+2] = buf.byte[2];
-                bytes[i*4+3] = buf.byte[3];
-        }
+        writeByteData((unsigned char*)data, nbEle*sizeof(float), tgtFilePath, status);
+}
 
-        size_t byteLength = nbEle*sizeof(float);
-        writeByteData(bytes, byteLength, tgtFilePath, &state);
-        free(bytes);
-        *status = state;
+//size of an open file, or 0 if it cannot be determined
+static size_t fileSize(FILE *pFile)
+{
+#ifdef SZX_HAVE_MMAP
+        struct stat st;
+        if (fstat(fileno(pFile), &st) == 0 && S_ISREG(st.st_mode))
+                return (size_t)st.st_size;
+#endif
+        long size;
+        fseek(pFile, 0, SEEK_END);
+        size = ftell(pFile);
+        fseek(pFile, 0, SEEK_SET);
+        return size > 0 ? (size_t)size : 0;
 }
 
 //read float data from binary-format file
 float *readFloatData(char *srcFilePath, size_t *nbEle, int *status)
 {
-        size_t inSize;
+        size_t byteLength = 0;
+        float *daBuf = (float *)readByteData(srcFilePath, &byteLength, status);
+        *nbEle = byteLength/4;
+        return daBuf;
+}
+
+unsigned char *readByteData(char *srcFilePath, size_t *byteLength, int *status)
+{
         FILE *pFile = fopen(srcFilePath, "rb");
     if (pFile == NULL)
     {
         printf("Failed to open input file. 1\n");
         *status = SZx_FERR;
-        return NULL;
+        return 0;
     }
-        fseek(pFile, 0, SEEK_END);
-    inSize = ftell(pFile);
-    *nbEle = inSize/4;
-    fclose(pFile);
-
-    if(inSize<=0)
+    *byteLength = fileSize(pFile);
+    if(*byteLength == 0)
     {
-                printf("Error: input file is wrong!\n");
-                *status = SZx_FERR;
-        }
-
-    float *daBuf = (float *)malloc(inSize);
+        printf("Error: input file is wrong!\n");
+        fclose(pFile);
+        *status = SZx_FERR;
+        return 0;
+    }
 
-    pFile = fopen(srcFilePath, "rb");
-    if (pFile == NULL)
+    unsigned char *byteBuf = ( unsigned char *)malloc((*byteLength)*sizeof(unsigned char)); //sizeof(char)==1
+    if (byteBuf == NULL || fread(byteBuf, 1, *byteLength, pFile) != *byteLength)
     {
-        printf("Failed to open input file. 2\n");
+        printf("Failed to read input file. 2\n");
+        free(byteBuf);
+        fclose(pFile);
         *status = SZx_FERR;
-        return NULL;
+        return 0;
     }
-    fread(daBuf, 4, *nbEle, pFile);
     fclose(pFile);
     *status = SZx_SCES;
-    return daBuf;
+    return byteBuf;
 }
 
-unsigned char *readByteData(char *srcFilePath, size_t *byteLength, int *status)
+//map a file read-only into memory: the returned pointer points straight into the page cache, so nothing is
+//copied and pages are faulted in as the compressor reaches them. hugePages asks for transparent huge pages
+//to cut TLB misses on very large files (the kernel may ignore it). Release with unmapData.
+//Where mmap is not available this falls back to readByteData.
+unsigned char *mapByteData(char *srcFilePath, size_t *byteLength, int hugePages, int *status)
 {
-        FILE *pFile = fopen(srcFilePath, "rb");
-    if (pFile == NULL)
+#ifdef SZX_HAVE_MMAP
+        int fd = open(srcFilePath, O_RDONLY);
+    if (fd < 0)
     {
         printf("Failed to open input file. 1\n");
         *status = SZx_FERR;
         return 0;
     }
-        fseek(pFile, 0, SEEK_END);
-    *byteLength = ftell(pFile);
-    fclose(pFile);
-
-    unsigned char *byteBuf = ( unsigned char *)malloc((*byteLength)*sizeof(unsigned char)); //sizeof(char)==1
+        struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    {
+        printf("Error: input file is wrong!\n");
+        close(fd);
+        *status = SZx_FERR;
+        return 0;
+    }
+    *byteLength = (size_t)st.st_size;
 
-    pFile = fopen(srcFilePath, "rb");
-    if (pFile == NULL)
+    void *addr = mmap(NULL, *byteLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //the mapping keeps the file referenced
+    if (addr == MAP_FAILED)
     {
-        printf("Failed to open input file. 2\n");
+        printf("Failed to map input file.\n");
         *status = SZx_FERR;
         return 0;
     }
-    fread(byteBuf, 1, *byteLength, pFile);
-    fclose(pFile);
+
+    madvise(addr, *byteLength, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (hugePages)
+        madvise(addr, *byteLength, MADV_HUGEPAGE);
+#endif
+    (void)hugePages;
     *status = SZx_SCES;
-    return byteBuf;
+    return (unsigned char *)addr;
+#else
+    (void)hugePages;
+    return readByteData(srcFilePath, byteLength, status);
+#endif
+}
+
+float *mapFloatData(char *srcFilePath, size_t *nbEle, int hugePages, int *status)
+{
+        size_t byteLength = 0;
+        float *daBuf = (float *)mapByteData(srcFilePath, &byteLength, hugePages, status);
+        *nbEle = byteLength/4;
+        return daBuf;
+}
+
+void unmapData(void *data, size_t byteLength)
+{
+        if (data == NULL)
+                return;
+#ifdef SZX_HAVE_MMAP
+        munmap(data, byteLength);
+#else
+        (void)byteLength;
+        free(data);
+#endif
 }
@@ -21,6 +21,9 @@ void writeByteData(unsigned char *bytes, size_t byteLength, char *tgtFilePath, i
 void writeFloatData_inBytes(float *data, size_t nbEle, char* tgtFilePath, int *status);
 float *readFloatData(char *srcFilePath, size_t *nbEle, int *status);
 unsigned char *readByteData(char *srcFilePath, size_t *byteLength, int *status);
+float *mapFloatData(char *srcFilePath, size_t *nbEle, int hugePages, int *status);
+unsigned char *mapByteData(char *srcFilePath, size_t *byteLength, int hugePages, int *status);
+void unmapData(void *data, size_t byteLength);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,739 @@
+package szx
+
+import chisel3._
+import chisel3.util._
+
+// A command of the accelerator: the funct and rd fields of the RoCC instruction and its two source operands
+class SZxCommand extends Bundle {
+  val funct = UInt(7.W)
+  val rd = UInt(5.W)
+  val rs1 = UInt(64.W)
+  val rs2 = UInt(64.W)
+}
+
+// The response of a command, written to register rd
+class SZxResponse extends Bundle {
+  val rd = UInt(5.W)
+  val data = UInt(64.W)
+}
+
+// What the COMPRESS_MULTI/COMPRESS_ARRAY pipeline does in a cycle, for the stall breakdown of the co-simulation
+// (SZxLite/sim)
+class SZxPipelineStatus extends Bundle {
+  val active = Bool()          // a COMPRESS_MULTI/COMPRESS_ARRAY is running
+  val loading = Bool()         // a loader has loads to issue or in flight
+  val bankWait = Bool()        // a load unit could load its next block but the bank is taken
+  val statsWait = Bool()       // a stats unit computes the median and radius of the block just loaded
+  val inputStarved = Bool()    // the next block processor could take a block but its bank is not loaded
+  val processing = Bool()      // a block processor holds a block
+  val drainWait = Bool()       // a compressed block waits for the writer
+  val memBackpressure = Bool() // a memory request waits for the memory
+}
+
+object SZxAcceleratorCore {
+  // COMPRESS_MULTI descriptor (szx_rocc_desc_t): block address, median and radius of one block
+  //   bytes 0-7: address of the block's first value, 8-11: median (float), 12-15: radius (float)
+  val descriptorWords = 4
+  val descriptorBytes = descriptorWords * 4
+
+  // READ_COUNTER indices (SZX_COUNTER_* in rocc.h): events from 0, then the cycles spent in each state of the
+  // command state machine from stateCounters and in each state of the COMPRESS_MULTI load stage from loadStateCounters
+  val counterEvents = 11
+  val stateCounters = 16
+  val loadStateCounters = 32
+}
+
+// The SZx accelerator without Rocket Chip: the command state machine, the memory engines, the scratchpads and the
+// block processors. SZxRoCCAccelerator connects it to the RoCC interface and the L1 data cache, SZxBlockHarness to
+// the testbench of the co-simulation. A command is accepted in the idle state and gets one response; the memory
+// port carries the engines' requests and expects a response for every request, stores included, in any order.
+//   maxBlockSize: largest block (in values) of the scratchpads, the block length itself is set at run time (SET_BLOCK)
+//   lanes: values per cycle of a block processor (SZxPipelinedBlockProcessor)
+//   processors: block processors, each with its own scratchpad; COMPRESS_MULTI/COMPRESS_ARRAY spread the blocks over
+//     them
+class SZxAcceleratorCore(val maxBlockSize: Int = 1024, val lanes: Int = 8, val processors: Int = 1) extends Module {
+  require(maxBlockSize > 0 && maxBlockSize % lanes == 0, "maxBlockSize must be a multiple of lanes")
+  require(processors >= 1, "at least one block processor")
+  require(maxBlockSize * 4 + maxBlockSize / 4 + 5 < (1 << 16), "compressed block sizes are 16-bit")
+  val rowsPerBank = maxBlockSize / lanes
+  val lengthBits = log2Ceil(maxBlockSize + 1)
+  val nbBanks = 2 * processors
+  val unitBits = log2Ceil(processors max 2)
+  val moduleInstantiatedPrinted = RegInit(false.B)
+  when (!moduleInstantiatedPrinted) {
+    printf("RoCC: Module instantiated\n")
+    moduleInstantiatedPrinted := true.B
+  }
+
+  // Configuration registers
+  val errorBound = RegInit(0.U(32.W))
+  val medianValue = RegInit(0.U(32.W))
+  val radius = RegInit(0.U(32.W))
+  val blockLength = RegInit((64 min maxBlockSize).U(lengthBits.W))  // values per block (SET_BLOCK)
+  val singleLength = RegInit((64 min maxBlockSize).U(lengthBits.W)) // values of the block COMPRESS compresses
+
+  // Block processor instances - this is the actual SZx compression hardware. Each is pipelined: a block is accepted
+  // every blockLength/lanes cycles and several can be in flight, their results come out in order from its two
+  // output buffers. The single-block commands use the first one
+  val blockProcessors = Seq.fill(processors)(Module(new SZxPipelinedBlockProcessor(maxBlockSize, lanes)))
+  val outputBytes = SZxPipelinedBlockProcessor.maxCompressedBytes(maxBlockSize)
+
+  // Memory engines: every block processor has a loader, which fills its scratchpad (and the descriptor registers of
+  // COMPRESS_MULTI), so that the blocks of the processors are fetched concurrently; the writer stores compressed
+  // blocks and their sizes. They share the memory port. The single-block commands use the first loader
+  val loaders = Seq.fill(processors)(Module(new SZxMemLoader(maxBlockSize)))
+  val writer = Module(new SZxMemWriter(outputBytes))
+
+  // Responses go back to the engine named by the top tag bits (loader u = u, writer = processors)
+  val engineBits = log2Ceil(processors + 1)
+  val engineTagBits = loaders.head.tagBits max writer.tagBits
+  val memTagBits = engineBits + engineTagBits
+
+  val io = IO(new Bundle {
+    val cmd = Flipped(Decoupled(new SZxCommand))
+    val resp = Decoupled(new SZxResponse)
+    val busy = Output(Bool())
+
+    val memReq = Decoupled(new SZxMemReq(memTagBits))
+    val memResp = Flipped(Valid(new SZxMemResp(memTagBits)))
+
+    val status = Output(new SZxPipelineStatus)
+  })
+
+  // Command decoding
+  val cmd_rs1 = io.cmd.bits.rs1.asUInt
+  val cmd_rs2 = io.cmd.bits.rs2.asUInt
+  val cmd_funct = io.cmd.bits.funct
+  val cmd_rd = io.cmd.bits.rd
+
+  // Store destination register when command is received
+  val stored_rd = RegInit(0.U(5.W))
+
+  // Command parameters
+  val compressedSize = RegInit(0.U(64.W))
+
+  // State machine for RoCC operations
+  val sIdle :: sProcessBlock :: sStoreResult :: sComplete :: sWaitResponse :: sLoadDataFromCPU :: sGetResult :: sBulkLoad :: sWaitLoad :: sMulti :: sWriteBack :: Nil = Enum(11)
+  val state = RegInit(sIdle)
+
+  // SCRATCHPAD MEMORY - two banks (ping-pong) per block processor: while a processor reads the block of one bank,
+  // the memory engine fills the other. It is SRAM with one column per lane, so the processor reads a row of `lanes`
+  // values per cycle and the two words of a load land in different columns; value i of local bank b is in column
+  // i % lanes, row b * rowsPerBank + i / lanes. The compressed blocks are in the block processors' output buffers.
+  // The banks are numbered round-robin over the processors: bank k is local bank k / processors of processor
+  // k % processors, so consecutive blocks go to consecutive processors.
+  // The single-block commands (LOAD_DATA, LOAD_BLOCK, COMPRESS) use bank 0.
+  val scratchpads = Seq.fill(processors)(Seq.fill(lanes)(SyncReadMem(2 * rowsPerBank, UInt(32.W))))
+  val bankUnit = VecInit((0 until nbBanks).map(k => (k % processors).U(unitBits.W)))
+  val bankLocal = VecInit((0 until nbBanks).map(k => (k / processors).U(1.W)))
+  def nextBank(bank: UInt): UInt = Mux(bank === (nbBanks - 1).U, 0.U, bank + 1.U)
+
+  // Data transfer registers
+  val dataIndex = RegInit(0.U(log2Ceil(maxBlockSize).W))
+
+  // Output addresses: COMPRESS writes its block at compressOutAddr; COMPRESS_MULTI writes its blocks back to back
+  // from outputBase and the 16-bit size of block i at sizeBase + 2*i (SET_OUTPUT). 0 = keep the result on chip
+  val compressOutAddr = RegInit(0.U(64.W))
+  val writeIssued = RegInit(false.B)
+  val processIssued = RegInit(false.B) // COMPRESS has handed the scratchpad to the block processor
+  val outputBase = RegInit(0.U(64.W))
+  val sizeBase = RegInit(0.U(64.W))
+  val mediansBase = RegInit(0.U(64.W)) // COMPRESS_ARRAY: float median of constant block i at mediansBase + 4*i
+
+  // Bulk transfer registers: block address and number of words to load through the memory engine
+  val bulkTransferAddr = RegInit(0.U(64.W))
+  val bulkTransferWords = RegInit(0.U(lengthBits.W))
+
+  // Batched compression (COMPRESS_MULTI): descriptor table and running total of compressed bytes.
+  // The blocks flow through three stages that run concurrently on the ping-pong banks:
+  //   load:     one load unit per block processor; unit u takes blocks u, u + processors, ... : it fetches the
+  //             descriptor of block loadIndex(u), then loads the block into bank loadBank(u), the next of the two
+  //             banks of its processor, once that bank is free
+  //   compress: hand bank computeBank to its block processor; the bank is free again once the processor has read it
+  //   drain:    write the next block to memory; drainQueue keeps the blocks in order and names the processor of
+  //             each, which has it as its oldest result (the reorder stage)
+  // COMPRESS_ARRAY (statsMode) runs the same stages without descriptors on consecutive blocks of blockLength values
+  // from the array address, the last one possibly shorter; the median, radius and state of each block come from the
+  // stats unit of its load unit, which watches the block while it is loaded. Constant blocks skip the block
+  // processor and drain as a zero size and their median
+  val multiMode = RegInit(false.B)
+  val statsMode = RegInit(false.B)
+  val descTableAddr = RegInit(0.U(64.W))
+  val descCount = RegInit(0.U(64.W))
+  val multiTotal = RegInit(0.U(64.W))
+
+  // Load units
+  val lIdle :: lFetchDesc :: lWaitDesc :: lLoad :: lWaitLoad :: lStats :: Nil = Enum(6)
+  val loadState = Seq.fill(processors)(RegInit(lIdle))
+  val loadIndex = Seq.fill(processors)(RegInit(0.U(64.W)))
+  val loadLocal = Seq.fill(processors)(RegInit(0.U(1.W)))          // local bank of the block
+  val arrayAddr = Seq.fill(processors)(RegInit(0.U(64.W)))         // COMPRESS_ARRAY: address of the block
+  val arrayRemaining = Seq.fill(processors)(RegInit(0.U(64.W)))    // COMPRESS_ARRAY: values from the block on
+  val descWords = Seq.fill(processors)(Reg(Vec(SZxAcceleratorCore.descriptorWords, UInt(32.W))))
+  val loadToDesc = Seq.fill(processors)(RegInit(false.B)) // loader responses go to descWords instead of the scratchpad
+  val bankFull = RegInit(VecInit(Seq.fill(nbBanks)(false.B)))
+  val bankMedian = Reg(Vec(nbBanks, UInt(32.W)))
+  val bankRadius = Reg(Vec(nbBanks, UInt(32.W)))
+  val bankConstant = RegInit(VecInit(Seq.fill(nbBanks)(false.B)))
+  val bankLength = Reg(Vec(nbBanks, UInt(lengthBits.W)))
+  val bankIssued = RegInit(VecInit(Seq.fill(nbBanks)(false.B))) // handed to the block processor, which still reads it
+
+  val computeBank = RegInit(0.U(log2Ceil(nbBanks).W))
+
+  // Enough places for the blocks in the banks, the pipelines and the output buffers of all processors
+  val drainQueue = Module(new Queue(new SZxDrainToken(unitBits), 4 * processors))
+  val drainedCount = RegInit(0.U(64.W))
+  val draining = RegInit(false.B) // the writer is storing the block at the head of drainQueue
+  val drainAddr = RegInit(0.U(64.W))
+
+  // DMA-like bulk transfer registers (disabled for now)
+  // val dmaTransferActive = RegInit(false.B)
+  // val dmaTransferSize = RegInit(0.U(16.W))
+  // val dmaTransferAddr = RegInit(0.U(32.W))
+  // val dmaTransferIndex = RegInit(0.U(8.W))
+  // val dmaBuffer = RegInit(VecInit(Seq.fill(32)(0.U(32.W))))  // 32-word DMA buffer
+
+  // Memory optimization (disabled for now)
+  // val burstTransferActive = RegInit(false.B)
+
+  // Output registers
+  val outputSize = RegInit(0.U(16.W))
+  val outputIndex = RegInit(0.U(log2Ceil(outputBytes).W))
+
+  // Data loading from CPU control
+  val dataLoadIndex = RegInit(0.U(log2Ceil(maxBlockSize).W))
+  val dataLoadValue = RegInit(0.U(32.W))
+
+  // Debug: Track when commands fire
+  when(io.cmd.valid && io.cmd.ready) {
+    printf("SZxRoCC: CMD FIRE! funct=%d, rs1=0x%x, rs2=0x%x, rd=%d\n",
+           io.cmd.bits.funct, io.cmd.bits.rs1, io.cmd.bits.rs2, io.cmd.bits.rd)
+  }
+
+  // Response handling - return the actual compressed size from hardware
+  io.resp.valid := (state === sComplete)
+  io.resp.bits.rd := stored_rd
+  io.resp.bits.data := compressedSize
+
+  // Busy signal - busy when not in idle state or when processing
+  val processorBusy = VecInit(blockProcessors.map(_.io.busy)).asUInt.orR
+  val loadersIdle = VecInit(loaders.map(_.io.idle)).asUInt.andR
+  io.busy := (state =/= sIdle) || processorBusy || !loadersIdle || !writer.io.idle
+
+  // Command ready - only ready when in idle state
+  io.cmd.ready := (state === sIdle)
+
+  // Block processor connections - this is the actual SZx compression hardware.
+  // In COMPRESS_MULTI a block starts as soon as its bank is loaded and the processor of the bank takes it (the
+  // dispatcher); every block, constant or not, gets a place in drainQueue when it leaves its bank, so the blocks
+  // drain in order
+  val multiReady = multiMode && bankFull(computeBank) && !bankIssued(computeBank) && drainQueue.io.enq.ready
+  val multiCompute = multiReady && !bankConstant(computeBank)
+  val multiConstant = multiReady && bankConstant(computeBank)
+  val computeUnit = bankUnit(computeBank)
+  for ((blockProcessor, unit) <- blockProcessors.zipWithIndex) {
+    blockProcessor.io.start.valid := Mux(multiMode, multiCompute && computeUnit === unit.U,
+                                         (unit == 0).B && state === sProcessBlock && !processIssued)
+    blockProcessor.io.start.bits.bank := Mux(multiMode, bankLocal(computeBank), 0.U)
+    blockProcessor.io.start.bits.length := Mux(multiMode, bankLength(computeBank), singleLength)
+    blockProcessor.io.start.bits.errorBound := errorBound
+    blockProcessor.io.start.bits.medianValue := Mux(multiMode, bankMedian(computeBank), medianValue)
+    blockProcessor.io.start.bits.radius := Mux(multiMode, bankRadius(computeBank), radius)
+    for (j <- 0 until lanes) {
+      blockProcessor.io.inputData(j) := scratchpads(unit)(j).read(blockProcessor.io.inputRow)
+    }
+  }
+  val processorStarts = VecInit(blockProcessors.map(_.io.start.fire)).asUInt
+  when(processorStarts(0) && !multiMode) {
+    processIssued := true.B
+  }
+
+  // Load units: in COMPRESS_MULTI/COMPRESS_ARRAY the descriptors and blocks of their processor, otherwise the first
+  // loader serves LOAD_BLOCK. Local bank l of processor u is bank u + l * processors
+  val stride = blockLength * processors.U // values from a block of COMPRESS_ARRAY to the next one of its load unit
+  val loadBank = (0 until processors).map { u =>
+    Mux(loadLocal(u).asBool, (processors + u).U(log2Ceil(nbBanks).W), u.U(log2Ceil(nbBanks).W))
+  }
+  val loadWords = (0 until processors).map { u =>
+    Mux(statsMode && arrayRemaining(u) < blockLength, arrayRemaining(u)(lengthBits - 1, 0), blockLength)
+  }
+  val loadDesc = loadState.map(_ === lFetchDesc)
+  val stats = Seq.fill(processors)(Module(new SZxBlockStats(loaders.head.indexBits)))
+  val respEngine = io.memResp.bits.tag(memTagBits - 1, engineTagBits)
+  def scratchRow(bank: UInt, index: UInt): UInt =
+    (Mux(bank.asBool, rowsPerBank.U, 0.U) + (index >> log2Ceil(lanes)))(log2Ceil(2 * rowsPerBank) - 1, 0)
+  for ((loader, u) <- loaders.zipWithIndex) {
+    val loadBlock = loadState(u) === lLoad && !bankFull(loadBank(u))
+    loader.io.start.valid := Mux(multiMode, loadDesc(u) || loadBlock, (u == 0).B && state === sBulkLoad)
+    loader.io.start.bits.addr := Mux(multiMode,
+                                     Mux(loadDesc(u),
+                                         descTableAddr + loadIndex(u) * SZxAcceleratorCore.descriptorBytes.U,
+                                         Mux(statsMode, arrayAddr(u), Cat(descWords(u)(1), descWords(u)(0)))),
+                                     bulkTransferAddr)
+    loader.io.start.bits.nbWords := Mux(multiMode,
+                                        Mux(loadDesc(u), SZxAcceleratorCore.descriptorWords.U, loadWords(u)),
+                                        bulkTransferWords)
+    when(loader.io.start.fire) {
+      loadToDesc(u) := multiMode && loadDesc(u)
+    }
+
+    // Memory responses, to the engine named by their tag
+    loader.io.resp.valid := io.memResp.valid && respEngine === u.U
+    loader.io.resp.bits.tag := io.memResp.bits.tag(loader.tagBits - 1, 0)
+    loader.io.resp.bits.data := io.memResp.bits.data
+    val out = loader.io.out
+    when(out.valid && loadToDesc(u)) {
+      val index = out.bits.index
+      descWords(u)(index(1, 0)) := out.bits.data(0)
+      when(out.bits.pair) {
+        descWords(u)(index(1, 0) + 1.U) := out.bits.data(1)
+      }
+    }
+
+    // Scratchpad writes: the loader's words, or for the first processor the value of LOAD_DATA
+    val fillLocal = Mux(multiMode, loadLocal(u), 0.U)
+    val fillIndex = out.bits.index
+    val fillNext = fillIndex +& 1.U
+    for (c <- 0 until lanes) {
+      val fill = out.valid && !loadToDesc(u)
+      val first = fill && fillIndex % lanes.U === c.U
+      val second = fill && out.bits.pair && fillNext % lanes.U === c.U
+      val cpu = (u == 0).B && state === sLoadDataFromCPU && dataLoadIndex % lanes.U === c.U
+      when(first || second || cpu) {
+        scratchpads(u)(c).write(
+          Mux(first, scratchRow(fillLocal, fillIndex), Mux(second, scratchRow(fillLocal, fillNext),
+                                                           scratchRow(0.U, dataLoadIndex))),
+          Mux(first, out.bits.data(0), Mux(second, out.bits.data(1), dataLoadValue)))
+      }
+    }
+
+    // Block statistics, gathered from the loader's responses while the block streams into its bank
+    stats(u).io.clear := loader.io.start.fire && !(multiMode && loadDesc(u))
+    stats(u).io.in.valid := out.valid && !loadToDesc(u)
+    stats(u).io.in.bits := out.bits
+    stats(u).io.errorBound := errorBound
+    stats(u).io.start := loadState(u) === lWaitLoad && loader.io.idle && statsMode
+  }
+  writer.io.resp.valid := io.memResp.valid && respEngine === processors.U
+  writer.io.resp.bits.tag := io.memResp.bits.tag(writer.tagBits - 1, 0)
+  writer.io.resp.bits.data := io.memResp.bits.data
+
+  // Memory port, the L1 data cache port of the RoCC wrapper: a request per cycle at most, so the loaders together
+  // move at most 8 bytes per cycle
+  val engines = loaders.map(_.io.req) :+ writer.io.req
+  val memArb = Module(new RRArbiter(new SZxMemReq(memTagBits), engines.length))
+  for ((engine, id) <- engines.zipWithIndex) {
+    memArb.io.in(id).valid := engine.valid
+    memArb.io.in(id).bits.addr := engine.bits.addr
+    memArb.io.in(id).bits.write := engine.bits.write
+    memArb.io.in(id).bits.size := engine.bits.size
+    memArb.io.in(id).bits.data := engine.bits.data
+    memArb.io.in(id).bits.tag := Cat(id.U(engineBits.W), engine.bits.tag.pad(engineTagBits))
+    engine.ready := memArb.io.in(id).ready
+  }
+  io.memReq <> memArb.io.out
+
+  // COMPRESS_MULTI/COMPRESS_ARRAY load stage
+  // The number of blocks of COMPRESS_ARRAY is known once its last block is loaded
+  for ((loader, u) <- loaders.zipWithIndex) {
+    def bankLoaded(median: UInt, blockRadius: UInt, constant: Bool): Unit = {
+      val bank = loadBank(u)
+      printf("SZxRoCC: Block %d loaded into bank %d\n", loadIndex(u), bank)
+      val last = arrayRemaining(u) <= blockLength // the last block of COMPRESS_ARRAY
+      val unitLast = Mux(statsMode, arrayRemaining(u) <= stride, loadIndex(u) + processors.U >= descCount)
+      bankFull(bank) := true.B
+      bankMedian(bank) := median
+      bankRadius(bank) := blockRadius
+      bankConstant(bank) := constant
+      bankLength(bank) := loadWords(u)
+      loadLocal(u) := ~loadLocal(u)
+      loadIndex(u) := loadIndex(u) + processors.U
+      when(statsMode) {
+        arrayAddr(u) := arrayAddr(u) + (stride << 2)
+        arrayRemaining(u) := arrayRemaining(u) - stride
+        when(last) {
+          descCount := loadIndex(u) + 1.U
+        }
+      }
+      loadState(u) := Mux(unitLast, lIdle, Mux(statsMode, lLoad, lFetchDesc))
+    }
+    switch(loadState(u)) {
+      is(lFetchDesc) {
+        when(loader.io.start.fire) {
+          loadState(u) := lWaitDesc
+        }
+      }
+      is(lWaitDesc) {
+        when(loader.io.idle) {
+          loadState(u) := lLoad
+        }
+      }
+      is(lLoad) {
+        // Waits here while the block processor still needs the bank
+        when(loader.io.start.fire) {
+          loadState(u) := lWaitLoad
+        }
+      }
+      is(lWaitLoad) {
+        when(loader.io.idle) {
+          when(statsMode) {
+            loadState(u) := lStats
+          }.otherwise {
+            bankLoaded(descWords(u)(2), descWords(u)(3), false.B)
+          }
+        }
+      }
+      is(lStats) {
+        when(stats(u).io.done) {
+          bankLoaded(stats(u).io.medianValue, stats(u).io.radius, stats(u).io.constant)
+        }
+      }
+    }
+  }
+
+  // COMPRESS_MULTI/COMPRESS_ARRAY compress stage; a constant block has no data, only its median
+  val processorStart = multiMode && processorStarts.orR
+  drainQueue.io.enq.valid := multiConstant || processorStart
+  drainQueue.io.enq.bits.constant := bankConstant(computeBank)
+  drainQueue.io.enq.bits.medianValue := bankMedian(computeBank)
+  drainQueue.io.enq.bits.unit := computeUnit
+  when(multiConstant) {
+    bankFull(computeBank) := false.B
+    computeBank := nextBank(computeBank)
+  }
+  when(processorStart) {
+    bankIssued(computeBank) := true.B
+    computeBank := nextBank(computeBank)
+  }
+  for ((blockProcessor, unit) <- blockProcessors.zipWithIndex) {
+    val bank = Mux(blockProcessor.io.inputDone.bits.asBool, (processors + unit).U, unit.U)
+    when(multiMode && blockProcessor.io.inputDone.valid) {
+      bankFull(bank) := false.B
+      bankIssued(bank) := false.B
+    }
+  }
+
+  // COMPRESS_MULTI/COMPRESS_ARRAY drain stage: the writer stores the block, its size and, for a constant
+  // block, its median, then the processor's output buffer is released. Without SET_OUTPUT the compressed size
+  // is only accounted
+  val drainHead = drainQueue.io.deq.bits
+  val readUnit = Mux(multiMode, drainHead.unit, 0.U) // COMPRESS writes back the result of the first processor
+  val unitOutputValid = VecInit(blockProcessors.map(_.io.outputValid))(readUnit)
+  val unitOutputSize = VecInit(blockProcessors.map(_.io.outputSize))(readUnit)
+  val drainReady = drainQueue.io.deq.valid && (drainHead.constant || unitOutputValid)
+  val drainSize = Mux(drainHead.constant, 0.U, unitOutputSize)
+  blockProcessors.foreach(_.io.readAddr := writer.io.readAddr)
+  writer.io.readData := VecInit(blockProcessors.map(_.io.readData))(readUnit)
+  writer.io.start.valid := Mux(multiMode, drainReady && !draining && outputBase =/= 0.U,
+                               state === sWriteBack && !writeIssued)
+  writer.io.start.bits.addr := Mux(multiMode, drainAddr, compressOutAddr)
+  writer.io.start.bits.nbBytes := Mux(multiMode, drainSize, outputSize)
+  writer.io.start.bits.writeSize := multiMode && sizeBase =/= 0.U
+  writer.io.start.bits.sizeAddr := sizeBase + (drainedCount << 1)
+  writer.io.start.bits.writeWord := multiMode && drainHead.constant && mediansBase =/= 0.U
+  writer.io.start.bits.wordAddr := mediansBase + (drainedCount << 2)
+  writer.io.start.bits.word := drainHead.medianValue
+  when(writer.io.start.fire) {
+    draining := multiMode
+    writeIssued := !multiMode
+  }
+  val drainDone = Mux(outputBase === 0.U, drainReady, draining && writer.io.start.ready)
+  drainQueue.io.deq.ready := multiMode && drainDone
+  when(multiMode && drainDone) {
+    multiTotal := multiTotal + drainSize
+    drainAddr := drainAddr + drainSize
+    drainedCount := drainedCount + 1.U
+    draining := false.B
+  }
+  // COMPRESS keeps its result until it has been written back, or releases it right away without an output address
+  for ((blockProcessor, unit) <- blockProcessors.zipWithIndex) {
+    blockProcessor.io.outputReady := Mux(multiMode, drainDone && !drainHead.constant && drainHead.unit === unit.U,
+                                         (unit == 0).B && ((state === sStoreResult && compressOutAddr === 0.U) ||
+                                                           (state === sWriteBack && writeIssued && writer.io.idle)))
+  }
+
+  // Performance counters (READ_COUNTER), 64 bits so that they do not wrap in a run; they count from reset or from
+  // the last READ_COUNTER that cleared them
+  val counterClear = WireDefault(false.B)
+  def perfCounter(increment: UInt): UInt = {
+    val count = RegInit(0.U(64.W))
+    count := Mux(counterClear, 0.U, count + increment)
+    count
+  }
+  val bytesOut = blockProcessors.map(bp => Mux(bp.io.outputValid && bp.io.outputReady, bp.io.outputSize, 0.U))
+  val eventCounters = Seq(
+    perfCounter(io.busy),                                                      // 0 busy cycles
+    perfCounter(io.memReq.valid && !io.memReq.ready),                          // 1 memory stall cycles
+    perfCounter(io.memReq.fire && !io.memReq.bits.write),                      // 2 loads
+    perfCounter(io.memReq.fire && io.memReq.bits.write),                       // 3 stores
+    perfCounter(PopCount(processorStarts) +& multiConstant),                   // 4 blocks
+    perfCounter(multiConstant),                                                // 5 constant blocks
+    perfCounter(loaders.zip(loadToDesc).map { case (loader, toDesc) =>
+                  Mux(loader.io.out.valid && !toDesc, Mux(loader.io.out.bits.pair, 8.U, 4.U), 0.U)
+                }.reduce(_ +& _) +& Mux(state === sLoadDataFromCPU, 4.U, 0.U)), // 6 bytes in (values)
+    perfCounter(bytesOut.reduce(_ +& _)),                                      // 7 bytes out (compressed blocks)
+    perfCounter(processorBusy),                                                // 8 block processor busy cycles
+    perfCounter(!loadersIdle),                                                 // 9 loader busy cycles
+    perfCounter(!writer.io.idle)                                               // 10 writer busy cycles
+  )
+  require(eventCounters.length == SZxAcceleratorCore.counterEvents)
+  val stateCounters = Seq(sIdle, sProcessBlock, sStoreResult, sComplete, sWaitResponse, sLoadDataFromCPU, sGetResult,
+                          sBulkLoad, sWaitLoad, sMulti, sWriteBack).map(s => perfCounter(state === s))
+  // Cycles of the load units in each state, summed over the units
+  val loadStateCounters = Seq(lIdle, lFetchDesc, lWaitDesc, lLoad, lWaitLoad, lStats)
+    .map(s => perfCounter(PopCount(loadState.map(_ === s))))
+  def padCounters(counters: Seq[UInt], entries: Int): Seq[UInt] =
+    counters ++ Seq.fill(entries - counters.length)(0.U(64.W))
+  val counters = VecInit(
+    padCounters(eventCounters, SZxAcceleratorCore.stateCounters) ++
+    padCounters(stateCounters, SZxAcceleratorCore.loadStateCounters - SZxAcceleratorCore.stateCounters) ++
+    loadStateCounters)
+
+  // Pipeline status, for the stall breakdown of the co-simulation
+  io.status.active := multiMode
+  io.status.loading := !loadersIdle
+  io.status.bankWait := (0 until processors).map(u => loadState(u) === lLoad && bankFull(loadBank(u))).reduce(_ || _)
+  io.status.statsWait := loadState.map(_ === lStats).reduce(_ || _)
+  io.status.inputStarved := multiMode && VecInit(blockProcessors.map(_.io.start.ready))(computeUnit) &&
+                            !bankFull(computeBank)
+  io.status.processing := processorBusy
+  io.status.drainWait := drainReady && draining
+  io.status.memBackpressure := io.memReq.valid && !io.memReq.ready
+
+  // State machine logic for hardware-software partitioning
+  switch(state) {
+    is(sIdle) {
+      when(io.cmd.valid && io.cmd.ready) {
+        printf("SZxRoCC: Received command, funct=%d, rs1=0x%x, rs2=0x%x, rd=%d\n",
+               io.cmd.bits.funct, io.cmd.bits.rs1, io.cmd.bits.rs2, io.cmd.bits.rd)
+        // Store destination register for response
+        stored_rd := io.cmd.bits.rd
+        switch(io.cmd.bits.funct) {
+          is(0.U) { // CONFIG: rs1=errorBound, rs2=medianValue
+            printf("SZxRoCC: Processing CONFIG command\n")
+            errorBound := io.cmd.bits.rs1
+            medianValue := io.cmd.bits.rs2
+            compressedSize := 0.U
+            state := sComplete
+            printf("SZxRoCC: CONFIG command completed\n")
+          }
+          is(1.U) { // SET_RADIUS: rs1=radius
+            printf("SZxRoCC: Processing SET_RADIUS command\n")
+            radius := io.cmd.bits.rs1
+            compressedSize := 0.U
+            state := sComplete
+            printf("SZxRoCC: SET_RADIUS command completed\n")
+          }
+                  is(2.U) { // COMPRESS_BLOCK: rs1=input_addr, rs2=output_addr (0 = only return the compressed size)
+          printf("SZxRoCC: Processing COMPRESS_BLOCK command - Hardware acceleration\n")
+          printf("SZxRoCC: Input addr=0x%x, Output addr=0x%x\n", io.cmd.bits.rs1, io.cmd.bits.rs2)
+          compressOutAddr := io.cmd.bits.rs2
+
+          // Data should already be in scratchpad from LOAD_DATA commands
+          // Go directly to processing since data is already loaded
+          printf("SZxRoCC: Data already in scratchpad, starting hardware compression directly\n")
+          dataIndex := 0.U
+          multiMode := false.B
+          state := sProcessBlock
+        }
+          is(3.U) { // COMPRESS_MULTI: rs1=descriptor table address, rs2=number of descriptors
+            printf("SZxRoCC: Processing COMPRESS_MULTI command - %d blocks, descriptor table at 0x%x\n",
+                   io.cmd.bits.rs2, io.cmd.bits.rs1)
+            // The blocks stream through the load, compress and drain stages; one response carries the total size
+            descTableAddr := io.cmd.bits.rs1
+            descCount := io.cmd.bits.rs2
+            statsMode := false.B
+            for (u <- 0 until processors) {
+              loadIndex(u) := u.U
+              loadLocal(u) := 0.U
+              loadState(u) := Mux(io.cmd.bits.rs2 > u.U, lFetchDesc, lIdle)
+            }
+            drainedCount := 0.U
+            computeBank := 0.U
+            drainAddr := outputBase
+            multiTotal := 0.U
+            compressedSize := 0.U
+            multiMode := io.cmd.bits.rs2 =/= 0.U
+            state := Mux(io.cmd.bits.rs2 === 0.U, sComplete, sMulti)
+          }
+          is(4.U) { // LOAD_DATA: rs1=data_value, rs2=index
+            printf("SZxRoCC: Processing LOAD_DATA command - Loading data to scratchpad\n")
+            printf("SZxRoCC: Data value=0x%x, Index=%d\n", io.cmd.bits.rs1, io.cmd.bits.rs2)
+            dataLoadValue := io.cmd.bits.rs1
+            dataLoadIndex := io.cmd.bits.rs2
+            state := sLoadDataFromCPU
+          }
+          is(5.U) {  // SZX_GET_RESULT
+            printf("SZxRoCC: Processing GET_RESULT command - Returning compressed result\n")
+            compressedSize := outputSize
+            state := sComplete
+          }
+          is(7.U) {  // SZX_SET_OUTPUT: rs1=output address of COMPRESS_MULTI, rs2=address of its uint16 size array
+            printf("SZxRoCC: Processing SET_OUTPUT command - blocks to 0x%x, sizes to 0x%x\n",
+                   io.cmd.bits.rs1, io.cmd.bits.rs2)
+            outputBase := io.cmd.bits.rs1
+            sizeBase := io.cmd.bits.rs2
+            compressedSize := 0.U
+            state := sComplete
+          }
+          is(8.U) {  // SZX_SET_MEDIANS: rs1=address of the float median array of COMPRESS_ARRAY
+            printf("SZxRoCC: Processing SET_MEDIANS command - medians to 0x%x\n", io.cmd.bits.rs1)
+            mediansBase := io.cmd.bits.rs1
+            compressedSize := 0.U
+            state := sComplete
+          }
+          is(9.U) {  // SZX_COMPRESS_ARRAY: rs1=address of the first value, rs2=number of values
+            printf("SZxRoCC: Processing COMPRESS_ARRAY command - %d values at 0x%x\n",
+                   io.cmd.bits.rs2, io.cmd.bits.rs1)
+            // As COMPRESS_MULTI on blocks of blockLength values (the last one may be shorter), with the block
+            // statistics and the constant-block decision made here: block i's size goes to sizeBase + 2*i
+            // (0 = constant) and a constant block's median to mediansBase + 4*i
+            descCount := ~0.U(64.W) // until the last block is loaded
+            statsMode := true.B
+            for (u <- 0 until processors) {
+              val offset = blockLength * u.U // block u, the first of load unit u
+              arrayAddr(u) := io.cmd.bits.rs1 + (offset << 2)
+              arrayRemaining(u) := io.cmd.bits.rs2 - offset
+              loadIndex(u) := u.U
+              loadLocal(u) := 0.U
+              loadState(u) := Mux(io.cmd.bits.rs2 > offset, lLoad, lIdle)
+            }
+            drainedCount := 0.U
+            computeBank := 0.U
+            drainAddr := outputBase
+            multiTotal := 0.U
+            compressedSize := 0.U
+            multiMode := io.cmd.bits.rs2 =/= 0.U
+            state := Mux(io.cmd.bits.rs2 === 0.U, sComplete, sMulti)
+          }
+          is(10.U) {  // SZX_SET_BLOCK: rs1=values per block (1 to maxBlockSize) of COMPRESS, COMPRESS_MULTI and COMPRESS_ARRAY
+            printf("SZxRoCC: Processing SET_BLOCK command - %d values per block\n", io.cmd.bits.rs1)
+            // An out-of-range size is clamped; the response is the size applied, so that the host can tell
+            val length = Mux(io.cmd.bits.rs1 === 0.U, 1.U, Mux(io.cmd.bits.rs1 > maxBlockSize.U, maxBlockSize.U,
+                                                                io.cmd.bits.rs1(lengthBits - 1, 0)))
+            blockLength := length
+            singleLength := length
+            compressedSize := length
+            state := sComplete
+          }
+          is(11.U) {  // SZX_READ_COUNTER: rs1=counter index, rs2=1 to clear all counters after the read
+            val index = io.cmd.bits.rs1
+            compressedSize := Mux(index < counters.length.U, counters(index(log2Ceil(counters.length) - 1, 0)), 0.U)
+            counterClear := io.cmd.bits.rs2(0)
+            state := sComplete
+          }
+          is(6.U) {  // SZX_LOAD_BLOCK - Bulk block loading: rs1=block address, rs2=number of values; returns the
+                     // number of values loaded, at most maxBlockSize
+            printf("SZxRoCC: Processing LOAD_BLOCK command - Bulk loading from memory\n")
+            val blockStartAddr = io.cmd.bits.rs1
+            val blockLength = io.cmd.bits.rs2
+            printf("SZxRoCC: Loading block from addr=0x%x, size=%d\n", blockStartAddr, blockLength)
+
+            // The memory engine loads the entire block into the scratchpad; COMPRESS then compresses it
+            // This eliminates 64 individual RoCC calls per block
+            bulkTransferAddr := blockStartAddr
+            val words = Mux(blockLength > maxBlockSize.U, maxBlockSize.U, blockLength(lengthBits - 1, 0))
+            bulkTransferWords := words
+            singleLength := Mux(words === 0.U, 1.U, words)
+            multiMode := false.B
+            state := sBulkLoad
+          }
+        }
+      }
+    }
+    is(sProcessBlock) {
+      when(dataIndex === 0.U) {
+        printf("SZxRoCC: Starting hardware compression, dataIndex=%d\n", dataIndex)
+      }
+
+      // Wait for hardware compression to complete; the pipeline has a fixed latency, so there is no timeout
+      when(processIssued && blockProcessors(0).io.outputValid) {
+        printf("SZxRoCC: Hardware compression completed!\n");
+        printf("SZxRoCC: Output size from hardware: %d bytes\n", blockProcessors(0).io.outputSize);
+        outputSize := blockProcessors(0).io.outputSize
+        compressedSize := blockProcessors(0).io.outputSize
+        processIssued := false.B
+        state := sStoreResult
+      }
+
+      dataIndex := dataIndex + 1.U
+    }
+    is(sStoreResult) {
+      printf("SZxRoCC: Compressed data ready in scratchpad\n")
+      printf("SZxRoCC: Output size: %d bytes\n", outputSize)
+
+      when(compressOutAddr =/= 0.U) {
+        state := sWriteBack
+      }.otherwise {
+        printf("SZxRoCC: Compressed data available in scratchpad for CPU to read\n")
+        state := sComplete
+      }
+    }
+    is(sWriteBack) {
+      // Store the block at the output address of COMPRESS; respond once the stores are acknowledged
+      when(writeIssued && writer.io.idle) {
+        printf("SZxRoCC: Compressed block written to 0x%x\n", compressOutAddr)
+        writeIssued := false.B
+        state := sComplete
+      }
+    }
+    is(sComplete) {
+      printf("SZxRoCC: Hardware acceleration completed, returning compressed size: %d\n", compressedSize)
+      // Move to wait response state to ensure proper timing
+      state := sWaitResponse
+    }
+    is(sWaitResponse) {
+      // Send response when ready
+      when(io.resp.ready) {
+        printf("SZxRoCC: Response sent to CPU, compressed size: %d bytes\n", compressedSize)
+        state := sIdle
+      }
+    }
+    is(sLoadDataFromCPU) {
+      printf("SZxRoCC: Loading data from CPU to scratchpad[%d] = 0x%x\n", dataLoadIndex, dataLoadValue)
+      // The value is written to bank 0 at the specified index by the scratchpad write port
+      compressedSize := 0.U // No compression result for data loading
+      state := sComplete
+    }
+    is(sGetResult) {
+      printf("SZxRoCC: Returning compressed result: %d bytes\n", outputSize)
+      // Return the stored compressed size
+      compressedSize := outputSize
+      state := sComplete
+    }
+    is(sBulkLoad) {
+      // Start the memory engine on the block; it issues up to 8 loads at a time, 2 values per load
+      when(loaders.head.io.start.fire) {
+        state := sWaitLoad
+      }
+    }
+    is(sWaitLoad) {
+      when(loaders.head.io.idle) {
+        printf("SZxRoCC: Bulk transfer complete, %d values in scratchpad\n", bulkTransferWords)
+        compressedSize := bulkTransferWords
+        state := sComplete
+      }
+    }
+    is(sMulti) {
+      // The load, compress and drain stages run on their own; the command completes once every block has drained
+      // and all of its stores have been acknowledged
+      when(drainedCount === descCount && writer.io.idle) {
+        printf("SZxRoCC: %d blocks done, %d bytes\n", descCount, multiTotal)
+        compressedSize := multiTotal
+        multiMode := false.B
+        state := sComplete
+      }
+    }
+  }
+
+  // Debug output for hardware-software partitioning
+  when(state === sProcessBlock) {
+    printf("SZxRoCC: Hardware compression state - outputSize=%d, outputValid=%d, busy=%d, startReady=%d\n",
+           blockProcessors(0).io.outputSize, blockProcessors(0).io.outputValid, blockProcessors(0).io.busy,
+           blockProcessors(0).io.start.ready)
+  }
+
+  when(state === sStoreResult) {
+    printf("SZxRoCC: Storing hardware compression result, outputSize=%d\n", outputSize)
+  }
+}
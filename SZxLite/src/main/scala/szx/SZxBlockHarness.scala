@@ -0,0 +1,61 @@
+package szx
+
+import chisel3._
+import chisel3.util._
+import circt.stage.ChiselStage
+
+// A command of the harness: funct, rs1 and rs2 as for the RoCC commands of SZxRoCCAccelerator
+class SZxHarnessCmd extends Bundle {
+  val funct = UInt(7.W)
+  val rs1 = UInt(64.W)
+  val rs2 = UInt(64.W)
+}
+
+// Standalone top for the cycle-accurate co-simulation of the accelerator under Verilator (SZxLite/sim): the
+// SZxAcceleratorCore of SZxRoCCAccelerator without Rocket Chip, so every command of rocc.h runs on the same
+// hardware as in the SoC. Each command gets a response, which the testbench always takes; the memory port carries
+// the engines' requests (top tag bits: the loader of processor u = u, the writer = processors) to the testbench's
+// memory model; a response comes for every request, stores included, in any order.
+class SZxBlockHarness(val maxBlockSize: Int = 1024, val lanes: Int = 8, val processors: Int = 1) extends Module {
+  val core = Module(new SZxAcceleratorCore(maxBlockSize, lanes, processors))
+  val memTagBits = core.memTagBits
+
+  val io = IO(new Bundle {
+    val cmd = Flipped(Decoupled(new SZxHarnessCmd))
+    val resp = Valid(UInt(64.W))
+    val busy = Output(Bool())
+
+    val memReq = Decoupled(new SZxMemReq(memTagBits))
+    val memResp = Flipped(Valid(new SZxMemResp(memTagBits)))
+
+    val status = Output(new SZxPipelineStatus)
+  })
+
+  core.io.cmd.valid := io.cmd.valid
+  core.io.cmd.bits.funct := io.cmd.bits.funct
+  core.io.cmd.bits.rd := 0.U
+  core.io.cmd.bits.rs1 := io.cmd.bits.rs1
+  core.io.cmd.bits.rs2 := io.cmd.bits.rs2
+  io.cmd.ready := core.io.cmd.ready
+  io.resp.valid := core.io.resp.valid
+  io.resp.bits := core.io.resp.bits.data
+  core.io.resp.ready := true.B
+  io.busy := core.io.busy
+
+  io.memReq <> core.io.memReq
+  core.io.memResp := io.memResp
+  io.status := core.io.status
+}
+
+// Emits the harness for SZxLite/sim:
+//   runMain szx.SZxBlockHarnessDriver [maxBlockSize=N] [lanes=N] [processors=N] --target-dir <dir>
+object SZxBlockHarnessDriver extends App {
+  val parameters = Seq("maxBlockSize=", "lanes=", "processors=")
+  val (settings, chiselArgs) = args.partition(arg => parameters.exists(arg.startsWith))
+  val values = settings.map(_.split('=')).map(kv => kv(0) -> kv(1).toInt).toMap
+  ChiselStage.emitSystemVerilogFile(
+    new SZxBlockHarness(values.getOrElse("maxBlockSize", 1024), values.getOrElse("lanes", 8),
+                        values.getOrElse("processors", 1)),
+    chiselArgs,
+    Array("-disable-all-randomization", "-strip-debug-info"))
+}
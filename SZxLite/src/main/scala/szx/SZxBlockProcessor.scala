@@ -44,6 +44,11 @@ class SZxBlockProcessor(val blockSize: Int = 64, val dataWidth: Int = 32) extend
   val outputReg = Reg(Vec(blockSize * 4, UInt(8.W)))  // Larger to hold full compressed output
   val outputSizeReg = RegInit(0.U(16.W))
 
+  // Block parameters, latched with the input so the caller can set up the next block while this one is compressed
+  val errorBoundReg = RegInit(0.U(32.W))
+  val medianValueReg = RegInit(0.U(32.W))
+  val radiusReg = RegInit(0.U(32.W))
+
   // Processing registers
   val processingIndex = RegInit(0.U((log2Ceil(blockSize) + 1).W))  // +1 to handle values up to blockSize
   val minVal = RegInit(0.U(dataWidth.W))
@@ -78,7 +83,7 @@ class SZxBlockProcessor(val blockSize: Int = 64, val dataWidth: Int = 32) extend
 
   // Output signals
   io.inputReady := (state === sIdle) && !busy
-  io.outputValid := (state === sOutput)
+  io.outputValid := (state === sOutput) && outputFormatted  // outputReg holds the formatted block
   io.outputData := outputReg
   io.outputSize := outputSizeReg
   io.busy := busy
@@ -186,7 +191,7 @@ class SZxBlockProcessor(val blockSize: Int = 64, val dataWidth: Int = 32) extend
 
         // For sCompress: compress elements
         when(state === sCompress) {
-          val currentValue = inputReg(elementIdx) - io.medianValue
+          val currentValue = inputReg(elementIdx) - medianValueReg
           val shiftedValue = currentValue >> rightShiftBits
           val xorResult = shiftedValue ^ prevValue
           val leadingNum = detectLeadingZeros(xorResult)
@@ -257,6 +262,9 @@ class SZxBlockProcessor(val blockSize: Int = 64, val dataWidth: Int = 32) extend
       when(io.inputValid && io.inputReady) {
         printf("SZxBlockProcessor: Transitioning from sIdle to sFindStats\n")
         inputReg := io.inputData
+        errorBoundReg := io.errorBound
+        medianValueReg := io.medianValue
+        radiusReg := io.radius
         state := sFindStats
         busy := true.B
         processingIndex := 0.U
@@ -295,8 +303,8 @@ class SZxBlockProcessor(val blockSize: Int = 64, val dataWidth: Int = 32) extend
 
     is(sCalculatePrecision) {
       // Calculate precision requirements based on error bound and radius (matches C implementation)
-      val radExpo = getExponentFloat(io.radius)
-      val reqExpo = getPrecisionReqLength(io.errorBound)
+      val radExpo = getExponentFloat(radiusReg)
+      val reqExpo = getPrecisionReqLength(errorBoundReg)
 
       // C implementation: reqLength = 9 + radExpo - reqExpo + 1
       val calculatedReqLength = 9.U + radExpo - reqExpo + 1.U
@@ -347,10 +355,10 @@ class SZxBlockProcessor(val blockSize: Int = 64, val dataWidth: Int = 32) extend
       when(!outputFormatted) {
         // Header: reqLength(1) + medianValue(4)
         outputReg(0) := reqLength(7, 0)
-        outputReg(1) := io.medianValue(7, 0)
-        outputReg(2) := io.medianValue(15, 8)
-        outputReg(3) := io.medianValue(23, 16)
-        outputReg(4) := io.medianValue(31, 24)
+        outputReg(1) := medianValueReg(7, 0)
+        outputReg(2) := medianValueReg(15, 8)
+        outputReg(3) := medianValueReg(23, 16)
+        outputReg(4) := medianValueReg(31, 24)
 
         // Leading numbers: pack 4x 2-bit values per byte
         val leadingNumbersSize = (blockSize + 3) / 4
@@ -0,0 +1,105 @@
+package szx
+
+import chisel3._
+import chisel3.util._
+import hardfloat._
+
+// Statistics of one block, as computeBlockStateMedianRadius_float: min and max are gathered while the values
+// stream in (in any order), then radius = (max - min) / 2, median = min + radius, and the block is constant
+// when radius <= errorBound. The float arithmetic uses hardfloat in round-to-nearest-even, like the C code.
+class SZxBlockStats(val indexBits: Int) extends Module {
+  val io = IO(new Bundle {
+    val clear = Input(Bool())                                  // a new block starts streaming in
+    val in = Flipped(Valid(new SZxLoadedWords(indexBits)))
+    val errorBound = Input(UInt(32.W))
+
+    val start = Input(Bool())                                  // all values are in
+    val done = Output(Bool())                                  // held until the next clear
+    val medianValue = Output(UInt(32.W))
+    val radius = Output(UInt(32.W))
+    val constant = Output(Bool())
+  })
+
+  // Unsigned order of the keys is the float order (NaN aside)
+  def orderKey(x: UInt): UInt = Mux(x(31), ~x, x | "h80000000".U(32.W))
+  def fmin(a: UInt, b: UInt): UInt = Mux(orderKey(b) < orderKey(a), b, a)
+  def fmax(a: UInt, b: UInt): UInt = Mux(orderKey(b) > orderKey(a), b, a)
+
+  val minVal = RegInit(0.U(32.W))
+  val maxVal = RegInit(0.U(32.W))
+  val empty = RegInit(true.B)
+
+  val a = io.in.bits.data(0)
+  val b = Mux(io.in.bits.pair, io.in.bits.data(1), io.in.bits.data(0))
+  when(io.clear) {
+    empty := true.B
+  }.elsewhen(io.in.valid) {
+    minVal := Mux(empty, fmin(a, b), fmin(minVal, fmin(a, b)))
+    maxVal := Mux(empty, fmax(a, b), fmax(maxVal, fmax(a, b)))
+    empty := false.B
+  }
+
+  // One float operation per cycle: range, radius, median and the constant test
+  val sIdle :: sRange :: sRadius :: sMedian :: sDone :: Nil = Enum(5)
+  val state = RegInit(sIdle)
+  val rangeRec = Reg(UInt(33.W))
+  val radiusRec = Reg(UInt(33.W))
+  val medianRec = Reg(UInt(33.W))
+  val constant = RegInit(false.B)
+
+  val sub = Module(new AddRecFN(8, 24))
+  sub.io.subOp := true.B
+  sub.io.a := recFNFromFN(8, 24, maxVal)
+  sub.io.b := recFNFromFN(8, 24, minVal)
+  sub.io.roundingMode := consts.round_near_even
+  sub.io.detectTininess := consts.tininess_afterRounding
+
+  val half = Module(new MulRecFN(8, 24))
+  half.io.a := rangeRec
+  half.io.b := recFNFromFN(8, 24, "h3f000000".U(32.W)) // 0.5f
+  half.io.roundingMode := consts.round_near_even
+  half.io.detectTininess := consts.tininess_afterRounding
+
+  val add = Module(new AddRecFN(8, 24))
+  add.io.subOp := false.B
+  add.io.a := recFNFromFN(8, 24, minVal)
+  add.io.b := radiusRec
+  add.io.roundingMode := consts.round_near_even
+  add.io.detectTininess := consts.tininess_afterRounding
+
+  val cmp = Module(new CompareRecFN(8, 24))
+  cmp.io.a := radiusRec
+  cmp.io.b := recFNFromFN(8, 24, io.errorBound)
+  cmp.io.signaling := false.B
+
+  switch(state) {
+    is(sIdle) {
+      when(io.start) {
+        state := sRange
+      }
+    }
+    is(sRange) {
+      rangeRec := sub.io.out
+      state := sRadius
+    }
+    is(sRadius) {
+      radiusRec := half.io.out
+      state := sMedian
+    }
+    is(sMedian) {
+      medianRec := add.io.out
+      constant := cmp.io.lt || cmp.io.eq
+      state := sDone
+    }
+    is(sDone) {
+      when(io.clear) {
+        state := sIdle
+      }
+    }
+  }
+
+  io.done := state === sDone
+  io.medianValue := fNFromRecFN(8, 24, medianRec)
+  io.radius := fNFromRecFN(8, 24, radiusRec)
+  io.constant := constant
+}
@@ -0,0 +1,102 @@
+package szx
+
+import chisel3._
+import chisel3.util._
+
+// A memory request of one of the accelerator's load/store engines. SZxRoCCAcceleratorModule turns it
+// into an io.mem (L1 data cache) request; size is log2 of the access width (2 = 4 bytes, 3 = 8 bytes).
+class SZxMemReq(val tagBits: Int) extends Bundle {
+  val addr = UInt(64.W)
+  val write = Bool()
+  val size = UInt(2.W)
+  val data = UInt(64.W)
+  val tag = UInt(tagBits.W)
+}
+
+class SZxMemResp(val tagBits: Int) extends Bundle {
+  val tag = UInt(tagBits.W)
+  val data = UInt(64.W)
+}
+
+class SZxLoadCmd(val maxWords: Int) extends Bundle {
+  val addr = UInt(64.W)
+  val nbWords = UInt(log2Ceil(maxWords + 1).W)
+}
+
+// Words delivered by SZxMemLoader: data(0) is the word at index, data(1) the word at index + 1 when pair is set
+class SZxLoadedWords(val indexBits: Int) extends Bundle {
+  val index = UInt(indexBits.W)
+  val data = Vec(2, UInt(32.W))
+  val pair = Bool()
+}
+
+// Loads nbWords consecutive 32-bit words starting at addr through the cache port, with up to `slots`
+// requests in flight. An aligned pair of words is fetched with one 8-byte load. Responses may come back
+// in any order (nacked requests are replayed by the cache interface): the tag names the slot, which
+// remembers the word index the response belongs to.
+class SZxMemLoader(val maxWords: Int, val slots: Int = 8) extends Module {
+  require(maxWords >= 2 && slots >= 2 && isPow2(slots))
+  val indexBits = log2Ceil(maxWords)
+  val tagBits = log2Ceil(slots)
+
+  val io = IO(new Bundle {
+    val start = Flipped(Decoupled(new SZxLoadCmd(maxWords)))
+    val idle = Output(Bool())
+
+    val req = Decoupled(new SZxMemReq(tagBits))
+    val resp = Flipped(Valid(new SZxMemResp(tagBits)))
+
+    val out = Valid(new SZxLoadedWords(indexBits))
+  })
+
+  val active = RegInit(false.B)
+  val addr = RegInit(0.U(64.W))
+  val nextWord = RegInit(0.U(log2Ceil(maxWords + 1).W))
+  val nbWords = RegInit(0.U(log2Ceil(maxWords + 1).W))
+
+  // Outstanding requests
+  val slotBusy = RegInit(VecInit(Seq.fill(slots)(false.B)))
+  val slotIndex = Reg(Vec(slots, UInt(indexBits.W)))
+  val slotPair = Reg(Vec(slots, Bool()))
+  val freeSlot = PriorityEncoder(slotBusy.map(!_))
+  val pair = addr(2) === 0.U && nbWords - nextWord >= 2.U
+
+  io.start.ready := !active
+  io.idle := !active
+
+  io.req.valid := active && nextWord < nbWords && !slotBusy.asUInt.andR
+  io.req.bits.addr := addr
+  io.req.bits.write := false.B
+  io.req.bits.size := Mux(pair, 3.U, 2.U)
+  io.req.bits.data := 0.U
+  io.req.bits.tag := freeSlot
+
+  when(io.start.fire) {
+    active := true.B
+    addr := io.start.bits.addr
+    nextWord := 0.U
+    nbWords := io.start.bits.nbWords
+  }
+
+  when(io.req.fire) {
+    slotBusy(freeSlot) := true.B
+    slotIndex(freeSlot) := nextWord(indexBits - 1, 0)
+    slotPair(freeSlot) := pair
+    nextWord := nextWord + Mux(pair, 2.U, 1.U)
+    addr := addr + Mux(pair, 8.U, 4.U)
+  }
+
+  // Loads are unsigned, so a 4-byte response holds the word in its low half
+  io.out.valid := io.resp.valid
+  io.out.bits.index := slotIndex(io.resp.bits.tag)
+  io.out.bits.data(0) := io.resp.bits.data(31, 0)
+  io.out.bits.data(1) := io.resp.bits.data(63, 32)
+  io.out.bits.pair := slotPair(io.resp.bits.tag)
+  when(io.resp.valid) {
+    slotBusy(io.resp.bits.tag) := false.B
+  }
+
+  when(active && nextWord === nbWords && !slotBusy.asUInt.orR) {
+    active := false.B
+  }
+}
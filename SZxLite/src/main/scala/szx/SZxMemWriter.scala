@@ -0,0 +1,113 @@
+package szx
+
+import chisel3._
+import chisel3.util._
+
+class SZxWriteCmd(val maxBytes: Int) extends Bundle {
+  val addr = UInt(64.W)
+  val nbBytes = UInt(log2Ceil(maxBytes + 1).W)
+  val writeSize = Bool()     // also store nbBytes as a 16-bit value at sizeAddr (the block's O[] entry)
+  val sizeAddr = UInt(64.W)
+  val writeWord = Bool()     // then store word at wordAddr (a constant block's median)
+  val wordAddr = UInt(64.W)
+  val word = UInt(32.W)
+}
+
+// A block in flight between the compress and drain stages of the accelerator; a constant block has only its median,
+// the others are the oldest result of block processor `unit`
+class SZxDrainToken(val unitBits: Int = 1) extends Bundle {
+  val constant = Bool()
+  val medianValue = UInt(32.W)
+  val unit = UInt(unitBits.W)
+}
+
+// Stores nbBytes bytes of a source buffer at addr through the cache port, with up to `slots` stores in flight:
+// single bytes up to the first 8-byte boundary, then 8 bytes per store, then single bytes for the tail,
+// followed by the optional size and word stores.
+// The source is read through a synchronous port (SRAM): readData holds bytes readAddr .. readAddr+7 of the previous
+// cycle and must not change until start is ready again; idle also waits for the stores to be acknowledged.
+// As for the core's stores, the data is replicated over the 64-bit store data word.
+class SZxMemWriter(val maxBytes: Int, val slots: Int = 8) extends Module {
+  require(maxBytes >= 8 && slots >= 2 && isPow2(slots))
+  val readAddrBits = log2Ceil(maxBytes + 8)
+  val tagBits = log2Ceil(slots)
+
+  val io = IO(new Bundle {
+    val start = Flipped(Decoupled(new SZxWriteCmd(maxBytes)))
+    val idle = Output(Bool())
+    val readAddr = Output(UInt(readAddrBits.W))
+    val readData = Input(Vec(8, UInt(8.W)))
+
+    val req = Decoupled(new SZxMemReq(tagBits))
+    val resp = Flipped(Valid(new SZxMemResp(tagBits)))
+  })
+
+  val active = RegInit(false.B)
+  val addr = RegInit(0.U(64.W))
+  val pos = RegInit(0.U(log2Ceil(maxBytes + 1).W))
+  val nbBytes = RegInit(0.U(log2Ceil(maxBytes + 1).W))
+  val sizePending = RegInit(false.B)
+  val sizeAddr = RegInit(0.U(64.W))
+  val wordPending = RegInit(false.B)
+  val wordAddr = RegInit(0.U(64.W))
+  val word = RegInit(0.U(32.W))
+  val fetched = RegInit(false.B) // readData holds the bytes at pos
+
+  // Outstanding stores
+  val slotBusy = RegInit(VecInit(Seq.fill(slots)(false.B)))
+  val freeSlot = PriorityEncoder(slotBusy.map(!_))
+
+  val doSize = pos === nbBytes && sizePending
+  val doWord = pos === nbBytes && !sizePending
+  val doData = pos < nbBytes
+  val wide = addr(2, 0) === 0.U && nbBytes - pos >= 8.U
+  val bytes8 = Cat(io.readData.reverse)
+  val byte = io.readData(0)
+
+  io.start.ready := !active
+  io.idle := !active && !slotBusy.asUInt.orR
+
+  io.req.valid := active && Mux(doData, fetched, sizePending || wordPending) && !slotBusy.asUInt.andR
+  io.req.bits.addr := Mux(doSize, sizeAddr, Mux(doWord, wordAddr, addr))
+  io.req.bits.write := true.B
+  io.req.bits.size := Mux(doSize, 1.U, Mux(doWord, 2.U, Mux(wide, 3.U, 0.U)))
+  io.req.bits.data := Mux(doSize, Fill(4, nbBytes.pad(16)),
+    Mux(doWord, Fill(2, word), Mux(wide, bytes8, Fill(8, byte))))
+  io.req.bits.tag := freeSlot
+
+  // The next bytes are read while the current ones are stored
+  io.readAddr := Mux(io.start.fire, 0.U, Mux(io.req.fire && doData, pos + Mux(wide, 8.U, 1.U), pos))
+  fetched := io.start.fire || active
+
+  when(io.start.fire) {
+    active := true.B
+    addr := io.start.bits.addr
+    pos := 0.U
+    nbBytes := io.start.bits.nbBytes
+    sizePending := io.start.bits.writeSize
+    sizeAddr := io.start.bits.sizeAddr
+    wordPending := io.start.bits.writeWord
+    wordAddr := io.start.bits.wordAddr
+    word := io.start.bits.word
+  }
+
+  when(io.req.fire) {
+    slotBusy(freeSlot) := true.B
+    when(doSize) {
+      sizePending := false.B
+    }.elsewhen(doWord) {
+      wordPending := false.B
+    }.otherwise {
+      pos := pos + Mux(wide, 8.U, 1.U)
+      addr := addr + Mux(wide, 8.U, 1.U)
+    }
+  }
+
+  when(io.resp.valid) {
+    slotBusy(io.resp.bits.tag) := false.B
+  }
+
+  when(active && pos === nbBytes && !sizePending && !wordPending) {
+    active := false.B
+  }
+}
@@ -0,0 +1,294 @@
+package szx
+
+import chisel3._
+import chisel3.util._
+import hardfloat._
+
+object SZxPipelinedBlockProcessor {
+  // reqLength, median, 2-bit leading numbers and up to 4 residual bytes per value
+  def maxCompressedBytes(blockSize: Int): Int = 1 + 4 + (blockSize + 3) / 4 + 4 * blockSize
+}
+
+// Per-block compression parameters, as computeReqLength_float and the setup of SZx_compress_one_block_float_sw
+class SZxBlockParams extends Bundle {
+  val reqLength = UInt(6.W)
+  val medianValue = UInt(32.W)  // 0 when reqLength was clamped to 32
+  val rightShift = UInt(3.W)
+  val reqBytes = UInt(3.W)      // residual bytes of a value whose leading number is 0
+}
+
+// A block to compress: `length` values in bank `bank` of the scratchpad
+class SZxBlockJob(val lengthBits: Int) extends Bundle {
+  val bank = UInt(1.W)
+  val length = UInt(lengthBits.W)
+  val errorBound = UInt(32.W)
+  val medianValue = UInt(32.W)
+  val radius = UInt(32.W)
+}
+
+// Fully pipelined block compressor with the semantics of SZx_compress_one_block_float_sw, for blocks of 1 to
+// maxBlockSize values. The block is read from the scratchpad one row of `lanes` values per cycle, so it takes
+// ceil(length/lanes) cycles and the next block follows without a bubble:
+//   fetch:   read the row of the beat (the scratchpad is a SyncReadMem of two banks, one column per lane)
+//   stage 1: value - median in float (round to nearest even), shifted right
+//   stage 2: XOR with the previous value (the last lane of the previous beat is kept in a register), leading numbers
+//   stage 3: prefix sum of the residual byte counts of the lanes, which places every lane's bytes (compaction)
+//   stage 4: write the beat's leading numbers and residual bytes to the block's output buffer
+// The two output buffers are SyncReadMems too, one byte column each for the leading numbers (8) and the residuals
+// (4 * lanes), so every beat writes and every read of 8 consecutive bytes touches a column at most once.
+// The pipeline only stalls when both output buffers hold a block that has not been released with outputReady.
+class SZxPipelinedBlockProcessor(val maxBlockSize: Int = 1024, val lanes: Int = 8) extends Module {
+  require(isPow2(lanes) && lanes >= 4 && lanes <= 32, "lanes must be 4, 8, 16 or 32")
+  require(maxBlockSize % lanes == 0, "lanes must divide maxBlockSize")
+  val rowsPerBank = maxBlockSize / lanes
+  val laneBits = log2Ceil(lanes)
+  val laneBytes = lanes * 4
+  val laneByteBits = log2Ceil(laneBytes)
+  val leadRows = (maxBlockSize / 4 + 7) / 8
+  val lengthBits = log2Ceil(maxBlockSize + 1)
+  val beatBits = log2Ceil(rowsPerBank max 2)
+  val maxBytes = SZxPipelinedBlockProcessor.maxCompressedBytes(maxBlockSize)
+  val byteAddrBits = log2Ceil(maxBytes + 8)
+
+  val io = IO(new Bundle {
+    val start = Flipped(Decoupled(new SZxBlockJob(lengthBits)))
+    val inputRow = Output(UInt(log2Ceil(2 * rowsPerBank).W))
+    val inputData = Input(Vec(lanes, UInt(32.W)))   // row inputRow of the previous cycle
+    val inputDone = Valid(UInt(1.W))                // the block of this bank has been read, the bank can be refilled
+
+    // Oldest compressed block: [reqLength][medianValue][leadingNumbers][residuals]
+    val outputValid = Output(Bool())
+    val outputSize = Output(UInt(16.W))
+    val outputReady = Input(Bool())                 // the block has been read out, release its buffer
+    val readAddr = Input(UInt(byteAddrBits.W))
+    val readData = Output(Vec(8, UInt(8.W)))        // bytes readAddr .. readAddr+7 of the previous cycle
+
+    val busy = Output(Bool())
+  })
+
+  def fit(x: UInt, entries: Int): UInt = x(log2Ceil(entries) - 1, 0)
+
+  // Block parameters: reqExpo is the exponent of the bound as a double (getPrecisionReqLength_double),
+  // which differs from the float exponent field for a subnormal bound
+  val ebExp = io.start.bits.errorBound(30, 23)
+  val reqExpo = Mux(ebExp === 0.U, Log2(io.start.bits.errorBound(22, 0)).zext - 149.S, ebExp.zext - 127.S)
+  val radExpo = io.start.bits.radius(30, 23).zext - 127.S
+  val calcLength = 10.S +& radExpo -& reqExpo
+  val params = Wire(new SZxBlockParams)
+  params.reqLength := Mux(calcLength < 9.S, 9.U, Mux(calcLength > 32.S, 32.U, calcLength.asUInt(5, 0)))
+  params.medianValue := Mux(calcLength > 32.S, 0.U, io.start.bits.medianValue)
+  params.rightShift := Mux(params.reqLength(2, 0) === 0.U, 0.U, (8.U - params.reqLength(2, 0))(2, 0))
+  params.reqBytes := (params.reqLength >> 3) + (params.reqLength(2, 0) =/= 0.U)
+
+  // Output buffers (stage 4)
+  val leadMem = Seq.fill(8)(SyncReadMem(2 * leadRows, UInt(8.W)))
+  val residualMem = Seq.fill(laneBytes)(SyncReadMem(2 * rowsPerBank, UInt(8.W)))
+  val asmBank = RegInit(0.U(1.W))
+  val outBank = RegInit(0.U(1.W))
+  val outFull = RegInit(VecInit(Seq.fill(2)(false.B)))
+  val outSize = Reg(Vec(2, UInt(16.W)))
+  val outParams = Reg(Vec(2, new SZxBlockParams))
+  val outLength = Reg(Vec(2, UInt(lengthBits.W)))
+  val residualPos = RegInit(0.U(log2Ceil(4 * maxBlockSize + 1).W))
+
+  // Stage registers; every stage holds while the pipeline stalls
+  val s3Valid = RegInit(false.B)
+  val stall = s3Valid && outFull(asmBank)
+  val advance = !stall
+
+  // Current job: the next one is accepted in the cycle its last beat is issued
+  val job = Reg(new SZxBlockJob(lengthBits))
+  val jobParams = Reg(new SZxBlockParams)
+  val jobActive = RegInit(false.B)
+  val jobBeat = RegInit(0.U(beatBits.W))
+  val jobLastBeat = RegInit(0.U(beatBits.W))
+  val issue = jobActive && advance
+  val lastBeat = jobBeat === jobLastBeat
+  io.start.ready := !jobActive || (issue && lastBeat)
+  when(issue) {
+    jobBeat := Mux(lastBeat, 0.U, jobBeat + 1.U)
+    when(lastBeat) {
+      jobActive := false.B
+    }
+  }
+  when(io.start.fire) {
+    job := io.start.bits
+    jobParams := params
+    jobActive := true.B
+    jobLastBeat := ((io.start.bits.length - 1.U) >> laneBits)(beatBits - 1, 0)
+  }
+
+  // Fetch: while the pipeline stalls the row of the fetched beat is read again, so inputData stays valid
+  val s0Valid = RegInit(false.B)
+  val s0Beat = Reg(UInt(beatBits.W))
+  val s0Last = Reg(Bool())
+  val s0Bank = Reg(UInt(1.W))
+  val s0Length = Reg(UInt(lengthBits.W))
+  val s0Params = Reg(new SZxBlockParams)
+  def inputRow(bank: UInt, beat: UInt): UInt = fit(Mux(bank.asBool, rowsPerBank.U, 0.U) + beat, 2 * rowsPerBank)
+  io.inputRow := Mux(advance, inputRow(job.bank, jobBeat), inputRow(s0Bank, s0Beat))
+  io.inputDone.valid := advance && s0Valid && s0Last
+  io.inputDone.bits := s0Bank
+  when(advance) {
+    s0Valid := issue
+    s0Beat := jobBeat
+    s0Last := lastBeat
+    s0Bank := job.bank
+    s0Length := job.length
+    s0Params := jobParams
+  }
+
+  // Stage 1: subtract the median and shift; the lanes past the end of the block are dropped
+  val s1Valid = RegInit(false.B)
+  val s1Beat = Reg(UInt(beatBits.W))
+  val s1Last = Reg(Bool())
+  val s1Length = Reg(UInt(lengthBits.W))
+  val s1Params = Reg(new SZxBlockParams)
+  val s1LaneValid = Reg(Vec(lanes, Bool()))
+  val s1Value = Reg(Vec(lanes, UInt(32.W)))
+  val subtract = Seq.fill(lanes)(Module(new AddRecFN(8, 24)))
+  for (j <- 0 until lanes) {
+    subtract(j).io.subOp := true.B
+    subtract(j).io.a := recFNFromFN(8, 24, io.inputData(j))
+    subtract(j).io.b := recFNFromFN(8, 24, s0Params.medianValue)
+    subtract(j).io.roundingMode := consts.round_near_even
+    subtract(j).io.detectTininess := consts.tininess_afterRounding
+  }
+  when(advance) {
+    s1Valid := s0Valid
+    s1Beat := s0Beat
+    s1Last := s0Last
+    s1Length := s0Length
+    s1Params := s0Params
+    for (j <- 0 until lanes) {
+      s1LaneValid(j) := (s0Beat << laneBits) +& j.U < s0Length
+      s1Value(j) := fNFromRecFN(8, 24, subtract(j).io.out) >> s0Params.rightShift
+    }
+  }
+
+  // Stage 2: XOR with the previous value and leading numbers; a dropped lane has leading number 0 and no residual,
+  // as the padding of convertIntArray2ByteArray_fast_2b_args
+  val s2Valid = RegInit(false.B)
+  val s2Beat = Reg(UInt(beatBits.W))
+  val s2Last = Reg(Bool())
+  val s2Length = Reg(UInt(lengthBits.W))
+  val s2Params = Reg(new SZxBlockParams)
+  val s2Value = Reg(Vec(lanes, UInt(32.W)))
+  val s2Lead = Reg(Vec(lanes, UInt(2.W)))
+  val s2Count = Reg(Vec(lanes, UInt(3.W)))
+  val prevValue = RegInit(0.U(32.W))
+  val previous = (0 until lanes).map(j => if (j == 0) Mux(s1Beat === 0.U, 0.U, prevValue) else s1Value(j - 1))
+  when(advance) {
+    s2Valid := s1Valid
+    s2Beat := s1Beat
+    s2Last := s1Last
+    s2Length := s1Length
+    s2Params := s1Params
+    s2Value := s1Value
+    for (j <- 0 until lanes) {
+      val xor = s1Value(j) ^ previous(j)
+      val lead = MuxCase(0.U(2.W), Seq(
+        (xor(31, 8) === 0.U) -> 3.U(2.W),
+        (xor(31, 16) === 0.U) -> 2.U(2.W),
+        (xor(31, 24) === 0.U) -> 1.U(2.W)
+      ))
+      s2Lead(j) := Mux(s1LaneValid(j), lead, 0.U)
+      s2Count(j) := Mux(s1LaneValid(j) && lead < s1Params.reqBytes, s1Params.reqBytes - lead, 0.U)
+    }
+    when(s1Valid) {
+      prevValue := s1Value(lanes - 1)
+    }
+  }
+
+  // Stage 3: compaction. Lane j's residual bytes are value bytes 4-reqBytes .. 3-lead, in ascending order, and
+  // start at the sum of the counts of lanes 0..j-1
+  val s3Beat = Reg(UInt(beatBits.W))
+  val s3Last = Reg(Bool())
+  val s3Length = Reg(UInt(lengthBits.W))
+  val s3Params = Reg(new SZxBlockParams)
+  val s3Lead = Reg(Vec(lanes, UInt(2.W)))
+  val s3Packed = Reg(Vec(laneBytes, UInt(8.W)))
+  val s3Total = Reg(UInt(log2Ceil(laneBytes + 1).W))
+  val offsets = s2Count.scanLeft(0.U(log2Ceil(laneBytes + 1).W))((sum, count) => sum + count)
+  when(advance) {
+    s3Valid := s2Valid
+    s3Beat := s2Beat
+    s3Last := s2Last
+    s3Length := s2Length
+    s3Params := s2Params
+    s3Lead := s2Lead
+    s3Total := offsets(lanes)
+    for (o <- 0 until laneBytes) {
+      val hits = (0 until lanes).map(j => offsets(j) <= o.U && o.U < offsets(j + 1))
+      val bytes = (0 until lanes).map { j =>
+        val valueBytes = VecInit((0 until 4).map(k => s2Value(j)(8 * k + 7, 8 * k)))
+        valueBytes((4.U - s2Params.reqBytes + (o.U - offsets(j)))(1, 0))
+      }
+      s3Packed(o) := Mux1H(hits, bytes)
+    }
+  }
+
+  // Stage 4: write to the output buffer of the block. The lanes/4 leading-number bytes of a beat start at a multiple
+  // of lanes/4 and so stay within one row of the 8 lead columns
+  when(s3Valid && advance) {
+    val leadStart = s3Beat << (laneBits - 2)
+    val leadRow = fit(Mux(asmBank.asBool, leadRows.U, 0.U) + (leadStart >> 3), 2 * leadRows)
+    val leadBytes = VecInit((0 until lanes / 4).map(m => Cat((0 until 4).map(k => s3Lead(4 * m + k)))))
+    for (c <- 0 until 8) {
+      val m = c.U - leadStart(2, 0)
+      when(c.U >= leadStart(2, 0) && m < (lanes / 4).U) {
+        leadMem(c).write(leadRow, leadBytes(fit(m, lanes / 4 max 2)))
+      }
+    }
+
+    val pos = Mux(s3Beat === 0.U, 0.U, residualPos)
+    val posCol = pos(laneByteBits - 1, 0)
+    for (c <- 0 until laneBytes) {
+      val o = (c.U - posCol)(laneByteBits - 1, 0)
+      val row = (pos >> laneByteBits) + (c.U < posCol)
+      when(o < s3Total) {
+        residualMem(c).write(fit(Mux(asmBank.asBool, rowsPerBank.U, 0.U) + row, 2 * rowsPerBank), s3Packed(o))
+      }
+    }
+    residualPos := pos + s3Total
+    when(s3Last) {
+      outFull(asmBank) := true.B
+      outSize(asmBank) := 5.U +& ((s3Length +& 3.U) >> 2) +& pos +& s3Total
+      outParams(asmBank) := s3Params
+      outLength(asmBank) := s3Length
+      asmBank := ~asmBank
+    }
+  }
+
+  // Reads of the oldest block: each column reads the row that holds its byte of the 8-byte window
+  val leadAddr = io.readAddr - 5.U
+  val leadData = (0 until 8).map { c =>
+    val q = leadAddr + (c.U - leadAddr(2, 0))(2, 0)
+    leadMem(c).read(fit(Mux(outBank.asBool, leadRows.U, 0.U) + (q >> 3), 2 * leadRows))
+  }
+  val residualBase = 5.U +& ((outLength(outBank) +& 3.U) >> 2)
+  val residualAddr = io.readAddr - residualBase
+  val residualData = (0 until laneBytes).map { c =>
+    val r = residualAddr + (c.U - residualAddr(laneByteBits - 1, 0))(laneByteBits - 1, 0)
+    residualMem(c).read(fit(Mux(outBank.asBool, rowsPerBank.U, 0.U) + (r >> laneByteBits), 2 * rowsPerBank))
+  }
+  val readAddr = RegNext(io.readAddr)
+  val readBase = RegNext(residualBase)
+  val readParams = RegNext(outParams(outBank))
+  val header = VecInit(Seq(readParams.reqLength.pad(8)) ++
+    (0 until 4).map(k => readParams.medianValue(8 * k + 7, 8 * k)) ++ Seq.fill(3)(0.U(8.W)))
+  for (k <- 0 until 8) {
+    val p = readAddr + k.U
+    io.readData(k) := Mux(p < 5.U, header(p(2, 0)),
+      Mux(p < readBase, VecInit(leadData)((p - 5.U)(2, 0)), VecInit(residualData)((p - readBase)(laneByteBits - 1, 0))))
+  }
+
+  io.outputValid := outFull(outBank)
+  io.outputSize := outSize(outBank)
+  when(io.outputValid && io.outputReady) {
+    outFull(outBank) := false.B
+    outBank := ~outBank
+  }
+
+  io.busy := jobActive || s0Valid || s1Valid || s2Valid || s3Valid || outFull.asUInt.orR
+}
@@ -4,11 +4,14 @@ import org.chipsalliance.cde.config.{Config, Parameters}
 import freechips.rocketchip.tile._
 import freechips.rocketchip.diplomacy._
 
-// Configuration to add SZx RoCC accelerator to a Chipyard design
-class WithSZxRoCCAccelerator extends Config((site, here, up) => {
+// Configuration to add SZx RoCC accelerator to a Chipyard design; maxBlockSize = largest block (values) of its
+// scratchpads, lanes = values per cycle of a block processor, processors = block processors working on the blocks
+// of one COMPRESS_MULTI/COMPRESS_ARRAY
+class WithSZxRoCCAccelerator(maxBlockSize: Int = 1024, lanes: Int = 8, processors: Int = 1)
+  extends Config((site, here, up) => {
   case BuildRoCC => up(BuildRoCC) ++ Seq(
     (p: Parameters) => LazyModule(
-      new szx.SZxRoCCAccelerator(OpcodeSet.custom0)(p)
+      new szx.SZxRoCCAccelerator(OpcodeSet.custom0, maxBlockSize, lanes, processors)(p)
     )
   )
 })
@@ -0,0 +1,234 @@
+#include <string.h>
+#include <bitshuffle.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+static const char *names[BS_NVARIANTS] = { "naive", "scalar", "sse2", "avx2", "avx512gfni" };
+
+const char *bitshuffle_name(int variant)
+{
+  return variant >= 0 && variant < BS_NVARIANTS ? names[variant] : "?";
+}
+
+int bitshuffle_supported(int variant)
+{
+  switch (variant) {
+  case BS_NAIVE:
+  case BS_SCALAR:
+	return 1;
+#if defined(__x86_64__)
+  case BS_SSE2:
+	return __builtin_cpu_supports("sse2");
+  case BS_AVX2:
+	return __builtin_cpu_supports("avx2");
+  case BS_AVX512GFNI:
+	return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi")
+	  && __builtin_cpu_supports("gfni");
+#endif
+  default:
+	return 0;
+  }
+}
+
+/* values from..n-1, 8 at a time; planes are n/8 bytes apart */
+static void bs_naive(const uint32_t *in, uint8_t *out, size_t n, size_t from)
+{
+  size_t nb = n/8;
+  for (int b=0; b<32; b++) {
+	for (size_t j=from; j<n; j+=8) {
+	  uint8_t v = 0;
+	  for (int m=0; m<8; m++)
+		v |= ((in[j+m]>>b)&1) << m;
+	  out[b*nb + j/8] = v;
+	}
+  }
+}
+
+/* transpose the 32x32 bit matrix a in place: bit i of a[p] becomes bit p of a[i] (as BitPlaneCompressor.transpose32) */
+static void transpose32(uint32_t *a)
+{
+  uint32_t m = 0x0000ffff;
+  for (int j=16; j!=0; j>>=1, m^=m<<j) {
+	for (int k=0; k<32; k=(k+j+1)&~j) {
+	  uint32_t t = ((a[k]>>j) ^ a[k+j]) & m;
+	  a[k+j] ^= t;
+	  a[k] ^= t << j;
+	}
+  }
+}
+
+/* the kernels return how many values they did; the rest is left to bs_naive */
+
+static size_t bs_scalar(const uint32_t *in, uint8_t *out, size_t n)
+{
+  size_t nb = n/8, i;
+  uint32_t t[32];
+  for (i=0; i+32<=n; i+=32) {
+	memcpy(t, in+i, sizeof(t));
+	transpose32(t);
+	for (int p=0; p<32; p++)
+	  memcpy(out + p*nb + i/8, &t[p], 4);
+  }
+  return i;
+}
+
+#if defined(__x86_64__)
+
+/*
+ * Byte transpose of 16 values (4 per 128-bit lane): y[k] byte m is byte k of value m.
+ * Each bit of a byte is then collected with movemask and a 1-bit shift.
+ */
+#define BYTE_TRANSPOSE(V, a0, a1, a2, a3, y) do {						\
+	V u0 = unpacklo8(a0, a1), u1 = unpackhi8(a0, a1);					\
+	V u2 = unpacklo8(a2, a3), u3 = unpackhi8(a2, a3);					\
+	V v0 = unpacklo8(u0, u1), v1 = unpackhi8(u0, u1);					\
+	V v2 = unpacklo8(u2, u3), v3 = unpackhi8(u2, u3);					\
+	V x0 = unpacklo8(v0, v1), x1 = unpackhi8(v0, v1);					\
+	V x2 = unpacklo8(v2, v3), x3 = unpackhi8(v2, v3);					\
+	y[0] = unpacklo64(x0, x2); y[1] = unpackhi64(x0, x2);				\
+	y[2] = unpacklo64(x1, x3); y[3] = unpackhi64(x1, x3);				\
+  } while (0)
+
+#define unpacklo8  _mm_unpacklo_epi8
+#define unpackhi8  _mm_unpackhi_epi8
+#define unpacklo64 _mm_unpacklo_epi64
+#define unpackhi64 _mm_unpackhi_epi64
+
+__attribute__((target("sse2")))
+static size_t bs_sse2(const uint32_t *in, uint8_t *out, size_t n)
+{
+  size_t nb = n/8, i;
+  for (i=0; i+16<=n; i+=16) {
+	__m128i a0 = _mm_loadu_si128((const __m128i *)(in+i));
+	__m128i a1 = _mm_loadu_si128((const __m128i *)(in+i+4));
+	__m128i a2 = _mm_loadu_si128((const __m128i *)(in+i+8));
+	__m128i a3 = _mm_loadu_si128((const __m128i *)(in+i+12));
+	__m128i y[4];
+	BYTE_TRANSPOSE(__m128i, a0, a1, a2, a3, y);
+	for (int k=0; k<4; k++) {
+	  for (int b=7; b>=0; b--) {
+		uint16_t m = (uint16_t)_mm_movemask_epi8(y[k]);
+		memcpy(out + (8*k+b)*nb + i/8, &m, 2);
+		y[k] = _mm_slli_epi16(y[k], 1);
+	  }
+	}
+  }
+  return i;
+}
+
+#undef unpacklo8
+#undef unpackhi8
+#undef unpacklo64
+#undef unpackhi64
+#define unpacklo8  _mm256_unpacklo_epi8
+#define unpackhi8  _mm256_unpackhi_epi8
+#define unpacklo64 _mm256_unpacklo_epi64
+#define unpackhi64 _mm256_unpackhi_epi64
+
+/* values 0..15 in the low lanes, 16..31 in the high lanes, so the movemask covers all 32 in order */
+__attribute__((target("avx2")))
+static inline __m256i load_lanes(const uint32_t *p)
+{
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+								 _mm_loadu_si128((const __m128i *)(p+16)), 1);
+}
+
+__attribute__((target("avx2")))
+static size_t bs_avx2(const uint32_t *in, uint8_t *out, size_t n)
+{
+  size_t nb = n/8, i;
+  for (i=0; i+32<=n; i+=32) {
+	__m256i a0 = load_lanes(in+i), a1 = load_lanes(in+i+4);
+	__m256i a2 = load_lanes(in+i+8), a3 = load_lanes(in+i+12);
+	__m256i y[4];
+	BYTE_TRANSPOSE(__m256i, a0, a1, a2, a3, y);
+	for (int k=0; k<4; k++) {
+	  for (int b=7; b>=0; b--) {
+		uint32_t m = (uint32_t)_mm256_movemask_epi8(y[k]);
+		memcpy(out + (8*k+b)*nb + i/8, &m, 4);
+		y[k] = _mm256_slli_epi16(y[k], 1);
+	  }
+	}
+  }
+  return i;
+}
+
+/*
+ * 64 values per step. For each byte position k, vpermb gathers byte k of the values into one
+ * register, 8 values per qword in reverse order; gf2p8affineqb with the identity matrix as the
+ * first operand transposes each qword as an 8x8 bit matrix (byte r = bit r of the 8 values);
+ * a last vpermb makes qword r the 64 bits of plane 8k+r.
+ */
+__attribute__((target("avx512f,avx512bw,avx512vbmi,gfni")))
+static size_t bs_avx512gfni(const uint32_t *in, uint8_t *out, size_t n)
+{
+  size_t nb = n/8, i;
+  uint8_t gather[4][64], planes[64];
+  uint64_t q[8];
+  __m512i idx[4];
+  for (int k=0; k<4; k++) {
+	for (int p=0; p<64; p++) {
+	  int e = p%32; // each half reads 32 values (two registers)
+	  gather[k][p] = (uint8_t)(4*(e/8*8 + 7 - e%8) + k);
+	}
+	idx[k] = _mm512_loadu_si512(gather[k]);
+  }
+  for (int p=0; p<64; p++)
+	planes[p] = (uint8_t)(p%8*8 + p/8);
+  const __m512i toplanes = _mm512_loadu_si512(planes);
+  const __m512i identity = _mm512_set1_epi64(0x8040201008040201LL);
+
+  for (i=0; i+64<=n; i+=64) {
+	__m512i a0 = _mm512_loadu_si512(in+i), a1 = _mm512_loadu_si512(in+i+16);
+	__m512i a2 = _mm512_loadu_si512(in+i+32), a3 = _mm512_loadu_si512(in+i+48);
+	for (int k=0; k<4; k++) {
+	  __m512i lo = _mm512_permutex2var_epi8(a0, idx[k], a1);
+	  __m512i hi = _mm512_permutex2var_epi8(a2, idx[k], a3);
+	  __m512i t = _mm512_mask_blend_epi64(0xf0, lo, hi);
+	  t = _mm512_gf2p8affine_epi64_epi8(identity, t, 0);
+	  _mm512_storeu_si512(q, _mm512_permutexvar_epi8(toplanes, t));
+	  for (int r=0; r<8; r++)
+		memcpy(out + (8*k+r)*nb + i/8, &q[r], 8);
+	}
+  }
+  return i;
+}
+
+#endif // __x86_64__
+
+void bitshuffle(int variant, const uint32_t *in, uint8_t *out, size_t n)
+{
+  size_t done = 0;
+  if (!bitshuffle_supported(variant))
+	variant = BS_NAIVE;
+  switch (variant) {
+  case BS_SCALAR: done = bs_scalar(in, out, n); break;
+#if defined(__x86_64__)
+  case BS_SSE2: done = bs_sse2(in, out, n); break;
+  case BS_AVX2: done = bs_avx2(in, out, n); break;
+  case BS_AVX512GFNI: done = bs_avx512gfni(in, out, n); break;
+#endif
+  default: break;
+  }
+  bs_naive(in, out, n, done);
+}
+
+void bitunshuffle(const uint8_t *in, uint32_t *out, size_t n)
+{
+  size_t nb = n/8, i;
+  uint32_t t[32];
+  for (i=0; i+32<=n; i+=32) {
+	for (int p=0; p<32; p++)
+	  memcpy(&t[p], in + p*nb + i/8, 4);
+	transpose32(t);
+	memcpy(out+i, t, sizeof(t));
+  }
+  for (; i<n; i++) {
+	uint32_t v = 0;
+	for (int b=0; b<32; b++)
+	  v |= (uint32_t)((in[b*nb + i/8]>>(i%8))&1) << b;
+	out[i] = v;
+  }
+}
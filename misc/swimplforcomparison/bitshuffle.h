@@ -0,0 +1,35 @@
+#ifndef __BITSHUFFLE_H_DEFINE__
+#define __BITSHUFFLE_H_DEFINE__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Blocked bit shuffle of 32-bit values, the software counterpart of BitShuffle
+ * (src/main/scala/common/BitShuffle.scala) and of common.BitShuffleUtils.
+ *
+ * A block of n values becomes 32 bit planes of n/8 bytes, plane 0 first; bit j of
+ * plane b (bit j%8 of byte j/8) is bit b of value j. For n = 16 plane b is out(b)
+ * of BitShuffle(16, 32) as a little-endian uint16_t. n must be a multiple of 8.
+ */
+
+enum {
+  BS_NAIVE,      /* bit by bit */
+  BS_SCALAR,     /* 32x32 bit-matrix transposes in registers */
+  BS_SSE2,       /* byte transpose + movemask, 16 values per step */
+  BS_AVX2,       /* byte transpose + movemask, 32 values per step */
+  BS_AVX512GFNI, /* vpermb byte gathers + gf2p8affineqb 8x8 transposes, 64 values per step */
+  BS_NVARIANTS
+};
+
+const char *bitshuffle_name(int variant);
+
+/* 1 if this CPU can run the variant */
+int bitshuffle_supported(int variant);
+
+void bitshuffle(int variant, const uint32_t *in, uint8_t *out, size_t n);
+
+/* the inverse of bitshuffle (scalar) */
+void bitunshuffle(const uint8_t *in, uint32_t *out, size_t n);
+
+#endif
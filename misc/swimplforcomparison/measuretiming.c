@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <rdtsc.h>
+#include <bitshuffle.h>
 
 volatile uint32_t dummy = 0;
 
@@ -12,39 +14,36 @@ static uint32_t int2fp(float a)
   else return ~b;
 }
 
-static void bitshuffle_16_32b(const uint32_t *in, uint16_t *out)
+#define BS_BLOCK  1024      // values per bitshuffle block
+#define BS_VALUES (1<<16)   // 256 KB of input, repeated
+
+static uint32_t bs_in[BS_VALUES], bs_back[BS_VALUES];
+static uint8_t bs_out[BS_VALUES*4], bs_ref[BS_VALUES*4];
+
+static void bitshuffle_all(int variant, uint8_t *out)
 {
-  for (int i=0; i<16; i++) {
-	for (int j=0; j<32; j++) {
-	  uint32_t mask = 1<<j;
-	  uint32_t bit = (in[i]&mask)>>j;
-	  out[i] |= bit << i;
-	}
-  }
+  for (int i=0; i<BS_VALUES; i+=BS_BLOCK)
+	bitshuffle(variant, bs_in+i, out+i*4, BS_BLOCK);
 }
 
-static double bench_bitshuffle()
+// return the average cycles per input byte; 0 if the output differs from the naive one
+static double bench_bitshuffle(int variant)
 {
   uint64_t st, et;
-  int n = 1000000;
-  uint32_t in[16];
-  uint16_t out[32];
+  int n = 100;
 
-  for (int i=0; i<16; i++) {
-	in[i] = i;
-  }
+  bitshuffle_all(variant, bs_out);
+  if (memcmp(bs_out, bs_ref, sizeof(bs_out)) != 0) return 0;
 
   st = rdtsc();
   for (int i=0; i<n; i++) {
-	bitshuffle_16_32b(in, out);
+	bitshuffle_all(variant, bs_out);
   }
   et = rdtsc() - st;
 
-  return  et/(double)n;
+  return  et/(double)n/sizeof(bs_in);
 }
 
-
-
 static double bench_intergerizedfp()
 {
   uint64_t st, et;
@@ -88,7 +87,28 @@ int main()
 {
   printf("clz:   %lf cycles/op\n", bench_clz());
   printf("ifp:   %lf cycles/op\n", bench_intergerizedfp());
-  printf("bs:    %lf cycles/op\n", bench_bitshuffle());
+
+  // small values with a few large ones, like prediction residuals
+  uint32_t x = 1;
+  for (int i=0; i<BS_VALUES; i++) {
+	x = x*1664525u + 1013904223u;
+	bs_in[i] = (x>>24) < 16 ? x : (x>>22);
+  }
+  bitshuffle_all(BS_NAIVE, bs_ref);
+  for (int i=0; i<BS_VALUES; i+=BS_BLOCK)
+	bitunshuffle(bs_ref+i*4, bs_back+i, BS_BLOCK);
+  if (memcmp(bs_in, bs_back, sizeof(bs_in)) != 0)
+	printf("bs: unshuffle MISMATCH\n");
+
+  for (int v=0; v<BS_NVARIANTS; v++) {
+	if (!bitshuffle_supported(v)) {
+	  printf("bs %-11s not supported\n", bitshuffle_name(v));
+	  continue;
+	}
+	double cpb = bench_bitshuffle(v);
+	if (cpb == 0) printf("bs %-11s MISMATCH\n", bitshuffle_name(v));
+	else printf("bs %-11s %lf cycles/byte (%lf cycles/16 values)\n", bitshuffle_name(v), cpb, cpb*64);
+  }
 
   return 0;
 }
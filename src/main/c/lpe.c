@@ -0,0 +1,688 @@
+#include <stdint.h>
+#include <string.h>
+#include "lpe.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LPE_SIMD_X86 1
+#endif
+
+/*
+ * All arithmetic is modulo 2^bw (unsigned wrap-around), so the residuals and the recovered
+ * integers match the low bits of the hardware's wider signed datapath.
+ *
+ * forward: every residual depends on the input only, so the kernels compute 8 (AVX2) or 16
+ * (AVX-512) residuals at a time from shifted loads of the input.
+ * inverse: u[t] = res[t] + pred[t] is a recurrence. For the order-k Lagrange set the predictor
+ * error is the k-th finite difference, u - pred = (1-z)^k u, so the inverse is k prefix sums.
+ * The kernels scan a register in log2(lanes) shift-and-add steps, once per order, and carry
+ * the last sum of each order into the next register. Other coefficient sets run the scalar
+ * recurrence.
+ * In float mode the loads are mapped with MapFP2UInt and the stores mapped back, in registers.
+ */
+
+static inline uint32_t map32(uint32_t v)
+{
+    return v ^ ((uint32_t) ((int32_t) v >> 31) | 0x80000000u);
+}
+
+static inline uint32_t unmap32(uint32_t v)
+{
+    return v ^ ((uint32_t) ((int32_t) ~v >> 31) | 0x80000000u);
+}
+
+static inline uint64_t map64(uint64_t v)
+{
+    return v ^ ((uint64_t) ((int64_t) v >> 63) | 0x8000000000000000ull);
+}
+
+static inline uint64_t unmap64(uint64_t v)
+{
+    return v ^ ((uint64_t) ((int64_t) ~v >> 63) | 0x8000000000000000ull);
+}
+
+/*element i of an integer (fp = 0) or float (fp = 1) array, as the integer the predictor sees*/
+static inline uint32_t load32(const void *p, size_t i, int fp)
+{
+    uint32_t v;
+    memcpy(&v, (const unsigned char *) p + 4 * i, 4);
+    return fp ? map32(v) : v;
+}
+
+static inline void store32(void *p, size_t i, uint32_t u, int fp)
+{
+    if (fp)
+        u = unmap32(u);
+    memcpy((unsigned char *) p + 4 * i, &u, 4);
+}
+
+static inline uint64_t load64(const void *p, size_t i, int fp)
+{
+    uint64_t v;
+    memcpy(&v, (const unsigned char *) p + 8 * i, 8);
+    return fp ? map64(v) : v;
+}
+
+static inline void store64(void *p, size_t i, uint64_t u, int fp)
+{
+    if (fp)
+        u = unmap64(u);
+    memcpy((unsigned char *) p + 8 * i, &u, 8);
+}
+
+static void forward32_scalar(const void *in, uint32_t *res, size_t from, size_t to, const lpe_coeffs_t *coeffs,
+                             int fp)
+{
+    size_t i;
+    int k;
+    for (i = from; i < to; i++) {
+        uint32_t r = load32(in, i, fp);
+        for (k = 0; k < coeffs->n && (size_t) k < i; k++)
+            r -= (uint32_t) coeffs->c[k] * load32(in, i - 1 - k, fp);
+        res[i] = r;
+    }
+}
+
+/*values before `from` are already in out*/
+static void inverse32_scalar(const uint32_t *res, void *out, size_t from, size_t to, const lpe_coeffs_t *coeffs,
+                             int fp)
+{
+    uint32_t hist[LPE_MAX_TAPS] = {0}; // hist[k] = u[i-1-k]
+    size_t i;
+    int k;
+    for (k = 0; k < coeffs->n && (size_t) k < from; k++)
+        hist[k] = load32(out, from - 1 - k, fp);
+    for (i = from; i < to; i++) {
+        uint32_t u = res[i];
+        for (k = 0; k < coeffs->n; k++)
+            u += (uint32_t) coeffs->c[k] * hist[k];
+        for (k = coeffs->n - 1; k > 0; k--)
+            hist[k] = hist[k - 1];
+        hist[0] = u;
+        store32(out, i, u, fp);
+    }
+}
+
+static void forward64_scalar(const void *in, uint64_t *res, size_t from, size_t to, const lpe_coeffs_t *coeffs,
+                             int fp)
+{
+    size_t i;
+    int k;
+    for (i = from; i < to; i++) {
+        uint64_t r = load64(in, i, fp);
+        for (k = 0; k < coeffs->n && (size_t) k < i; k++)
+            r -= (uint64_t) (int64_t) coeffs->c[k] * load64(in, i - 1 - k, fp);
+        res[i] = r;
+    }
+}
+
+static void inverse64_scalar(const uint64_t *res, void *out, size_t from, size_t to, const lpe_coeffs_t *coeffs,
+                             int fp)
+{
+    uint64_t hist[LPE_MAX_TAPS] = {0};
+    size_t i;
+    int k;
+    for (k = 0; k < coeffs->n && (size_t) k < from; k++)
+        hist[k] = load64(out, from - 1 - k, fp);
+    for (i = from; i < to; i++) {
+        uint64_t u = res[i];
+        for (k = 0; k < coeffs->n; k++)
+            u += (uint64_t) (int64_t) coeffs->c[k] * hist[k];
+        for (k = coeffs->n - 1; k > 0; k--)
+            hist[k] = hist[k - 1];
+        hist[0] = u;
+        store64(out, i, u, fp);
+    }
+}
+
+#ifdef LPE_SIMD_X86
+
+/*the kernels return the index up to which they have filled the output; the caller finishes with the scalar loop*/
+
+__attribute__((target("avx2")))
+static inline __m256i map32_avx2(__m256i x)
+{
+    return _mm256_xor_si256(x, _mm256_or_si256(_mm256_srai_epi32(x, 31), _mm256_set1_epi32((int) 0x80000000u)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i unmap32_avx2(__m256i x)
+{
+    __m256i notX = _mm256_xor_si256(x, _mm256_set1_epi32(-1));
+    return _mm256_xor_si256(x, _mm256_or_si256(_mm256_srai_epi32(notX, 31), _mm256_set1_epi32((int) 0x80000000u)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i sign64_avx2(__m256i x)
+{
+    return _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i map64_avx2(__m256i x)
+{
+    return _mm256_xor_si256(x, _mm256_or_si256(sign64_avx2(x),
+                                               _mm256_set1_epi64x((long long) 0x8000000000000000ull)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i unmap64_avx2(__m256i x)
+{
+    __m256i notX = _mm256_xor_si256(x, _mm256_set1_epi32(-1));
+    return _mm256_xor_si256(x, _mm256_or_si256(sign64_avx2(notX),
+                                               _mm256_set1_epi64x((long long) 0x8000000000000000ull)));
+}
+
+/*a * c modulo 2^64 from 32x32->64 products (AVX2 has no 64-bit multiply)*/
+__attribute__((target("avx2")))
+static inline __m256i mullo64_avx2(__m256i a, __m256i c)
+{
+    __m256i lo = _mm256_mul_epu32(a, c);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), c),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(c, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2")))
+static size_t forward32_avx2(const void *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    const uint32_t *u = (const uint32_t *) in;
+    __m256i c[LPE_MAX_TAPS];
+    size_t i;
+    int k;
+    for (k = 0; k < coeffs->n; k++)
+        c[k] = _mm256_set1_epi32(coeffs->c[k]);
+    for (i = coeffs->n; i + 8 <= n; i += 8) {
+        __m256i r = _mm256_loadu_si256((const __m256i *) (u + i));
+        if (fp)
+            r = map32_avx2(r);
+        for (k = 0; k < coeffs->n; k++) {
+            __m256i prev = _mm256_loadu_si256((const __m256i *) (u + i - 1 - k));
+            if (fp)
+                prev = map32_avx2(prev);
+            r = _mm256_sub_epi32(r, _mm256_mullo_epi32(prev, c[k]));
+        }
+        _mm256_storeu_si256((__m256i *) (res + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t forward64_avx2(const void *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    const uint64_t *u = (const uint64_t *) in;
+    __m256i c[LPE_MAX_TAPS];
+    size_t i;
+    int k;
+    for (k = 0; k < coeffs->n; k++)
+        c[k] = _mm256_set1_epi64x(coeffs->c[k]);
+    for (i = coeffs->n; i + 4 <= n; i += 4) {
+        __m256i r = _mm256_loadu_si256((const __m256i *) (u + i));
+        if (fp)
+            r = map64_avx2(r);
+        for (k = 0; k < coeffs->n; k++) {
+            __m256i prev = _mm256_loadu_si256((const __m256i *) (u + i - 1 - k));
+            if (fp)
+                prev = map64_avx2(prev);
+            r = _mm256_sub_epi64(r, mullo64_avx2(prev, c[k]));
+        }
+        _mm256_storeu_si256((__m256i *) (res + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t inverse32_avx2(const uint32_t *res, void *out, size_t n, int order, int fp)
+{
+    const __m256i shift1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i shift2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+    const __m256i shift4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+    const __m256i last = _mm256_set1_epi32(7);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry[LPE_MAX_TAPS];
+    uint32_t *u = (uint32_t *) out;
+    size_t i;
+    int j;
+    for (j = 0; j < order; j++)
+        carry[j] = zero;
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (res + i));
+        for (j = 0; j < order; j++) {
+            x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift1), zero, 0x01));
+            x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift2), zero, 0x03));
+            x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift4), zero, 0x0f));
+            x = _mm256_add_epi32(x, carry[j]);
+            carry[j] = _mm256_permutevar8x32_epi32(x, last);
+        }
+        if (fp)
+            x = unmap32_avx2(x);
+        _mm256_storeu_si256((__m256i *) (u + i), x);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t inverse64_avx2(const uint64_t *res, void *out, size_t n, int order, int fp)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry[LPE_MAX_TAPS];
+    uint64_t *u = (uint64_t *) out;
+    size_t i;
+    int j;
+    for (j = 0; j < order; j++)
+        carry[j] = zero;
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (res + i));
+        for (j = 0; j < order; j++) {
+            x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)),
+                                                       zero, 0x03));
+            x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)),
+                                                       zero, 0x0f));
+            x = _mm256_add_epi64(x, carry[j]);
+            carry[j] = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        if (fp)
+            x = unmap64_avx2(x);
+        _mm256_storeu_si256((__m256i *) (u + i), x);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i map32_avx512(__m512i x)
+{
+    return _mm512_xor_si512(x, _mm512_or_si512(_mm512_srai_epi32(x, 31), _mm512_set1_epi32((int) 0x80000000u)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i unmap32_avx512(__m512i x)
+{
+    __m512i notX = _mm512_xor_si512(x, _mm512_set1_epi32(-1));
+    return _mm512_xor_si512(x, _mm512_or_si512(_mm512_srai_epi32(notX, 31), _mm512_set1_epi32((int) 0x80000000u)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i map64_avx512(__m512i x)
+{
+    return _mm512_xor_si512(x, _mm512_or_si512(_mm512_srai_epi64(x, 63),
+                                               _mm512_set1_epi64((long long) 0x8000000000000000ull)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i unmap64_avx512(__m512i x)
+{
+    __m512i notX = _mm512_xor_si512(x, _mm512_set1_epi32(-1));
+    return _mm512_xor_si512(x, _mm512_or_si512(_mm512_srai_epi64(notX, 63),
+                                               _mm512_set1_epi64((long long) 0x8000000000000000ull)));
+}
+
+__attribute__((target("avx512f")))
+static size_t forward32_avx512(const void *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    const uint32_t *u = (const uint32_t *) in;
+    __m512i c[LPE_MAX_TAPS];
+    size_t i;
+    int k;
+    for (k = 0; k < coeffs->n; k++)
+        c[k] = _mm512_set1_epi32(coeffs->c[k]);
+    for (i = coeffs->n; i + 16 <= n; i += 16) {
+        __m512i r = _mm512_loadu_si512((const void *) (u + i));
+        if (fp)
+            r = map32_avx512(r);
+        for (k = 0; k < coeffs->n; k++) {
+            __m512i prev = _mm512_loadu_si512((const void *) (u + i - 1 - k));
+            if (fp)
+                prev = map32_avx512(prev);
+            r = _mm512_sub_epi32(r, _mm512_mullo_epi32(prev, c[k]));
+        }
+        _mm512_storeu_si512((void *) (res + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t forward64_avx512(const void *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    const uint64_t *u = (const uint64_t *) in;
+    __m512i c[LPE_MAX_TAPS];
+    size_t i;
+    int k;
+    for (k = 0; k < coeffs->n; k++)
+        c[k] = _mm512_set1_epi64(coeffs->c[k]);
+    for (i = coeffs->n; i + 8 <= n; i += 8) {
+        __m512i r = _mm512_loadu_si512((const void *) (u + i));
+        if (fp)
+            r = map64_avx512(r);
+        for (k = 0; k < coeffs->n; k++) {
+            __m512i prev = _mm512_loadu_si512((const void *) (u + i - 1 - k));
+            if (fp)
+                prev = map64_avx512(prev);
+            r = _mm512_sub_epi64(r, _mm512_mullox_epi64(prev, c[k]));
+        }
+        _mm512_storeu_si512((void *) (res + i), r);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t inverse32_avx512(const uint32_t *res, void *out, size_t n, int order, int fp)
+{
+    const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i last = _mm512_set1_epi32(15);
+    __m512i shift[4], carry[LPE_MAX_TAPS];
+    __mmask16 keep[4];
+    uint32_t *u = (uint32_t *) out;
+    size_t i;
+    int j, s;
+    for (s = 0; s < 4; s++) {
+        shift[s] = _mm512_sub_epi32(lane, _mm512_set1_epi32(1 << s)); // lane l takes lane l - 2^s
+        keep[s] = (__mmask16) (0xffffu << (1 << s));
+    }
+    for (j = 0; j < order; j++)
+        carry[j] = _mm512_setzero_si512();
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512((const void *) (res + i));
+        for (j = 0; j < order; j++) {
+            for (s = 0; s < 4; s++)
+                x = _mm512_add_epi32(x, _mm512_maskz_permutexvar_epi32(keep[s], shift[s], x));
+            x = _mm512_add_epi32(x, carry[j]);
+            carry[j] = _mm512_permutexvar_epi32(last, x);
+        }
+        if (fp)
+            x = unmap32_avx512(x);
+        _mm512_storeu_si512((void *) (u + i), x);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t inverse64_avx512(const uint64_t *res, void *out, size_t n, int order, int fp)
+{
+    const __m512i lane = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512i last = _mm512_set1_epi64(7);
+    __m512i shift[3], carry[LPE_MAX_TAPS];
+    __mmask8 keep[3];
+    uint64_t *u = (uint64_t *) out;
+    size_t i;
+    int j, s;
+    for (s = 0; s < 3; s++) {
+        shift[s] = _mm512_sub_epi64(lane, _mm512_set1_epi64(1 << s));
+        keep[s] = (__mmask8) (0xffu << (1 << s));
+    }
+    for (j = 0; j < order; j++)
+        carry[j] = _mm512_setzero_si512();
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512((const void *) (res + i));
+        for (j = 0; j < order; j++) {
+            for (s = 0; s < 3; s++)
+                x = _mm512_add_epi64(x, _mm512_maskz_permutexvar_epi64(keep[s], shift[s], x));
+            x = _mm512_add_epi64(x, carry[j]);
+            carry[j] = _mm512_permutexvar_epi64(last, x);
+        }
+        if (fp)
+            x = unmap64_avx512(x);
+        _mm512_storeu_si512((void *) (u + i), x);
+    }
+    return i;
+}
+
+#endif // LPE_SIMD_X86
+
+static int detectedLevel = LPE_SIMD_NONE;
+static int activeLevel = LPE_SIMD_NONE;
+
+__attribute__((constructor))
+static void lpe_simd_init(void)
+{
+#ifdef LPE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        detectedLevel = LPE_SIMD_AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        detectedLevel = LPE_SIMD_AVX2;
+#endif
+    activeLevel = detectedLevel;
+}
+
+int lpe_simd_detect(void)
+{
+    return detectedLevel;
+}
+
+int lpe_simd_level(void)
+{
+    return activeLevel;
+}
+
+void lpe_set_simd_level(int level)
+{
+    activeLevel = level < detectedLevel ? level : detectedLevel;
+}
+
+const char *lpe_simd_name(int level)
+{
+    switch (level) {
+    case LPE_SIMD_AVX2:   return "avx2";
+    case LPE_SIMD_AVX512: return "avx512";
+    default:              return "scalar";
+    }
+}
+
+static void forward32(const void *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    size_t head = (size_t) coeffs->n < n ? (size_t) coeffs->n : n; // the first values have less history
+    size_t done = head;
+#ifdef LPE_SIMD_X86
+    if (activeLevel == LPE_SIMD_AVX512)
+        done = forward32_avx512(in, res, n, coeffs, fp);
+    else if (activeLevel == LPE_SIMD_AVX2)
+        done = forward32_avx2(in, res, n, coeffs, fp);
+#endif
+    forward32_scalar(in, res, 0, head, coeffs, fp);
+    forward32_scalar(in, res, done, n, coeffs, fp);
+}
+
+static void inverse32(const uint32_t *res, void *out, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    size_t done = 0;
+#ifdef LPE_SIMD_X86
+    if (coeffs->order > 0 && activeLevel == LPE_SIMD_AVX512)
+        done = inverse32_avx512(res, out, n, coeffs->order, fp);
+    else if (coeffs->order > 0 && activeLevel == LPE_SIMD_AVX2)
+        done = inverse32_avx2(res, out, n, coeffs->order, fp);
+#endif
+    inverse32_scalar(res, out, done, n, coeffs, fp);
+}
+
+static void forward64(const void *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    size_t head = (size_t) coeffs->n < n ? (size_t) coeffs->n : n; // the first values have less history
+    size_t done = head;
+#ifdef LPE_SIMD_X86
+    if (activeLevel == LPE_SIMD_AVX512)
+        done = forward64_avx512(in, res, n, coeffs, fp);
+    else if (activeLevel == LPE_SIMD_AVX2)
+        done = forward64_avx2(in, res, n, coeffs, fp);
+#endif
+    forward64_scalar(in, res, 0, head, coeffs, fp);
+    forward64_scalar(in, res, done, n, coeffs, fp);
+}
+
+static void inverse64(const uint64_t *res, void *out, size_t n, const lpe_coeffs_t *coeffs, int fp)
+{
+    size_t done = 0;
+#ifdef LPE_SIMD_X86
+    if (coeffs->order > 0 && activeLevel == LPE_SIMD_AVX512)
+        done = inverse64_avx512(res, out, n, coeffs->order, fp);
+    else if (coeffs->order > 0 && activeLevel == LPE_SIMD_AVX2)
+        done = inverse64_avx2(res, out, n, coeffs->order, fp);
+#endif
+    inverse64_scalar(res, out, done, n, coeffs, fp);
+}
+
+static int64_t binomial(int n, int k)
+{
+    int64_t b = 1;
+    int i;
+    for (i = 1; i <= k; i++)
+        b = b * (n - k + i) / i;
+    return b;
+}
+
+int lpe_coeffs_init(lpe_coeffs_t *coeffs, const int32_t *c, int n)
+{
+    int k;
+    if (n < 1 || n > LPE_MAX_TAPS)
+        return LPE_EINVAL;
+    for (k = 0; k < n; k++)
+        if (c[k] <= -LPE_MAX_COEFF || c[k] >= LPE_MAX_COEFF)
+            return LPE_EINVAL;
+    memset(coeffs, 0, sizeof(*coeffs));
+    coeffs->n = n;
+    memcpy(coeffs->c, c, n * sizeof(int32_t));
+    //(1-z)^n = 1 - sum_k c[k] z^(k+1) with c[k] = (-1)^k C(n, k+1)
+    coeffs->order = n;
+    for (k = 0; k < n; k++)
+        if (c[k] != (k % 2 == 0 ? 1 : -1) * binomial(n, k + 1))
+            coeffs->order = 0;
+    return LPE_OK;
+}
+
+int lpe_lagrange_coeffs(lpe_coeffs_t *coeffs, int order)
+{
+    int32_t c[LPE_MAX_TAPS];
+    int k;
+    if (order < 1 || order > LPE_MAX_TAPS)
+        return LPE_EINVAL;
+    for (k = 0; k < order; k++)
+        c[k] = (int32_t) ((k % 2 == 0 ? 1 : -1) * binomial(order, k + 1));
+    return lpe_coeffs_init(coeffs, c, order);
+}
+
+int lpe_out_uint_bits(int bw, const lpe_coeffs_t *coeffs)
+{
+    int k, extra = 0;
+    for (k = 0; k < coeffs->n; k++) {
+        uint32_t v = (uint32_t) (coeffs->c[k] < 0 ? -coeffs->c[k] : coeffs->c[k]);
+        int nbits = 0;
+        while (v >> nbits)
+            nbits++;
+        if (nbits > extra)
+            extra = nbits;
+    }
+    return bw + extra;
+}
+
+int lpe_out_sint_bits(int bw, const lpe_coeffs_t *coeffs)
+{
+    return lpe_out_uint_bits(bw, coeffs) + 1;
+}
+
+void lpe_fp2uint32(const float *in, uint32_t *out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = load32(in, i, 1);
+}
+
+void lpe_uint2fp32(const uint32_t *in, float *out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        store32(out, i, in[i], 1);
+}
+
+void lpe_fp2uint64(const double *in, uint64_t *out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        out[i] = load64(in, i, 1);
+}
+
+void lpe_uint2fp64(const uint64_t *in, double *out, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        store64(out, i, in[i], 1);
+}
+
+void lpe_forward32(const uint32_t *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs)
+{
+    forward32(in, res, n, coeffs, 0);
+}
+
+void lpe_inverse32(const uint32_t *res, uint32_t *out, size_t n, const lpe_coeffs_t *coeffs)
+{
+    inverse32(res, out, n, coeffs, 0);
+}
+
+void lpe_forward64(const uint64_t *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs)
+{
+    forward64(in, res, n, coeffs, 0);
+}
+
+void lpe_inverse64(const uint64_t *res, uint64_t *out, size_t n, const lpe_coeffs_t *coeffs)
+{
+    inverse64(res, out, n, coeffs, 0);
+}
+
+void lpe_encode_float(const float *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs)
+{
+    forward32(in, res, n, coeffs, 1);
+}
+
+void lpe_decode_float(const uint32_t *res, float *out, size_t n, const lpe_coeffs_t *coeffs)
+{
+    inverse32(res, out, n, coeffs, 1);
+}
+
+void lpe_encode_double(const double *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs)
+{
+    forward64(in, res, n, coeffs, 1);
+}
+
+void lpe_decode_double(const uint64_t *res, double *out, size_t n, const lpe_coeffs_t *coeffs)
+{
+    inverse64(res, out, n, coeffs, 1);
+}
+
+/*
+ * LagrangePred keeps the sum of products in its outSIntBits-wide output, and LPEncoder the
+ * difference in the same width; out_data is the low outUIntBits bits of |diff|.
+ */
+void lpe_encode_hw32(const uint32_t *in, uint8_t *sign, uint64_t *data, size_t n, const lpe_coeffs_t *coeffs)
+{
+    int sbits = lpe_out_sint_bits(32, coeffs);
+    uint64_t smask = (1ull << sbits) - 1, umask = smask >> 1;
+    size_t i;
+    int k;
+    for (i = 0; i < n; i++) {
+        int64_t pred = 0;
+        for (k = 0; k < coeffs->n && (size_t) k < i; k++)
+            pred += (int64_t) coeffs->c[k] * in[i - 1 - k];
+        uint64_t bits = ((uint64_t) in[i] - (uint64_t) pred) & smask; // both truncations, as bits
+        int negative = (int) (bits >> (sbits - 1));
+        sign[i] = (uint8_t) negative;
+        data[i] = (negative ? (uint64_t) 0 - bits : bits) & umask;
+    }
+}
+
+#ifdef __SIZEOF_INT128__
+void lpe_encode_hw64(const uint64_t *in, uint8_t *sign, unsigned __int128 *data, size_t n,
+                     const lpe_coeffs_t *coeffs)
+{
+    int sbits = lpe_out_sint_bits(64, coeffs);
+    unsigned __int128 smask = ((unsigned __int128) 1 << sbits) - 1, umask = smask >> 1;
+    size_t i;
+    int k;
+    for (i = 0; i < n; i++) {
+        __int128 pred = 0;
+        for (k = 0; k < coeffs->n && (size_t) k < i; k++)
+            pred += (__int128) coeffs->c[k] * in[i - 1 - k];
+        unsigned __int128 bits = ((unsigned __int128) in[i] - (unsigned __int128) pred) & smask;
+        int negative = (int) (bits >> (sbits - 1));
+        sign[i] = (uint8_t) negative;
+        data[i] = (negative ? (unsigned __int128) 0 - bits : bits) & umask;
+    }
+}
+#endif
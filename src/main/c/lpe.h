@@ -0,0 +1,85 @@
+#ifndef LPE_H
+#define LPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Software Lagrange predictive encoder (LPE), the host counterpart of MapFP2UInt, LagrangePred,
+ * LPEncoder and LPDecoder (src/main/scala/common/IntegerizeFP.scala, src/main/scala/lpe).
+ *
+ * A value u[t] (the MapFP2UInt-integerized float bits in float mode) is predicted from the
+ * previous ones, pred[t] = c[0]*u[t-1] + c[1]*u[t-2] + ..., with zeros before the first value
+ * as after the predictor's reset. The codec stores the residual u[t] - pred[t] modulo 2^bw:
+ * these are the low bw bits of LPEncoder's difference, and, as in LPDecoder (which keeps
+ * tmp(bw-1,0)), they are enough to recover u exactly.
+ * lpe_encode_hw32/64 produce LPEncoder's full (out_sign, out_data) pair to validate hardware.
+ */
+
+#define LPE_OK      0
+#define LPE_EINVAL -1
+
+#define LPE_MAX_TAPS  8
+#define LPE_MAX_COEFF (1 << 15) // |c| limit, keeps the exact 32-bit reference within int64
+
+#define LPE_SIMD_NONE   0
+#define LPE_SIMD_AVX2   1
+#define LPE_SIMD_AVX512 2
+
+typedef struct {
+    int n;                  // number of taps
+    int32_t c[LPE_MAX_TAPS];// c[k] weights u[t-1-k]
+    int order;              // k when c is the order-k Lagrange set (binomial, (1-z)^k), else 0
+} lpe_coeffs_t;
+
+// Checks and copies n coefficients; LPE_EINVAL if n or a coefficient is out of range
+int lpe_coeffs_init(lpe_coeffs_t *coeffs, const int32_t *c, int n);
+// Order-k Lagrange coefficients: 1: (1), 2: (2,-1), 3: (3,-3,1), 4: (4,-6,4,-1) (the hardware default), ...
+int lpe_lagrange_coeffs(lpe_coeffs_t *coeffs, int order);
+// LagrangePredUtil.outUIntBits / outSIntBits: widths of LPEncoder's out_data and of its difference
+int lpe_out_uint_bits(int bw, const lpe_coeffs_t *coeffs);
+int lpe_out_sint_bits(int bw, const lpe_coeffs_t *coeffs);
+
+// Highest kernel level supported by the running CPU, the level in use, and a way to cap it
+int lpe_simd_detect(void);
+int lpe_simd_level(void);
+void lpe_set_simd_level(int level);
+const char *lpe_simd_name(int level);
+
+// MapFP2UInt: rev = 0 maps float bits to order-preserving unsigned integers, rev = 1 maps them back
+void lpe_fp2uint32(const float *in, uint32_t *out, size_t n);
+void lpe_uint2fp32(const uint32_t *in, float *out, size_t n);
+void lpe_fp2uint64(const double *in, uint64_t *out, size_t n);
+void lpe_uint2fp64(const uint64_t *in, double *out, size_t n);
+
+// Residuals of n unsigned integers (forward) and the integers back from them (inverse).
+// The inverse of an order-k Lagrange set runs as k fused prefix sums, which vectorize; other sets
+// use the scalar recurrence. in and out must not overlap.
+void lpe_forward32(const uint32_t *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs);
+void lpe_inverse32(const uint32_t *res, uint32_t *out, size_t n, const lpe_coeffs_t *coeffs);
+void lpe_forward64(const uint64_t *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs);
+void lpe_inverse64(const uint64_t *res, uint64_t *out, size_t n, const lpe_coeffs_t *coeffs);
+
+// Float codec (LPEncoder/LPDecoder with fpmode = true): MapFP2UInt fused with the forward/inverse pass
+void lpe_encode_float(const float *in, uint32_t *res, size_t n, const lpe_coeffs_t *coeffs);
+void lpe_decode_float(const uint32_t *res, float *out, size_t n, const lpe_coeffs_t *coeffs);
+void lpe_encode_double(const double *in, uint64_t *res, size_t n, const lpe_coeffs_t *coeffs);
+void lpe_decode_double(const uint64_t *res, double *out, size_t n, const lpe_coeffs_t *coeffs);
+
+// Scalar bit-exact model of LPEncoder(bw, fpmode = false): out_sign and the lpe_out_uint_bits-wide
+// out_data of each integer, with the hardware's truncation of the prediction and the difference
+void lpe_encode_hw32(const uint32_t *in, uint8_t *sign, uint64_t *data, size_t n, const lpe_coeffs_t *coeffs);
+#ifdef __SIZEOF_INT128__
+void lpe_encode_hw64(const uint64_t *in, uint8_t *sign, unsigned __int128 *data, size_t n,
+                     const lpe_coeffs_t *coeffs);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LPE_H
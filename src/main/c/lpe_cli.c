@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lpe.h"
+
+/*
+ * Host driver for the software LPE codec: encodes and decodes a float32 (or, with -d, float64)
+ * file, checks the round trip bit for bit and reports the throughput of each pass.
+ * The input is raw little-endian data or a .npy file ('<f4' / '<f8', C order).
+ *
+ *   lpe_cli -i data.npy [-c 4,-6,4,-1] [-o residuals.bin] [-V]
+ */
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s -i <input> [options]\n", prog);
+    printf("  -i <file>     input file (.npy or raw float32)\n");
+    printf("  -o <file>     write the residuals (bw-bit unsigned integers) to this file\n");
+    printf("  -c <list>     predictor coefficients, comma separated (default 4,-6,4,-1)\n");
+    printf("  -r <reps>     timed repetitions of each pass, the best is reported (default 5)\n");
+    printf("  -s <level>    highest SIMD kernel: scalar, avx2, avx512 (default: detected)\n");
+    printf("  -d            the raw data is float64 instead of float32\n");
+    printf("  -V            also check the kernels against the scalar loop and the LPEncoder model\n");
+}
+
+static double wtime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*the data of a .npy file (sets *useDouble from its dtype) or of a raw file; NULL on error*/
+static unsigned char *readInput(const char *path, size_t *byteLength, int *useDouble)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Error: cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long fileLength = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    long offset = 0;
+    unsigned char magic[10];
+    if (fileLength >= 10 && fread(magic, 1, 10, f) == 10 && memcmp(magic, "\x93NUMPY", 6) == 0) {
+        size_t headerLength = magic[8] | (magic[9] << 8); // version 1.0 header
+        char header[65536];
+        if (magic[6] != 1 || fread(header, 1, headerLength, f) != headerLength) {
+            printf("Error: unsupported .npy header in %s\n", path);
+            fclose(f);
+            return NULL;
+        }
+        header[headerLength] = '\0';
+        if (strstr(header, "'fortran_order': True") != NULL
+            || (strstr(header, "'<f4'") == NULL && strstr(header, "'<f8'") == NULL)) {
+            printf("Error: %s is not a C-order float32/float64 array\n", path);
+            fclose(f);
+            return NULL;
+        }
+        *useDouble = strstr(header, "'<f8'") != NULL;
+        offset = 10 + (long) headerLength;
+    }
+
+    *byteLength = (size_t) (fileLength - offset);
+    unsigned char *bytes = malloc(*byteLength > 0 ? *byteLength : 1);
+    fseek(f, offset, SEEK_SET);
+    if (bytes == NULL || fread(bytes, 1, *byteLength, f) != *byteLength) {
+        printf("Error: cannot read %s\n", path);
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(f);
+    return bytes;
+}
+
+static int parseCoeffs(const char *list, lpe_coeffs_t *coeffs)
+{
+    int32_t c[LPE_MAX_TAPS];
+    int n = 0;
+    char *end;
+    while (*list != '\0' && n < LPE_MAX_TAPS) {
+        c[n++] = (int32_t) strtol(list, &end, 10);
+        if (end == list)
+            return LPE_EINVAL;
+        list = *end == ',' ? end + 1 : end;
+    }
+    return *list == '\0' ? lpe_coeffs_init(coeffs, c, n) : LPE_EINVAL;
+}
+
+/*average number of significant bits of the residuals as signed values (zigzag), a hint of the entropy-coded size*/
+static double meanResidualBits(const void *res, size_t nbEle, int useDouble)
+{
+    double total = 0;
+    size_t i;
+    for (i = 0; i < nbEle; i++) {
+        uint64_t z;
+        if (useDouble) {
+            uint64_t r = ((const uint64_t *) res)[i];
+            z = (r << 1) ^ (uint64_t) ((int64_t) r >> 63);
+        } else {
+            uint32_t r = ((const uint32_t *) res)[i];
+            z = (uint32_t) ((r << 1) ^ (uint32_t) ((int32_t) r >> 31));
+        }
+        total += z == 0 ? 0 : 64 - __builtin_clzll(z);
+    }
+    return nbEle > 0 ? total / nbEle : 0;
+}
+
+/*kernels against the scalar loop, and the residuals against the low bits of the LPEncoder model*/
+static int verify(const void *data, const void *res, size_t nbEle, int useDouble, const lpe_coeffs_t *coeffs)
+{
+    size_t valueBytes = useDouble ? 8 : 4, i, mismatch = nbEle;
+    void *ref = malloc(nbEle * valueBytes + 1), *ints = malloc(nbEle * valueBytes + 1);
+    uint8_t *sign = malloc(nbEle + 1);
+    void *hw = malloc(nbEle * (useDouble ? 16 : 8) + 1);
+    int level = lpe_simd_level(), ok = 1;
+
+    lpe_set_simd_level(LPE_SIMD_NONE);
+    if (useDouble)
+        lpe_encode_double((const double *) data, (uint64_t *) ref, nbEle, coeffs);
+    else
+        lpe_encode_float((const float *) data, (uint32_t *) ref, nbEle, coeffs);
+    lpe_set_simd_level(level);
+    for (i = 0; i < nbEle && mismatch == nbEle; i++)
+        if (memcmp((const char *) ref + i * valueBytes, (const char *) res + i * valueBytes, valueBytes) != 0)
+            mismatch = i;
+    printf("kernels vs scalar   = %s", mismatch == nbEle ? "match\n" : "MISMATCH");
+    if (mismatch != nbEle) {
+        printf(" at value %zu\n", mismatch);
+        ok = 0;
+    }
+
+    mismatch = nbEle;
+    if (useDouble) {
+#ifdef __SIZEOF_INT128__
+        lpe_fp2uint64((const double *) data, (uint64_t *) ints, nbEle);
+        lpe_encode_hw64((const uint64_t *) ints, sign, (unsigned __int128 *) hw, nbEle, coeffs);
+        for (i = 0; i < nbEle && mismatch == nbEle; i++) {
+            unsigned __int128 d = ((unsigned __int128 *) hw)[i];
+            if ((uint64_t) (sign[i] ? 0 - d : d) != ((const uint64_t *) res)[i])
+                mismatch = i;
+        }
+#endif
+    } else {
+        lpe_fp2uint32((const float *) data, (uint32_t *) ints, nbEle);
+        lpe_encode_hw32((const uint32_t *) ints, sign, (uint64_t *) hw, nbEle, coeffs);
+        for (i = 0; i < nbEle && mismatch == nbEle; i++) {
+            uint64_t d = ((uint64_t *) hw)[i];
+            if ((uint32_t) (sign[i] ? 0 - d : d) != ((const uint32_t *) res)[i])
+                mismatch = i;
+        }
+    }
+    printf("LPEncoder model     = %s", mismatch == nbEle ? "match\n" : "MISMATCH");
+    if (mismatch != nbEle) {
+        printf(" at value %zu\n", mismatch);
+        ok = 0;
+    }
+
+    free(ref);
+    free(ints);
+    free(sign);
+    free(hw);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    char *inPath = NULL, *outPath = NULL;
+    const char *coeffList = "4,-6,4,-1";
+    int useDouble = 0, reps = 5, doVerify = 0, simdLevel = lpe_simd_detect();
+    int opt, r;
+    lpe_coeffs_t coeffs;
+
+    while ((opt = getopt(argc, argv, "i:o:c:r:s:dVh")) != -1) {
+        switch (opt) {
+        case 'i': inPath = optarg; break;
+        case 'o': outPath = optarg; break;
+        case 'c': coeffList = optarg; break;
+        case 'r': reps = atoi(optarg); break;
+        case 's':
+            for (simdLevel = LPE_SIMD_AVX512; simdLevel > LPE_SIMD_NONE; simdLevel--)
+                if (strcmp(optarg, lpe_simd_name(simdLevel)) == 0)
+                    break;
+            break;
+        case 'd': useDouble = 1; break;
+        case 'V': doVerify = 1; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (inPath == NULL || reps <= 0 || parseCoeffs(coeffList, &coeffs) != LPE_OK) {
+        usage(argv[0]);
+        return 1;
+    }
+    lpe_set_simd_level(simdLevel);
+
+    size_t byteLength = 0;
+    unsigned char *data = readInput(inPath, &byteLength, &useDouble);
+    if (data == NULL)
+        return 1;
+    size_t valueBytes = useDouble ? 8 : 4, nbEle = byteLength / valueBytes;
+    void *res = malloc(nbEle * valueBytes + 1), *dec = malloc(nbEle * valueBytes + 1);
+    if (res == NULL || dec == NULL) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+
+    double encodeTime = 0, decodeTime = 0, t;
+    for (r = 0; r < reps; r++) {
+        t = wtime();
+        if (useDouble)
+            lpe_encode_double((const double *) data, (uint64_t *) res, nbEle, &coeffs);
+        else
+            lpe_encode_float((const float *) data, (uint32_t *) res, nbEle, &coeffs);
+        t = wtime() - t;
+        if (r == 0 || t < encodeTime)
+            encodeTime = t;
+
+        t = wtime();
+        if (useDouble)
+            lpe_decode_double((const uint64_t *) res, (double *) dec, nbEle, &coeffs);
+        else
+            lpe_decode_float((const uint32_t *) res, (float *) dec, nbEle, &coeffs);
+        t = wtime() - t;
+        if (r == 0 || t < decodeTime)
+            decodeTime = t;
+    }
+
+    printf("LPE round trip: %s, %zu %s values, %d-tap predictor (", inPath, nbEle, useDouble ? "float64" : "float32",
+           coeffs.n);
+    for (r = 0; r < coeffs.n; r++)
+        printf(r == 0 ? "%d" : ",%d", coeffs.c[r]);
+    printf("), %s kernels\n", lpe_simd_name(lpe_simd_level()));
+    printf("encode     %10.6f s  %8.3f GB/s\n", encodeTime, encodeTime > 0 ? byteLength / encodeTime / 1e9 : 0.0);
+    printf("decode     %10.6f s  %8.3f GB/s%s\n", decodeTime, decodeTime > 0 ? byteLength / decodeTime / 1e9 : 0.0,
+           coeffs.order > 0 ? "" : "  (scalar recurrence)");
+    printf("residual bits/value = %.3f of %d (hardware out_data: %d bits + sign)\n",
+           meanResidualBits(res, nbEle, useDouble), useDouble ? 64 : 32,
+           lpe_out_uint_bits(useDouble ? 64 : 32, &coeffs));
+    int ok = memcmp(data, dec, nbEle * valueBytes) == 0;
+    printf("round trip          = %s\n", ok ? "exact" : "MISMATCH");
+    if (doVerify)
+        ok = verify(data, res, nbEle, useDouble, &coeffs) && ok;
+
+    if (outPath != NULL) {
+        FILE *f = fopen(outPath, "wb");
+        if (f == NULL || fwrite(res, valueBytes, nbEle, f) != nbEle) {
+            printf("Error: cannot write %s\n", outPath);
+            ok = 0;
+        }
+        if (f != NULL)
+            fclose(f);
+    }
+
+    free(data);
+    free(res);
+    free(dec);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lpe.h"
+
+/*
+ * Host regression tests of the software LPE codec, run by ctest at every SIMD level the CPU has.
+ * The expected values are those of the Scala models: the inputs of LagrangePredTestPatterns and
+ * LagrangePredSpecUtil.main through performLagrangeForward, and IntegerizeFPSpec's fixed floats
+ * through ifp32Forward (LPECompEstimateCR). Each vector also runs at an odd offset after a run of
+ * zeros, which leaves its residuals unchanged and takes it through the vector kernels.
+ */
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);         \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+            failures++;                                         \
+        }                                                       \
+    } while (0)
+
+#define LEAD 61 // zeros ahead of the shifted copy of a vector
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+typedef struct {
+    const char *name;
+    const uint32_t *in;
+    const int64_t *diff; // performLagrangeForward with (4,-6,4,-1): in[t] - pred[t]
+    size_t n;
+} vector_t;
+
+// LagrangePredTestPatterns.inputs_fixed_int, inputs_max_int (bw = 32) and inputs_lin_int without the padding
+static const uint32_t fixedIn[] = {512, 532, 513, 514, 513, 512, 509, 508, 507, 505, 500, 504, 512, 511, 510};
+static const int64_t fixedDiff[] = {512, -1516, 1457, -394, -81, 24, -4, 6, -6, 1, -1, 14, -17, -8, 22};
+static const uint32_t maxIn[] = {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu,
+                                 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu};
+static const int64_t maxDiff[] = {4294967295ll, -12884901885ll, 12884901885ll, -4294967295ll, 0, 0, 0, 0};
+static const uint32_t linIn[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+static const int64_t linDiff[] = {0, 1, -2, 1, 0, 0, 0, 0, 0, 0};
+// LagrangePredSpecUtil.main
+static const uint32_t mainIn[] = {10, 20, 30, 40, 0, 0, 0, 0, 0, 0, 0, 0};
+static const int64_t mainDiff[] = {10, -20, 10, 0, -50, 140, -130, 40, 0, 0, 0, 0};
+
+static const vector_t vectors[] = {
+    {"fixed int", fixedIn, fixedDiff, COUNT(fixedIn)},
+    {"max int", maxIn, maxDiff, COUNT(maxIn)},
+    {"linear int", linIn, linDiff, COUNT(linIn)},
+    {"main", mainIn, mainDiff, COUNT(mainIn)},
+};
+
+/*residuals (the low bw bits of the difference) and the inverse of n integers at the offset lead*/
+static void checkForward32(const vector_t *v, size_t lead, const lpe_coeffs_t *coeffs)
+{
+    size_t n = lead + v->n, i;
+    uint32_t *in = (uint32_t *) calloc(n, sizeof(uint32_t));
+    uint32_t *res = (uint32_t *) malloc(n * sizeof(uint32_t));
+    uint32_t *out = (uint32_t *) malloc(n * sizeof(uint32_t));
+    memcpy(in + lead, v->in, v->n * sizeof(uint32_t));
+    lpe_forward32(in, res, n, coeffs);
+    for (i = 0; i < n; i++) {
+        uint32_t expected = i < lead ? 0 : (uint32_t) (uint64_t) v->diff[i - lead];
+        CHECK(res[i] == expected, "%s (%s, lead %zu): residual %zu is 0x%08x, expected 0x%08x",
+              v->name, lpe_simd_name(lpe_simd_level()), lead, i, res[i], expected);
+    }
+    lpe_inverse32(res, out, n, coeffs);
+    CHECK(memcmp(out, in, n * sizeof(uint32_t)) == 0, "%s (%s, lead %zu): inverse32 differs from the input",
+          v->name, lpe_simd_name(lpe_simd_level()), lead);
+    free(out);
+    free(res);
+    free(in);
+}
+
+static void checkForward64(const vector_t *v, size_t lead, const lpe_coeffs_t *coeffs)
+{
+    size_t n = lead + v->n, i;
+    uint64_t *in = (uint64_t *) calloc(n, sizeof(uint64_t));
+    uint64_t *res = (uint64_t *) malloc(n * sizeof(uint64_t));
+    uint64_t *out = (uint64_t *) malloc(n * sizeof(uint64_t));
+    for (i = 0; i < v->n; i++)
+        in[lead + i] = v->in[i];
+    lpe_forward64(in, res, n, coeffs);
+    for (i = 0; i < n; i++) {
+        uint64_t expected = i < lead ? 0 : (uint64_t) v->diff[i - lead];
+        CHECK(res[i] == expected, "%s (%s, lead %zu): residual64 %zu is 0x%016llx, expected 0x%016llx",
+              v->name, lpe_simd_name(lpe_simd_level()), lead, i, (unsigned long long) res[i],
+              (unsigned long long) expected);
+    }
+    lpe_inverse64(res, out, n, coeffs);
+    CHECK(memcmp(out, in, n * sizeof(uint64_t)) == 0, "%s (%s, lead %zu): inverse64 differs from the input",
+          v->name, lpe_simd_name(lpe_simd_level()), lead);
+    free(out);
+    free(res);
+    free(in);
+}
+
+/*LPEncoder(32, fpmode = false): out_sign and out_data = |in - pred|, as LPEncoderSpec expects them*/
+static void checkEncodeHw32(const vector_t *v, const lpe_coeffs_t *coeffs)
+{
+    uint8_t sign[16];
+    uint64_t data[16];
+    size_t i;
+    lpe_encode_hw32(v->in, sign, data, v->n, coeffs);
+    for (i = 0; i < v->n; i++) {
+        int64_t d = v->diff[i];
+        CHECK(sign[i] == (d < 0) && data[i] == (uint64_t) (d < 0 ? -d : d),
+              "%s: LPEncoder %zu is (%d, %llu), expected (%d, %lld)", v->name, i, sign[i],
+              (unsigned long long) data[i], d < 0, (long long) (d < 0 ? -d : d));
+    }
+}
+
+static void testLagrangeVectors(void)
+{
+    lpe_coeffs_t coeffs;
+    size_t i;
+    CHECK(lpe_lagrange_coeffs(&coeffs, 4) == LPE_OK && coeffs.n == 4 && coeffs.c[0] == 4 && coeffs.c[1] == -6
+          && coeffs.c[2] == 4 && coeffs.c[3] == -1, "order 4 is not the (4,-6,4,-1) set");
+    CHECK(lpe_out_uint_bits(32, &coeffs) == 35 && lpe_out_sint_bits(32, &coeffs) == 36,
+          "LPEncoder widths %d/%d, expected 35/36", lpe_out_uint_bits(32, &coeffs), lpe_out_sint_bits(32, &coeffs));
+
+    for (i = 0; i < COUNT(vectors); i++) {
+        checkForward32(&vectors[i], 0, &coeffs);
+        checkForward32(&vectors[i], LEAD, &coeffs);
+        checkForward64(&vectors[i], 0, &coeffs);
+        checkForward64(&vectors[i], LEAD, &coeffs);
+        checkEncodeHw32(&vectors[i], &coeffs);
+    }
+
+    // the same set given explicitly takes the scalar inverse instead of the prefix sums
+    const int32_t c[] = {4, -6, 4, -1};
+    lpe_coeffs_t explicitCoeffs;
+    CHECK(lpe_coeffs_init(&explicitCoeffs, c, 4) == LPE_OK, "cannot set (4,-6,4,-1)");
+    explicitCoeffs.order = 0;
+    checkForward32(&vectors[0], LEAD, &explicitCoeffs);
+    checkForward64(&vectors[0], LEAD, &explicitCoeffs);
+}
+
+/*MapFP2UInt of IntegerizeFPSpec.fixedtestdata, and the float codec on those values*/
+static void testMapFP2UInt(void)
+{
+    static const float data[] = {0.0f, 1.0f, -1.0f, 1.0001f, 1.0002f, 1.0003f};
+    static const uint32_t bits[] = {0x00000000u, 0x3f800000u, 0xbf800000u, 0x3f800347u, 0x3f80068eu, 0x3f8009d5u};
+    static const uint32_t mapped[] = {0x80000000u, 0xbf800000u, 0x407fffffu, 0xbf800347u, 0xbf80068eu, 0xbf8009d5u};
+    uint32_t u[COUNT(data)], expected[COUNT(data)], res[COUNT(data)];
+    float back[COUNT(data)];
+    size_t i;
+
+    for (i = 0; i < COUNT(data); i++) {
+        uint32_t b;
+        memcpy(&b, &data[i], sizeof(b));
+        CHECK(b == bits[i], "%g has the bits 0x%08x, expected 0x%08x", data[i], b, bits[i]);
+    }
+    lpe_fp2uint32(data, u, COUNT(data));
+    CHECK(memcmp(u, mapped, sizeof(mapped)) == 0, "lpe_fp2uint32 differs from ifp32Forward");
+    lpe_uint2fp32(mapped, back, COUNT(data));
+    CHECK(memcmp(back, data, sizeof(data)) == 0, "lpe_uint2fp32 differs from ifp32Backward");
+
+    lpe_coeffs_t coeffs;
+    lpe_lagrange_coeffs(&coeffs, 4);
+    lpe_forward32(mapped, expected, COUNT(data), &coeffs);
+    lpe_encode_float(data, res, COUNT(data), &coeffs);
+    CHECK(memcmp(res, expected, sizeof(res)) == 0, "lpe_encode_float differs from MapFP2UInt + forward");
+    lpe_decode_float(res, back, COUNT(data), &coeffs);
+    CHECK(memcmp(back, data, sizeof(data)) == 0, "lpe_decode_float does not give the floats back");
+}
+
+int main(void)
+{
+    int level;
+    for (level = lpe_simd_detect(); level >= LPE_SIMD_NONE; level--) {
+        lpe_set_simd_level(level);
+        testLagrangeVectors();
+        testMapFP2UInt();
+    }
+    if (failures == 0)
+        printf("all tests passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -6,13 +6,96 @@ package common
 /**
  * Bit Plane Compressor for bit-shuffled data
  * Implements length calculation and zero suppression for optimal compression
+ *
+ * Bit planes are packed: plane p of N values is ceil(N/32) Ints, bit i % 32 of word i / 32 being bit p
+ * of value i. Each block of 32 values is a 32x32 bit matrix, so one in-register transpose turns it
+ * into one word of each of the 32 planes. The blocks are visited in order, so the 32 output streams
+ * are written sequentially and their current cache lines (2 KB in total) stay in L1.
  */
 object BitPlaneCompressor {
-  
+
+  val numBitPlanes = 32 // 32-bit integers
+
+  def wordsPerPlane(dataLength: Int): Int = (dataLength + 31) / 32
+
+  /**
+   * Transpose the 32x32 bit matrix a(off) .. a(off + 31) in place: afterwards bit i of a(off + p) is
+   * what bit p of a(off + i) was. It is its own inverse.
+   */
+  def transpose32(a: Array[Int], off: Int): Unit = {
+    var j = 16
+    var m = 0x0000ffff
+    while (j != 0) {
+      var k = 0
+      while (k < 32) {
+        val t = ((a(off + k) >>> j) ^ a(off + k + j)) & m
+        a(off + k + j) ^= t
+        a(off + k) ^= t << j
+        k = (k + j + 1) & ~j
+      }
+      j >>= 1
+      m ^= m << j
+    }
+  }
+
+  /**
+   * Packed bit planes of data: plane p is words p * wordsPerPlane until (p + 1) * wordsPerPlane
+   */
+  def packBitPlanes(data: Array[Int]): Array[Int] = {
+    val dataLength = data.length
+    val wpp = wordsPerPlane(dataLength)
+    val planes = new Array[Int](numBitPlanes * wpp)
+    val block = new Array[Int](32)
+    var b = 0
+    while (b < wpp) {
+      val len = math.min(32, dataLength - b * 32)
+      System.arraycopy(data, b * 32, block, 0, len)
+      if (len < 32) java.util.Arrays.fill(block, len, 32, 0)
+      transpose32(block, 0)
+      var p = 0
+      while (p < numBitPlanes) {
+        planes(p * wpp + b) = block(p)
+        p += 1
+      }
+      b += 1
+    }
+    planes
+  }
+
+  /**
+   * The dataLength values whose packed bit planes are planes
+   */
+  def unpackBitPlanes(planes: Array[Int], dataLength: Int): Array[Int] = {
+    val wpp = wordsPerPlane(dataLength)
+    require(planes.length == numBitPlanes * wpp, "planes do not hold 32 planes of dataLength bits")
+    val data = new Array[Int](dataLength)
+    val block = new Array[Int](32)
+    var b = 0
+    while (b < wpp) {
+      var p = 0
+      while (p < numBitPlanes) {
+        block(p) = planes(p * wpp + b)
+        p += 1
+      }
+      transpose32(block, 0)
+      System.arraycopy(block, 0, data, b * 32, math.min(32, dataLength - b * 32))
+      b += 1
+    }
+    data
+  }
+
+  private def planeIsZero(planes: Array[Int], p: Int, wpp: Int): Boolean = {
+    var i = p * wpp
+    while (i < (p + 1) * wpp && planes(i) == 0) i += 1
+    i == (p + 1) * wpp
+  }
+
   /**
-   * Compress bit-shuffled data using bit plane analysis
-   * @param bitShuffledData Array of 32-bit integers after bit shuffling
-   * @return (compressedData, metadata) where metadata contains length information
+   * Compress data using bit plane analysis: the whole array is transposed into 32 packed bit planes
+   * here, so it takes the values themselves (compressPlanes takes BitShuffleUtils.shuffle's output)
+   * @param bitShuffledData Array of 32-bit integers
+   * @return (compressedData, metadata): the packed non-zero bit planes (wordsPerPlane Ints each, in
+   *         plane order) and the metadata with their indices
    */
   def compress(bitShuffledData: Array[Int]): (Array[Int], BitPlaneMetadata) = {
     if (bitShuffledData.isEmpty) {
@@ -20,15 +103,13 @@ object BitPlaneCompressor {
     }
     
     val dataLength = bitShuffledData.length
-    val numBitPlanes = 32 // 32-bit integers
+    val wpp = wordsPerPlane(dataLength)
     
     // Extract bit planes (each bit position across all values)
-    val bitPlanes = extractBitPlanes(bitShuffledData)
+    val bitPlanes = packBitPlanes(bitShuffledData)
     
     // Analyze which bit planes contain non-zero data
-    val nonZeroBitPlanes = bitPlanes.zipWithIndex.filter { case (plane, _) =>
-      plane.exists(_ != 0)
-    }
+    val nonZeroBitPlanes = (0 until numBitPlanes).filter(p => !planeIsZero(bitPlanes, p, wpp)).toArray
     
     // Calculate compression metadata
     val length = nonZeroBitPlanes.length
@@ -38,107 +119,102 @@ object BitPlaneCompressor {
     // Create metadata
     val metadata = BitPlaneMetadata(
       totalBitPlanes = numBitPlanes,
-      nonZeroBitPlaneIndices = nonZeroBitPlanes.map(_._2).toArray,
+      nonZeroBitPlaneIndices = nonZeroBitPlanes,
       dataLength = dataLength
     )
     
     // Compressed data: only the non-zero bit planes
-    val compressedData = nonZeroBitPlanes.flatMap(_._1)
+    val compressedData = new Array[Int](length * wpp)
+    for ((p, i) <- nonZeroBitPlanes.zipWithIndex) {
+      System.arraycopy(bitPlanes, p * wpp, compressedData, i * wpp, wpp)
+    }
     
+    val originalBits = dataLength.toLong * numBitPlanes
+    val compressedBits = dataLength.toLong * length
     println(s"Bit plane compression analysis:")
     println(s"  Total bit planes: $numBitPlanes")
     println(s"  Non-zero bit planes: $length")
     println(s"  Zero bit planes eliminated: $zeroBitPlanes")
     println(f"  Compression ratio: ${compressionRatio}%.2fx")
-    println(s"  Original size: ${dataLength * numBitPlanes} bits")
-    println(s"  Compressed size: ${compressedData.length} bits")
-    println(f"  Space saved: ${((1.0 - compressedData.length.toDouble / (dataLength * numBitPlanes)) * 100)}%.1f%%")
+    println(s"  Original size: $originalBits bits")
+    println(s"  Compressed size: $compressedBits bits (${compressedData.length} words)")
+    println(f"  Space saved: ${((1.0 - compressedBits.toDouble / originalBits) * 100)}%.1f%%")
     
     (compressedData, metadata)
   }
   
   /**
    * Decompress bit plane compressed data
-   * @param compressedData The compressed bit plane data
+   * @param compressedData The packed non-zero bit planes from compress
    * @param metadata The compression metadata
    * @return Original bit-shuffled data
    */
   def decompress(compressedData: Array[Int], metadata: BitPlaneMetadata): Array[Int] = {
-    if (compressedData.isEmpty || metadata.totalBitPlanes == 0) {
+    if (metadata.totalBitPlanes == 0 || metadata.dataLength == 0) {
       return Array.empty
     }
     
     val dataLength = metadata.dataLength
-    val numBitPlanes = metadata.totalBitPlanes
+    val wpp = wordsPerPlane(dataLength)
     val nonZeroIndices = metadata.nonZeroBitPlaneIndices
+    require(compressedData.length == nonZeroIndices.length * wpp, "compressed data does not match the metadata")
     
     // Reconstruct all bit planes (zero and non-zero)
-    val allBitPlanes = Array.fill(numBitPlanes)(Array.fill(dataLength)(0))
+    val allBitPlanes = new Array[Int](numBitPlanes * wpp)
     
     // Fill in the non-zero bit planes
-    var dataIndex = 0
-    for (i <- nonZeroIndices.indices) {
-      val bitPlaneIndex = nonZeroIndices(i)
-      val bitPlaneData = compressedData.slice(dataIndex, dataIndex + dataLength)
-      allBitPlanes(bitPlaneIndex) = bitPlaneData
-      dataIndex += dataLength
+    for ((p, i) <- nonZeroIndices.zipWithIndex) {
+      System.arraycopy(compressedData, i * wpp, allBitPlanes, p * wpp, wpp)
     }
     
     // Reconstruct the original bit-shuffled data
-    reconstructFromBitPlanes(allBitPlanes)
+    unpackBitPlanes(allBitPlanes, dataLength)
   }
   
   /**
-   * Extract bit planes from bit-shuffled data
-   * Each bit plane contains one bit position from all values
+   * Zero suppression of BitShuffleUtils.shuffle's output (32-value blocks), whose words already are bit
+   * planes: word 32 * g + p is plane p of values 32 * g until 32 * g + 32. Only the non-zero words are
+   * kept, so a plane here is one word and the metadata lists the indices of the non-zero ones.
+   * @return (compressedData, metadata): the non-zero words in order and their indices
    */
-  private def extractBitPlanes(data: Array[Int]): Array[Array[Int]] = {
-    val numBitPlanes = 32
-    val dataLength = data.length
-    
-    val bitPlanes = Array.fill(numBitPlanes)(Array.fill(dataLength)(0))
-    
-    for (bitPos <- 0 until numBitPlanes) {
-      for (i <- data.indices) {
-        bitPlanes(bitPos)(i) = (data(i) >> bitPos) & 1
-      }
-    }
-    
-    bitPlanes
+  def compressPlanes(bitShuffledData: Array[Int]): (Array[Int], BitPlaneMetadata) = {
+    val nonZeroPlanes = bitShuffledData.indices.filter(bitShuffledData(_) != 0).toArray
+    val metadata = BitPlaneMetadata(
+      totalBitPlanes = bitShuffledData.length,
+      nonZeroBitPlaneIndices = nonZeroPlanes,
+      dataLength = bitShuffledData.length
+    )
+    (nonZeroPlanes.map(bitShuffledData), metadata)
   }
-  
+
   /**
-   * Reconstruct data from bit planes
+   * The bit-shuffled words back from compressPlanes' output
    */
-  private def reconstructFromBitPlanes(bitPlanes: Array[Array[Int]]): Array[Int] = {
-    val dataLength = bitPlanes(0).length
-    val reconstructed = Array.fill(dataLength)(0)
-    
-    for (i <- 0 until dataLength) {
-      var value = 0
-      for (bitPos <- bitPlanes.indices) {
-        value |= (bitPlanes(bitPos)(i) << bitPos)
-      }
-      reconstructed(i) = value
-    }
-    
-    reconstructed
+  def decompressPlanes(compressedData: Array[Int], metadata: BitPlaneMetadata): Array[Int] = {
+    val nonZeroIndices = metadata.nonZeroBitPlaneIndices
+    require(compressedData.length == nonZeroIndices.length, "compressed data does not match the metadata")
+    val data = new Array[Int](metadata.dataLength)
+    for ((p, i) <- nonZeroIndices.zipWithIndex) data(p) = compressedData(i)
+    data
   }
-  
+
   /**
    * Analyze bit plane sparsity for X-ray data
    */
   def analyzeBitPlaneSparsity(bitShuffledData: Array[Int]): BitPlaneAnalysis = {
-    val bitPlanes = extractBitPlanes(bitShuffledData)
+    val dataLength = bitShuffledData.length
+    val wpp = wordsPerPlane(dataLength)
+    val bitPlanes = packBitPlanes(bitShuffledData)
     
-    val sparsityByPlane = bitPlanes.map { plane =>
-      val nonZeros = plane.count(_ != 0)
-      val sparsity = 1.0 - (nonZeros.toDouble / plane.length)
-      sparsity
+    val nonZerosByPlane = Array.tabulate(numBitPlanes) { p =>
+      var nonZeros = 0
+      for (i <- p * wpp until (p + 1) * wpp) nonZeros += Integer.bitCount(bitPlanes(i))
+      nonZeros
     }
+    val sparsityByPlane = nonZerosByPlane.map(nonZeros => 1.0 - (nonZeros.toDouble / dataLength))
     
-    val totalNonZeroBits = bitPlanes.map(_.count(_ != 0)).sum
-    val totalBits = bitShuffledData.length * 32
+    val totalNonZeroBits = nonZerosByPlane.sum
+    val totalBits = dataLength * 32
     val overallSparsity = 1.0 - (totalNonZeroBits.toDouble / totalBits)
     
     BitPlaneAnalysis(
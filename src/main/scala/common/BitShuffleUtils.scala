@@ -10,29 +10,61 @@ package common
 object BitShuffleUtils {
   
   /**
-   * Perform bit shuffling on an array of 32-bit integers
-   * This is a software implementation of the hardware bit shuffling algorithm
+   * Default block size: 32 values, so each output word is one output of BitShuffle(32, 32)
    */
-  def shuffle(data: Array[Int]): Array[Int] = {
-    if (data.isEmpty) return Array.empty
-    
-    // For simplicity, we'll implement a basic bit shuffling
-    // In practice, this would match the hardware implementation more closely
-    data.map { value =>
-      // Simple bit shuffling: reverse the bits
-      Integer.reverse(value)
+  val defaultBlockSize = 32
+
+  /**
+   * Blocked bit shuffle of an array of 32-bit integers, the software model of the hardware BitShuffle
+   *
+   * The data is cut into blocks of blockSize values (the last block may be shorter). A block of n values
+   * becomes 32 bit planes of n bits, plane 0 first, where bit j of plane b is bit b of value j. The planes
+   * are packed into n words, least significant bit first, so with blockSize = N word b of a block holds
+   * out(b) of BitShuffle(N, 32) for N = 32, and out(2w) | out(2w + 1) << 16 in word w for N = 16.
+   * The output has the length of the input.
+   */
+  def shuffle(data: Array[Int], blockSize: Int = defaultBlockSize): Array[Int] = {
+    require(blockSize > 0, "blockSize must be positive")
+    val out = new Array[Int](data.length)
+    for (start <- data.indices by blockSize) {
+      shuffleBlock(data, out, start, math.min(blockSize, data.length - start), inverse = false)
     }
+    out
   }
-  
+
   /**
-   * Reverse bit shuffling operation
+   * Reverse bit shuffling operation (blockSize must be the one given to shuffle)
    */
-  def unshuffle(data: Array[Int]): Array[Int] = {
-    if (data.isEmpty) return Array.empty
-    
-    // Reverse the shuffling operation
-    data.map { value =>
-      Integer.reverse(value)
+  def unshuffle(data: Array[Int], blockSize: Int = defaultBlockSize): Array[Int] = {
+    require(blockSize > 0, "blockSize must be positive")
+    val out = new Array[Int](data.length)
+    for (start <- data.indices by blockSize) {
+      shuffleBlock(data, out, start, math.min(blockSize, data.length - start), inverse = true)
+    }
+    out
+  }
+
+  /**
+   * Shuffle (or unshuffle) the n values at off. Blocks of a multiple of 32 values go through 32x32 bit
+   * transposes: group g of 32 values gives word g of every plane. Other blocks are done bit by bit.
+   */
+  private def shuffleBlock(in: Array[Int], out: Array[Int], off: Int, n: Int, inverse: Boolean): Unit = {
+    if (n % 32 == 0) {
+      val wordsPerPlane = n / 32
+      val t = new Array[Int](32)
+      for (g <- 0 until wordsPerPlane) {
+        for (i <- 0 until 32) t(i) = if (inverse) in(off + i * wordsPerPlane + g) else in(off + 32 * g + i)
+        BitPlaneCompressor.transpose32(t, 0)
+        for (i <- 0 until 32) {
+          if (inverse) out(off + 32 * g + i) = t(i) else out(off + i * wordsPerPlane + g) = t(i)
+        }
+      }
+    } else {
+      for (j <- 0 until n; b <- 0 until 32) {
+        val k = b * n + j // bit position in the packed planes
+        if (inverse) out(off + j) |= ((in(off + k / 32) >>> (k % 32)) & 1) << b
+        else out(off + k / 32) |= ((in(off + j) >>> b) & 1) << (k % 32)
+      }
     }
   }
   
@@ -16,9 +16,10 @@ object ConversionUtils {
   def v2fConvert(data: Array[Int], blockSize: Int = 128): Array[Float] = {
     if (data.isEmpty) return Array.empty
     
-    // For simplicity, we'll convert each int to float
+    // For simplicity, we'll convert each int to float (its raw bits, so packed 32-bit words
+    // such as bit planes survive the round trip; toFloat would round them above 2^24)
     // In practice, this would implement the full V2F algorithm
-    data.map(_.toFloat)
+    data.map(java.lang.Float.intBitsToFloat)
   }
   
   /**
@@ -30,7 +31,7 @@ object ConversionUtils {
     
     // For simplicity, we'll convert each float back to int
     // In practice, this would implement the full F2V algorithm
-    data.map(_.toInt)
+    data.map(java.lang.Float.floatToRawIntBits)
   }
   
   /**
@@ -111,7 +111,7 @@ class DataFeeder(
 }
 
 /**
- * Numpy Data Feeder - integrates with NumpyReaderScalaPy
+ * Numpy Data Feeder - integrates with NumpyReader (memory-mapped .npy files)
  * This is a software component that can be used for testing
  */
 object NumpyDataFeeder {
@@ -120,15 +120,12 @@ object NumpyDataFeeder {
    * Feed numpy data as a stream of uint32 values
    */
   def feedNumpyData(filename: String, chunkSize: Int = 1024): Iterator[Int] = {
-    NumpyReaderScalaPy.readNumpyData(filename) match {
-      case scala.util.Success(data) =>
-        println(s"Feeding ${data.length} elements from $filename")
+    NumpyReader.open(filename) match {
+      case scala.util.Success(array) =>
+        println(s"Feeding ${array.nbElements} elements from $filename")
         
-        // Convert float to uint32 for bit shuffling
-        data.iterator.map { floatVal =>
-          // Convert float to uint32 using bit representation
-          java.lang.Float.floatToRawIntBits(floatVal)
-        }
+        // Convert float to uint32 using bit representation, chunkSize values read at a time
+        array.chunks(chunkSize).flatMap(_.iterator.map(java.lang.Float.floatToRawIntBits))
         
       case scala.util.Failure(exception) =>
         println(s"Error reading numpy file: ${exception.getMessage}")
@@ -137,16 +134,15 @@ object NumpyDataFeeder {
   }
   
   /**
-   * Feed numpy data in chunks for processing
+   * Feed numpy data in chunks for processing; each chunk is read when it is reached
    */
   def feedNumpyDataInChunks(filename: String, chunkSize: Int = 1024): Iterator[Array[Int]] = {
-    NumpyReaderScalaPy.readNumpyData(filename) match {
-      case scala.util.Success(data) =>
-        println(s"Feeding ${data.length} elements in chunks of $chunkSize")
+    NumpyReader.open(filename) match {
+      case scala.util.Success(array) =>
+        println(s"Feeding ${array.nbElements} elements in chunks of $chunkSize")
         
         // Convert and chunk the data
-        val uint32Data = data.map(java.lang.Float.floatToRawIntBits)
-        uint32Data.grouped(chunkSize).map(_.toArray)
+        array.chunks(chunkSize).map(_.map(java.lang.Float.floatToRawIntBits))
         
       case scala.util.Failure(exception) =>
         println(s"Error reading numpy file: ${exception.getMessage}")
@@ -0,0 +1,246 @@
+// See LICENSE.txt in the project root for license information.
+// Author: Pure-JVM Numpy Reader for StreamPressor
+
+package common
+
+import java.io.RandomAccessFile
+import java.nio.{ByteBuffer, ByteOrder, FloatBuffer, MappedByteBuffer}
+import java.nio.channels.FileChannel
+import java.nio.charset.StandardCharsets
+import scala.util.Try
+
+/**
+ * Header of a .npy file
+ *
+ * @param descr        numpy type string, e.g. "<f4"
+ * @param shape        array dimensions (empty for a scalar)
+ * @param fortranOrder the payload is in column-major order
+ * @param dataOffset   file offset of the payload
+ */
+case class NpyHeader(descr: String, shape: Array[Long], fortranOrder: Boolean, dataOffset: Long) {
+  val byteOrder: ByteOrder = if (descr.charAt(0) == '>') ByteOrder.BIG_ENDIAN else ByteOrder.LITTLE_ENDIAN
+  val kind: Char = descr.charAt(1) // 'f', 'i' or 'u'
+  val itemSize: Int = descr.substring(2).toInt
+  val nbElements: Long = shape.product
+
+  /** numpy's dtype.name, e.g. "float32" */
+  def dataType: String = kind match {
+    case 'f' => s"float${itemSize * 8}"
+    case 'i' => s"int${itemSize * 8}"
+    case _   => s"uint${itemSize * 8}"
+  }
+}
+
+/**
+ * A memory-mapped .npy payload
+ *
+ * Nothing is read until values are asked for. The values are returned as Float in C (row-major)
+ * order, like np.load(f).flatten(). Payloads over 1 GB are mapped in several 1 GB segments.
+ */
+class NpyArray private[common] (val header: NpyHeader, segments: Array[MappedByteBuffer]) {
+  val nbElements: Long = header.nbElements
+  private val segmentShift = 30 - Integer.numberOfTrailingZeros(header.itemSize) // elements per segment (log2)
+  private val segmentMask = (1L << segmentShift) - 1
+  private val isFloat32 = header.kind == 'f' && header.itemSize == 4
+  private val floatViews: Array[FloatBuffer] =
+    if (isFloat32) segments.map(_.duplicate().order(header.byteOrder).asFloatBuffer()) else Array.empty
+  private val byteViews: Array[ByteBuffer] = segments.map(_.duplicate().order(header.byteOrder))
+
+  // column-major strides, to find the payload position of a C-order index
+  private val fortranStrides: Array[Long] = header.shape.scanLeft(1L)(_ * _).init
+
+  private def payloadIndex(i: Long): Long = {
+    if (!header.fortranOrder) i
+    else {
+      var rem = i
+      var pos = 0L
+      for (j <- header.shape.indices.reverse) {
+        pos += (rem % header.shape(j)) * fortranStrides(j)
+        rem /= header.shape(j)
+      }
+      pos
+    }
+  }
+
+  // element decoder for the payload types other than float32, chosen once
+  private val decode: (ByteBuffer, Int) => Float = (header.kind, header.itemSize) match {
+    case ('f', 8) => (b, at) => b.getDouble(at).toFloat
+    case ('i', 1) => (b, at) => b.get(at).toFloat
+    case ('i', 2) => (b, at) => b.getShort(at).toFloat
+    case ('i', 4) => (b, at) => b.getInt(at).toFloat
+    case ('i', _) => (b, at) => b.getLong(at).toFloat
+    case (_, 1)   => (b, at) => (b.get(at) & 0xff).toFloat
+    case (_, 2)   => (b, at) => (b.getShort(at) & 0xffff).toFloat
+    case (_, 4)   => (b, at) => (b.getInt(at) & 0xffffffffL).toFloat
+    case _        => (b, at) => NumpyReader.uint64ToFloat(b.getLong(at))
+  }
+
+  private def payloadValue(p: Long): Float = {
+    val seg = (p >>> segmentShift).toInt
+    val off = (p & segmentMask).toInt
+    if (isFloat32) floatViews(seg).get(off)
+    else decode(byteViews(seg), off * header.itemSize)
+  }
+
+  /** the i-th value in C order */
+  def apply(i: Long): Float = payloadValue(payloadIndex(i))
+
+  /** copies len values from C-order index start into dst(dstOffset ...) */
+  def read(start: Long, dst: Array[Float], dstOffset: Int, len: Int): Unit = {
+    require(start >= 0 && len >= 0 && start + len <= nbElements, "read past the end of the array")
+    if (isFloat32 && !header.fortranOrder) {
+      var done = 0
+      while (done < len) { // bulk copies, split at the segment boundaries
+        val p = start + done
+        val view = floatViews((p >>> segmentShift).toInt).duplicate()
+        view.position((p & segmentMask).toInt)
+        val n = math.min(len - done, view.remaining())
+        view.get(dst, dstOffset + done, n)
+        done += n
+      }
+    } else {
+      for (k <- 0 until len) dst(dstOffset + k) = apply(start + k)
+    }
+  }
+
+  /** consecutive chunks of chunkSize values (the last one may be shorter), each read when it is reached */
+  def chunks(chunkSize: Int): Iterator[Array[Float]] = {
+    require(chunkSize > 0)
+    Iterator.iterate(0L)(_ + chunkSize).takeWhile(_ < nbElements).map { start =>
+      val chunk = new Array[Float](math.min(chunkSize.toLong, nbElements - start).toInt)
+      read(start, chunk, 0, chunk.length)
+      chunk
+    }
+  }
+
+  def iterator: Iterator[Float] = chunks(NumpyReader.streamChunkSize).flatMap(_.iterator)
+
+  def toArray: Array[Float] = {
+    require(nbElements <= Int.MaxValue - 8, s"$nbElements values do not fit in one array; use chunks")
+    val a = new Array[Float](nbElements.toInt)
+    read(0, a, 0, a.length)
+    a
+  }
+
+  /**
+   * The payload as a FloatBuffer over the mapping (no copy); float32 C-order payloads up to 1 GB.
+   * Its byte order is the file's.
+   */
+  def floatBuffer: FloatBuffer = {
+    require(isFloat32 && !header.fortranOrder && floatViews.length <= 1,
+      "floatBuffer needs a float32 C-order payload of at most one segment")
+    if (floatViews.isEmpty) FloatBuffer.allocate(0) else floatViews(0).duplicate()
+  }
+}
+
+/**
+ * Pure-JVM .npy reader (format versions 1.0, 2.0 and 3.0)
+ * Parses the header itself and memory-maps the payload: no Python, and no copy of the file.
+ */
+object NumpyReader {
+  import NumpyReaderScalaPy.{DataStats, NumpyMetadata}
+
+  val streamChunkSize = 1 << 16
+  private val magic = Array[Int](0x93, 'N', 'U', 'M', 'P', 'Y').map(_.toByte)
+  private val segmentBytes = 1L << 30
+
+  private[common] def uint64ToFloat(v: Long): Float =
+    if (v >= 0) v.toFloat else ((v >>> 1) | (v & 1L)).toFloat * 2.0f
+
+  /** parse the header dictionary, e.g. {'descr': '<f4', 'fortran_order': False, 'shape': (2, 128, 128), } */
+  def parseHeader(text: String, dataOffset: Long): NpyHeader = {
+    def field(name: String, pattern: String): String = {
+      val m = (s"'$name'\\s*:\\s*" + pattern).r.findFirstMatchIn(text)
+      m.getOrElse(throw new IllegalArgumentException(s"no '$name' in the .npy header: $text")).group(1)
+    }
+    val descr = field("descr", "'([^']*)'")
+    val fortranOrder = field("fortran_order", "(True|False)") == "True"
+    val shape = field("shape", "\\(([^)]*)\\)").split(",").map(_.trim.stripSuffix("L")).filter(_.nonEmpty)
+      .map(_.toLong)
+
+    val supported = "^[<>|=]([f][48]|[iu][1248])$".r
+    if (supported.findFirstIn(descr).isEmpty)
+      throw new IllegalArgumentException(s"unsupported .npy dtype '$descr' (float32/64 and integers are)")
+    val nativeDescr = if (descr.charAt(0) == '=') {
+      (if (ByteOrder.nativeOrder() == ByteOrder.BIG_ENDIAN) ">" else "<") + descr.substring(1)
+    } else descr
+    NpyHeader(nativeDescr, shape, fortranOrder, dataOffset)
+  }
+
+  private def readHeader(channel: FileChannel): NpyHeader = {
+    val preamble = ByteBuffer.allocate(12).order(ByteOrder.LITTLE_ENDIAN)
+    while (preamble.hasRemaining && channel.read(preamble, preamble.position().toLong) > 0) {}
+    if (preamble.position() < 10 || !(0 until 6).forall(i => preamble.get(i) == magic(i)))
+      throw new IllegalArgumentException("not a .npy file")
+    val major = preamble.get(6).toInt
+    val (headerLength, headerStart) = major match {
+      case 1     => (preamble.getShort(8) & 0xffff, 10)
+      case 2 | 3 => (preamble.getInt(8), 12)
+      case _     => throw new IllegalArgumentException(s"unsupported .npy format version $major")
+    }
+    val text = ByteBuffer.allocate(headerLength)
+    while (text.hasRemaining && channel.read(text, headerStart.toLong + text.position()) > 0) {}
+    if (text.hasRemaining) throw new IllegalArgumentException("truncated .npy header")
+    val charset = if (major == 3) StandardCharsets.UTF_8 else StandardCharsets.ISO_8859_1
+    parseHeader(new String(text.array(), charset), headerStart.toLong + headerLength)
+  }
+
+  def readHeader(filename: String): Try[NpyHeader] = Try {
+    val file = new RandomAccessFile(filename, "r")
+    try readHeader(file.getChannel)
+    finally file.close()
+  }
+
+  private def mapPayload(channel: FileChannel, header: NpyHeader, filename: String): NpyArray = {
+    val payloadBytes = header.nbElements * header.itemSize
+    if (header.dataOffset + payloadBytes > channel.size())
+      throw new IllegalArgumentException(s"$filename is shorter than its header says")
+    val segments = (0L until payloadBytes by segmentBytes).map { at =>
+      channel.map(FileChannel.MapMode.READ_ONLY, header.dataOffset + at, math.min(segmentBytes, payloadBytes - at))
+    }.toArray
+    new NpyArray(header, segments)
+  }
+
+  /** map the payload of a .npy file; the mapping stays valid after the file is closed */
+  def open(filename: String): Try[NpyArray] = Try {
+    val file = new RandomAccessFile(filename, "r")
+    try {
+      val channel = file.getChannel
+      mapPayload(channel, readHeader(channel), filename)
+    } finally file.close()
+  }
+
+  /**
+   * map a headerless file of descr values (a numpy type string such as "<f4"; without a byte order
+   * it is little endian) as a one-dimensional array; a partial value at the end is ignored
+   */
+  def openRaw(filename: String, descr: String): Try[NpyArray] = Try {
+    val fullDescr = if ("<>|=".contains(descr.take(1))) descr else "<" + descr
+    val file = new RandomAccessFile(filename, "r")
+    try {
+      val channel = file.getChannel
+      val header = parseHeader(s"{'descr': '$fullDescr', 'fortran_order': False, 'shape': (), }", 0L)
+      mapPayload(channel, header.copy(shape = Array(channel.size() / header.itemSize)), filename)
+    } finally file.close()
+  }
+
+  // Same interface as NumpyReaderScalaPy
+
+  def readNumpyData(filename: String): Try[Array[Float]] = open(filename).map(_.toArray)
+
+  def readNumpyFile(filename: String): Try[(NumpyMetadata, Array[Float])] = open(filename).map { a =>
+    val h = a.header
+    (NumpyMetadata(h.dataType, h.shape.map(_.toInt), h.fortranOrder, h.dataOffset.toInt), a.toArray)
+  }
+
+  def getDataStats(filename: String): Try[DataStats] = open(filename).map { a =>
+    var nonZero = 0L
+    a.chunks(streamChunkSize).foreach(c => nonZero += c.count(_ != 0.0f))
+    DataStats(a.nbElements.toInt, nonZero.toInt, if (a.nbElements > 0) 1.0 - nonZero.toDouble / a.nbElements else 0.0)
+  }
+
+  def feedNumpyDataInChunks(filename: String, chunkSize: Int): Iterator[Array[Float]] =
+    open(filename).get.chunks(chunkSize)
+
+  def feedNumpyData(filename: String): Iterator[Float] = open(filename).get.iterator
+}
@@ -9,14 +9,21 @@ import scala.util.{Try, Success, Failure}
 
 /**
  * ScalaPy-based Numpy Reader
- * Uses Python's numpy directly to read .npy files
+ * Uses Python's numpy directly to read .npy files.
+ * The read and feed functions now use the pure-JVM NumpyReader (memory-mapped, no per-element
+ * Python objects); readNumpyDataPy keeps the numpy path for files NumpyReader does not support.
  */
 object NumpyReaderScalaPy {
   
   /**
    * Read numpy file and return flattened float array
    */
-  def readNumpyData(filename: String): Try[Array[Float]] = {
+  def readNumpyData(filename: String): Try[Array[Float]] = NumpyReader.readNumpyData(filename)
+
+  /**
+   * Read numpy file through Python's numpy (any dtype numpy can convert to float)
+   */
+  def readNumpyDataPy(filename: String): Try[Array[Float]] = {
     Try {
       val np = py.module("numpy")
       val data = np.load(filename)
@@ -31,73 +38,23 @@ object NumpyReaderScalaPy {
   /**
    * Read numpy file and return metadata and data
    */
-  def readNumpyFile(filename: String): Try[(NumpyMetadata, Array[Float])] = {
-    Try {
-      val np = py.module("numpy")
-      val data = np.load(filename)
-      
-      // Extract metadata
-      val shapeList = data.shape.tolist()
-      val shape = shapeList.as[Seq[Int]].toArray
-      
-      val metadata = NumpyMetadata(
-        dataType = data.dtype.name.as[String],
-        shape = shape,
-        fortranOrder = false, // Default to C order
-        dataOffset = 0
-      )
-      
-      // Get flattened data
-      val flatData = data.flatten()
-      val listData = flatData.tolist()
-      val floatData = listData.as[Seq[Float]].toArray
-      
-      (metadata, floatData)
-    }
-  }
+  def readNumpyFile(filename: String): Try[(NumpyMetadata, Array[Float])] = NumpyReader.readNumpyFile(filename)
   
   /**
    * Get basic statistics about the data
    */
-  def getDataStats(filename: String): Try[DataStats] = {
-    Try {
-      val np = py.module("numpy")
-      val data = np.load(filename)
-      val flatData = data.flatten()
-      
-      val totalElements = flatData.size.as[Int]
-      val nonZeroCount = np.count_nonzero(flatData).as[Int]
-      val zeroRatio = 1.0 - (nonZeroCount.toDouble / totalElements)
-      
-      DataStats(totalElements, nonZeroCount, zeroRatio)
-    }
-  }
+  def getDataStats(filename: String): Try[DataStats] = NumpyReader.getDataStats(filename)
   
   /**
-   * Feed data in chunks for processing
+   * Feed data in chunks for processing; each chunk is read when it is reached
    */
-  def feedNumpyDataInChunks(filename: String, chunkSize: Int): Iterator[Array[Float]] = {
-    val np = py.module("numpy")
-    val data = np.load(filename)
-    val flatData = data.flatten()
-    val listData = flatData.tolist()
-    val floatData = listData.as[Seq[Float]].toArray
-    
-    floatData.grouped(chunkSize)
-  }
+  def feedNumpyDataInChunks(filename: String, chunkSize: Int): Iterator[Array[Float]] =
+    NumpyReader.feedNumpyDataInChunks(filename, chunkSize)
   
   /**
    * Feed data as a stream
    */
-  def feedNumpyData(filename: String): Iterator[Float] = {
-    val np = py.module("numpy")
-    val data = np.load(filename)
-    val flatData = data.flatten()
-    val listData = flatData.tolist()
-    val floatData = listData.as[Seq[Float]].toArray
-    
-    floatData.iterator
-  }
+  def feedNumpyData(filename: String): Iterator[Float] = NumpyReader.feedNumpyData(filename)
   
   /**
    * Numpy file metadata
@@ -0,0 +1,265 @@
+// See LICENSE.txt in the project root for license information.
+// Author: Design-space exploration sweep for StreamPressor
+
+package estimate
+
+import common.NumpyReader
+import java.io.{File, PrintWriter}
+import scala.util.Try
+
+/** a dataset, read once and kept integerized (ifp32) for every configuration of a sweep */
+case class Dataset(name: String, ints: Array[Int]) {
+  def nbElements: Int = ints.length
+
+  /** the float32 values of ints(off until off + len) */
+  def floats(off: Int, len: Int): Array[Float] =
+    Array.tabulate(len)(i => java.lang.Float.intBitsToFloat(LPECompEstimateCR.ifp32Backward(ints(off + i))))
+
+  /** max - min of the values (NaNs aside), the reference of the relative SZx error bounds */
+  lazy val valueRange: Double = {
+    var min = Float.PositiveInfinity
+    var max = Float.NegativeInfinity
+    for (v <- ints) {
+      val f = java.lang.Float.intBitsToFloat(LPECompEstimateCR.ifp32Backward(v))
+      if (f < min) min = f
+      if (f > max) max = f
+    }
+    if (max >= min) max.toDouble - min else 0.0
+  }
+}
+
+/**
+ * The grid of a sweep; every combination is evaluated over every dataset
+ *
+ * @param coefficientSets LagrangePred coefficients
+ * @param packetbws       V2FConv/F2VConv packet widths (at least the 4-bit header)
+ * @param outbws          V2FConv output (F2VConv input) widths
+ * @param blockSizes      SZx block sizes (empty: no SZx points)
+ * @param errorBounds     SZx error bounds, relative to the value range of each dataset
+ * @param clockMHz        clock for the bandwidth column, one element per cycle
+ */
+case class SweepConfig(coefficientSets: Seq[Seq[Int]] = Seq(Seq(1), Seq(2, -1), Seq(3, -3, 1), Seq(4, -6, 4, -1)),
+                       packetbws: Seq[Int] = Seq(4),
+                       outbws: Seq[Int] = Seq(128),
+                       blockSizes: Seq[Int] = Seq(64, 128),
+                       errorBounds: Seq[Double] = Seq(1e-3),
+                       clockMHz: Double = 250.0,
+                       threads: Int = Runtime.getRuntime.availableProcessors,
+                       chunkSize: Int = 1 << 20)
+
+/**
+ * One point of a sweep. The parameters that do not apply to the codec are None.
+ *
+ * @param bits         compressed size of the dataset
+ * @param datapathBits width of the widest datapath value (the Lagrange residual for LPE)
+ * @param bufferBits   packing buffer bits (V2FConv: 2 banks + output register; SZx: one block)
+ */
+case class DSEPoint(dataset: String, codec: String, coefficients: Option[Seq[Int]], scheme: String,
+                    packetbw: Option[Int], outbw: Option[Int], blockSize: Option[Int], errorBound: Option[Double],
+                    elements: Long, bits: Long, datapathBits: Int, bufferBits: Option[Long], clockMHz: Double) {
+  def cr: Double = 32.0 * elements / bits
+  def bitsPerElement: Double = bits.toDouble / elements
+  /** compressed output bandwidth at one element per cycle */
+  def bandwidthGBs: Double = bitsPerElement / 8 * clockMHz * 1e6 / 1e9
+
+  // (column, value); None is an empty CSV field or a JSON null, Left is a string
+  def fields: Seq[(String, Option[Either[String, String]])] = Seq(
+    "dataset" -> Some(Left(dataset)),
+    "codec" -> Some(Left(codec)),
+    "coefficients" -> coefficients.map(c => Left(c.mkString(","))),
+    "scheme" -> Some(Left(scheme)),
+    "packetbw" -> packetbw.map(v => Right(v.toString)),
+    "outbw" -> outbw.map(v => Right(v.toString)),
+    "block_size" -> blockSize.map(v => Right(v.toString)),
+    "error_bound" -> errorBound.map(v => Right(v.toString)),
+    "elements" -> Some(Right(elements.toString)),
+    "bits" -> Some(Right(bits.toString)),
+    "cr" -> Some(Right(f"$cr%.6f")),
+    "bits_per_element" -> Some(Right(f"$bitsPerElement%.6f")),
+    "bandwidth_gbs" -> Some(Right(f"$bandwidthGBs%.6f")),
+    "datapath_bits" -> Some(Right(datapathBits.toString)),
+    "buffer_bits" -> bufferBits.map(v => Right(v.toString)))
+}
+
+object DSESweep {
+  import LPECompEstimateCR._
+
+  /** read a .npy (or raw dtype) file into an integerized dataset */
+  def load(filename: String, dtype: String = "<f4"): Try[Dataset] = {
+    val array = if (filename.endsWith(".npy")) NumpyReader.open(filename) else NumpyReader.openRaw(filename, dtype)
+    array.map { a =>
+      require(a.nbElements <= Int.MaxValue - 8, s"$filename: ${a.nbElements} values are too many for one dataset")
+      val ints = new Array[Int](a.nbElements.toInt)
+      var at = 0
+      a.chunks(NumpyReader.streamChunkSize).foreach { c =>
+        for (i <- c.indices) ints(at + i) = ifp32Forward(java.lang.Float.floatToRawIntBits(c(i)))
+        at += c.length
+      }
+      Dataset(new File(filename).getName, ints)
+    }
+  }
+
+  /**
+   * V2FConv packet model: a 4-bit header in one packet, then ceil(m / packetbw) payload packets for a
+   * residual magnitude of m bits, or all inbw / packetbw of them from 7 packets up
+   */
+  def v2fBits(m: Int, packetbw: Int, inbw: Int): Int = {
+    val n = (m + packetbw - 1) / packetbw
+    packetbw * (1 + (if (n < 7) n else inbw / packetbw))
+  }
+
+  /** V2FConv/F2VConv parameter checks (inbw is the residual width rounded up to packets) */
+  def validV2F(packetbw: Int, outbw: Int, inbw: Int): Boolean =
+    packetbw >= 4 && outbw % packetbw == 0 && common.Utils.isPowOfTwo(outbw) && outbw / packetbw > 3 * (inbw / packetbw)
+
+  /**
+   * Evaluate the grid over the datasets. The expensive passes run chunk-parallel: one residual
+   * histogram per dataset and coefficient set (every header scheme, packetbw and outbw is read from
+   * it), and one SZx pass per dataset, block size and error bound.
+   */
+  def sweep(datasets: Seq[Dataset], config: SweepConfig): Seq[DSEPoint] = {
+    def chunks(d: Dataset, align: Int): Seq[(Int, Int)] = {
+      val size = math.max(align, config.chunkSize / align * align)
+      (0 until d.nbElements by size).map(start => (start, math.min(size, d.nbElements - start)))
+    }
+
+    val lpeKeys = for (d <- datasets.indices; c <- config.coefficientSets.indices) yield (d, c)
+    val lpeTasks = for ((d, c) <- lpeKeys; (start, len) <- chunks(datasets(d), 1)) yield { () =>
+      val h = new ResidualHistogram
+      accumulate(datasets(d).ints, start, start + len, config.coefficientSets(c).toArray, h)
+      ((d, c), h)
+    }
+
+    val szxKeys = for (d <- datasets.indices; b <- config.blockSizes; e <- config.errorBounds) yield (d, b, e)
+    val szxTasks = for ((d, b, e) <- szxKeys; (start, len) <- chunks(datasets(d), b)) yield { () =>
+      val absErrBound = (e * datasets(d).valueRange).toFloat
+      ((d, b, e), SZxSizeModel.blocks(datasets(d).floats(start, len), 0, len, b, absErrBound))
+    }
+
+    datasets.foreach(_.valueRange) // once, before the tasks share it
+    val histograms = parallel(config.threads, lpeTasks).groupMapReduce(_._1)(_._2)(_ add _)
+    val szxBlocks = parallel(config.threads, szxTasks).groupMapReduce(_._1)(_._2)(_ + _)
+
+    val lpePoints = lpeKeys.flatMap { case (d, c) =>
+      val coefficients = config.coefficientSets(c)
+      val h = histograms.getOrElse((d, c), new ResidualHistogram)
+      val n = datasets(d).nbElements
+      val sint = sintNbits(coefficients)
+      val report = CRReport(coefficients, h, 0)
+      val codes = report.schemeBits.map { case (scheme, bits) =>
+        DSEPoint(datasets(d).name, "lpe", Some(coefficients), scheme, None, None, None, None, n, bits, sint, None,
+          config.clockMHz)
+      }
+      val v2f = for (p <- config.packetbws; o <- config.outbws if validV2F(p, o, align(sint, p))) yield {
+        val inbw = align(sint, p)
+        val bits = h.totalMagnitudeBits(v2fBits(_, p, inbw))
+        DSEPoint(datasets(d).name, "lpe", Some(coefficients), "V2F", Some(p), Some(o), None, None, n,
+          (bits + o - 1) / o * o, inbw, Some(3L * o), config.clockMHz)
+      }
+      codes ++ v2f
+    }
+
+    val szxPoints = szxKeys.map { case (d, b, e) =>
+      val blocks = szxBlocks.getOrElse((d, b, e), SZxSizeModel.empty)
+      DSEPoint(datasets(d).name, "szx", None, "SZx", None, None, Some(b), Some(e), datasets(d).nbElements,
+        8 * blocks.totalBytes, 32, Some(32L * b), config.clockMHz)
+    }
+    lpePoints ++ szxPoints
+  }
+
+  def toCSV(points: Seq[DSEPoint]): String = {
+    def cell(v: Option[Either[String, String]]): String = v match {
+      case Some(Left(s)) if s.exists(",\"\n".contains(_)) => "\"" + s.replace("\"", "\"\"") + "\""
+      case Some(Left(s)) => s
+      case Some(Right(s)) => s
+      case None => ""
+    }
+    val header = if (points.isEmpty) "" else points.head.fields.map(_._1).mkString(",") + "\n"
+    header + points.map(_.fields.map(f => cell(f._2)).mkString(",") + "\n").mkString
+  }
+
+  def toJSON(points: Seq[DSEPoint]): String = {
+    def quote(s: String) = "\"" + s.replace("\\", "\\\\").replace("\"", "\\\"") + "\""
+    def value(v: Option[Either[String, String]]): String = v match {
+      case Some(Left(s)) => quote(s)
+      case Some(Right(s)) => s
+      case None => "null"
+    }
+    points.map(_.fields.map { case (k, v) => quote(k) + ": " + value(v) }.mkString("  {", ", ", "}"))
+      .mkString("[\n", ",\n", "\n]\n")
+  }
+
+  def usage(): Unit = {
+    println("Usage: DSESweep -i <input> [-i <input> ...] [options]")
+    println("  -i <file>     dataset (.npy, or raw data of the -t type); read once for all configurations")
+    println("  -t <dtype>    numpy type of raw data (default <f4)")
+    println("  -c <sets>     LagrangePred coefficient sets, e.g. 4,-6,4,-1:3,-3,1 (default 1:2,-1:3,-3,1:4,-6,4,-1)")
+    println("  -p <list>     V2F packetbw values (default 4)")
+    println("  -w <list>     V2F outbw values (default 128)")
+    println("  -b <list>     SZx block sizes, or none (default 64,128)")
+    println("  -e <list>     SZx error bounds relative to the value range (default 1e-3)")
+    println("  -f <MHz>      clock for the bandwidth column (default 250)")
+    println("  -j <threads>  worker threads (default: all cores)")
+    println("  -o <file>     write the table to a .csv or .json file (default: CSV on stdout)")
+  }
+
+  def main(args: Array[String]): Unit = {
+    def ints(v: String): Option[Seq[Int]] =
+      if (v == "none") Some(Seq.empty) else Try(v.split(",").map(_.trim.toInt).toSeq).toOption.filter(_.forall(_ > 0))
+    var inputs = Seq.empty[String]
+    var dtype = "<f4"
+    var output = ""
+    var config = SweepConfig()
+    var ok = true
+    var rest = args.toList
+    while (rest.nonEmpty && ok) {
+      val parsed: Option[SweepConfig] = rest match {
+        case "-i" :: v :: _ => inputs :+= v; Some(config)
+        case "-t" :: v :: _ => dtype = v; Some(config)
+        case "-o" :: v :: _ => output = v; Some(config)
+        case "-c" :: v :: _ =>
+          Try(v.split(":").map(_.split(",").map(_.trim.toInt).toSeq).toSeq).toOption
+            .filter(_.forall(cs => cs.nonEmpty && cs.map(math.abs(_).toLong).sum < (1L << 30)))
+            .map(cs => config.copy(coefficientSets = cs))
+        case "-p" :: v :: _ => ints(v).map(l => config.copy(packetbws = l))
+        case "-w" :: v :: _ => ints(v).map(l => config.copy(outbws = l))
+        case "-b" :: v :: _ => ints(v).map(l => config.copy(blockSizes = l))
+        case "-e" :: v :: _ =>
+          Try(v.split(",").map(_.trim.toDouble).toSeq).toOption.map(l => config.copy(errorBounds = l))
+        case "-f" :: v :: _ => v.toDoubleOption.map(f => config.copy(clockMHz = f))
+        case "-j" :: v :: _ => v.toIntOption.filter(_ > 0).map(j => config.copy(threads = j))
+        case _ => None
+      }
+      parsed match {
+        case Some(c) => config = c; rest = rest.drop(2)
+        case None => ok = false
+      }
+    }
+    if (!ok || inputs.isEmpty) {
+      usage()
+      return
+    }
+
+    val loaded = inputs.map(fn => (fn, load(fn, dtype)))
+    for ((fn, t) <- loaded if t.isFailure) println(s"Error: cannot read $fn: ${t.failed.get.getMessage}")
+    if (loaded.exists(_._2.isFailure)) return
+
+    val t = System.nanoTime()
+    val points = sweep(loaded.map(_._2.get), config)
+    val seconds = (System.nanoTime() - t) * 1e-9
+    val table = if (output.endsWith(".json")) toJSON(points) else toCSV(points)
+    if (output.isEmpty) print(table)
+    else {
+      val w = new PrintWriter(output)
+      try w.write(table) finally w.close()
+      println(f"${points.length} points over ${inputs.length} dataset(s) in $seconds%.2f s, written to $output")
+      val best = points.groupBy(_.codec).map { case (codec, ps) => codec -> ps.maxBy(_.cr) }
+      for ((codec, p) <- best.toSeq.sortBy(_._1)) {
+        println(f"best $codec%-3s CR ${p.cr}%.4f: ${p.dataset} ${p.scheme} " + p.fields.collect {
+          case (k, Some(Right(v))) if Seq("packetbw", "outbw", "block_size", "error_bound").contains(k) => s"$k=$v"
+          case ("coefficients", Some(Left(v))) => s"coefficients=$v"
+        }.mkString(" "))
+      }
+    }
+  }
+}
@@ -3,15 +3,83 @@
 
 package estimate
 
+import common.{NpyArray, NumpyReader}
+import java.util.concurrent.Executors
+import scala.concurrent.duration.Duration
+import scala.concurrent.{Await, ExecutionContext, Future}
+import scala.util.Try
+
+/**
+ * Bit lengths of the Lagrange residuals of a stream, split by sign. The length is BigInt.bitLength
+ * (no sign bit). Every code model is a function of it, so one pass over the data gives all of them.
+ * negativeMagnitude counts the bit lengths of -r of the negative residuals r instead, for the
+ * sign-magnitude packets of V2FConv.
+ */
+class ResidualHistogram {
+  val nonNegative = new Array[Long](65)
+  val negative = new Array[Long](65)
+  val negativeMagnitude = new Array[Long](65)
+
+  def count: Long = nonNegative.sum + negative.sum
+
+  def add(other: ResidualHistogram): ResidualHistogram = {
+    for (l <- 0 to 64) {
+      nonNegative(l) += other.nonNegative(l)
+      negative(l) += other.negative(l)
+      negativeMagnitude(l) += other.negativeMagnitude(l)
+    }
+    this
+  }
+
+  /** total bits when a residual of bit length l takes bits(l) */
+  def totalBits(bits: Int => Int): Long = (0 to 64).map(l => (nonNegative(l) + negative(l)) * bits(l)).sum
+
+  /** total bits when a residual whose magnitude has bit length m takes bits(m) */
+  def totalMagnitudeBits(bits: Int => Int): Long =
+    (0 to 64).map(m => (nonNegative(m) + negativeMagnitude(m)) * bits(m)).sum
+
+  // ideal: the bit length, plus a sign bit for the negative residuals
+  def idealBits: Long = totalBits(l => l) + negative.sum
+  private def idealLengths = (0 to 64).filter(nonNegative(_) > 0) ++ (0 to 64).filter(negative(_) > 0).map(_ + 1)
+  def minIdealBits: Int = idealLengths.minOption.getOrElse(0)
+  def maxIdealBits: Int = idealLengths.maxOption.getOrElse(0)
+}
+
+/**
+ * A header scheme: bits(l, fullBits) is the coded size of a residual of bit length l, where fullBits
+ * is the size of a full-width packet (sint_nbits rounded up to 4 bits)
+ */
+case class CodeScheme(name: String, bits: (Int, Int) => Int)
+
+/**
+ * Compression ratio of one coefficient set over one stream of 32-bit values
+ *
+ * @param seconds wall time of the estimate
+ */
+case class CRReport(coefficients: Seq[Int], histogram: ResidualHistogram, seconds: Double) {
+  import LPECompEstimateCR._
+
+  val nbElements: Long = histogram.count
+  val origBits: Long = 32L * nbElements
+  val fullBits: Int = sint_size_aligned(sintNbits(coefficients), 4)
+
+  /** (name, total bits) of Ideal and of every code scheme */
+  def schemeBits: Seq[(String, Long)] =
+    ("Ideal", histogram.idealBits) +: codeSchemes.map(s => (s.name, histogram.totalBits(s.bits(_, fullBits))))
+
+  def print(): Unit = {
+    println(s"Elements: $nbElements, coefficients ${coefficients.mkString(",")}, sint_nbits=${sintNbits(coefficients)}")
+    println(s"Nbits: min=${histogram.minIdealBits} max=${histogram.maxIdealBits}")
+    for ((name, bits) <- schemeBits) {
+      println(f"$name%-5s CR: ${origBits.toDouble / bits}%8.4f  (${bits.toDouble / nbElements}%7.3f bits/element)")
+    }
+    if (seconds > 0) println(f"Time: $seconds%.3f s, ${origBits / 8 / seconds / 1e9}%.3f GB/s")
+  }
+}
+
 object LPECompEstimateCR {
-  import common.IntegerizeFPSpecUtil._
-  import lpe.LagrangePredSpecUtil._
   import lpe.LagrangePredUtil._  // outSIntBits
-  // import java.io._
-  import java.nio._
-  import java.nio.file._
 
-  // XXX: create a class with a class parameter for coefficient
   /*
     0: 1
     1: 2 - 1
@@ -21,50 +89,23 @@ object LPECompEstimateCR {
   val lagrangepred: List[Int] = List(4, -6, 4, -1)
   // val lagrangepred: List[Int] = List(3, -3, 1)
 
-  val sint_nbits = outSIntBits(32, lagrangepred) // bit length required to a result form Lagrange coding
+  def sintNbits(coefficients: Seq[Int]): Int = outSIntBits(32, coefficients) // bit length of a Lagrange residual
+  val sint_nbits = sintNbits(lagrangepred)
   def sint_size_aligned(v: Int, d:Int) : Int = if( (v%d)==0) v else ((v/d)+1)*d
   val sint_nbits_4b = sint_size_aligned(sint_nbits, 4)
 
-  def readFile(fn: String): List[Float] = {
-    val bytes = Files.readAllBytes(Paths.get(fn))
-    val buf = ByteBuffer.wrap(bytes)
-    buf.order(ByteOrder.LITTLE_ENDIAN)
-    val n = bytes.length / 4
-    val fparray = new Array[Float](n)
-    var i = 0
-    while (buf.hasRemaining && i < n) {
-      fparray(i) = buf.getFloat
-      i += 1
-    }
-    fparray.toList
-  }
-
+  val defaultChunkSize = 1 << 22 // values per parallel task
 
-  // forward Lagrange encoding
-  def forwardLP(data: List[Float]): List[BigInt] = {
-    val databin: List[BigInt] = data
-      .map(convFloat2Bin) // convert Float into binary using BigInt as storage
-      .map(ifp32Forward) // IntegerizedFP
+  // IntegerizedFP on the raw float bits (as IntegerizeFPSpecUtil.ifp32Forward/Backward)
+  def ifp32Forward(bits: Int): Int = if (bits < 0) ~bits else bits | 0x80000000
+  def ifp32Backward(v: Int): Int = if (v < 0) v & 0x7fffffff else ~v
 
-    performLagrangeForward(databin)
-  }
-
-  // backward Lagrange encoding
-  def backwardLP(lpenc: List[BigInt]): List[Float] = {
-    val lpdec: List[BigInt] = performLagrangeBackward(lpenc)
-    lpdec
-      .map(ifp32Backward)
-      .map(convBin2Float)
-  }
-
-  // this function simply returns the minimum length of bits required to store v
-  def idealBitLength(v: BigInt): Int = {
-    if (v < 0) v.bitLength + 1 // bitLength does not include the sign bit
-    else v.bitLength
-  }
+  def integerize(data: Array[Float]): Array[Int] =
+    data.map(f => ifp32Forward(java.lang.Float.floatToRawIntBits(f)))
 
   //
   // coding below perform coding on every single input; no grouping
+  // l is the bit length of the residual (BigInt.bitLength: unsigned len)
   //
   def align(n: Int, align: Int) : Int = {
     if (align<1) return 0
@@ -73,32 +114,28 @@ object LPECompEstimateCR {
     aligned_n * align
   }
 
-  def code0BitLength(v: BigInt): Int = {
-    val l = v.bitLength // unsigned len
+  def code0Bits(l: Int, fullBits: Int): Int = {
     // assume 4-bit packing granularity
     // 1-bit for sign
     // 6-bit for length (up to 36 bits)
     align(1 + 6 + l, 1)
   }
 
-  def code1BitLength(v: BigInt) : Int = {
-    val l = v.bitLength // unsigned len
+  def code1Bits(l: Int, fullBits: Int) : Int = {
     // assume 3-bit packing granularity
     // 3-bit header. bit0=sign, bit12: 00 -> no data, 01 -> 4 bit, 10 -> 8 bit, 11 -> 36 bit
-    val dsz = if (l == 0) 0 else if (l <=3 ) 3 else if (l <=9) 9 else sint_nbits_4b
+    val dsz = if (l == 0) 0 else if (l <=3 ) 3 else if (l <=9) 9 else fullBits
     align(3 + dsz, 3)
   }
 
-  def code2BitLength(v: BigInt): Int = {
-    val l = v.bitLength // unsigned len
+  def code2Bits(l: Int, fullBits: Int): Int = {
     // assume 2-bit packing granularity
     // 2-bit header. bit0=sign, bit1: 0 -> 4 bit, 1-> 36 bit
-    val dsz = if (l <= 4) 4 else sint_nbits_4b
+    val dsz = if (l <= 4) 4 else fullBits
     align(2 + dsz, 2)
   }
 
-  def code3BitLength(v: BigInt): Int = {
-    val l = v.bitLength // unsigned len
+  def code3Bits(l: Int, fullBits: Int): Int = {
     // assume 4-bit packing granularity
     // 4-bit header. bit3=~sign, bit2-0: 000 => lit0, 001 .. 111 (1-7
     // header: 0000 => distinguish from literal 0
@@ -108,49 +145,187 @@ object LPECompEstimateCR {
     //         0001 => negative one packet
     //         0110 => nagative 6 packets
     //         0111 => negative full packets
-    val dsz = if (v == 0) 0 // literal 0
+    val dsz = if (l == 0) 0 // literal 0 (and -1, whose bit length is 0 as well)
     else if (l/4 < 7) align(l,4) // 1 to 6 packets follow (4 to 24 bits)
-    else sint_nbits_4b  // 7: the entire length. 9 packets with 36 bits data
+    else fullBits  // 7: the entire length. 9 packets with 36 bits data
 
     val nbits = align(4 + dsz, 4)
     nbits
   }
 
-  def checkCompAndDecomp(data: List[Float]): Boolean = {
-    val lpenc = forwardLP(data)
+  val codeSchemes: Seq[CodeScheme] =
+    Seq(CodeScheme("Code0", code0Bits), CodeScheme("Code1", code1Bits), CodeScheme("Code2", code2Bits),
+      CodeScheme("Code3", code3Bits))
 
-    val TotalOrigBits = data.length * 32  // 32 bits
-    val idealBits = lpenc.map(idealBitLength)
-    val code0Bits = lpenc.map(code0BitLength)
-    val code1Bits = lpenc.map(code1BitLength)
-    val code2Bits = lpenc.map(code2BitLength)
-    val code3Bits = lpenc.map(code3BitLength)
+  // this function simply returns the minimum length of bits required to store v
+  def idealBitLength(v: Long): Int = bitLength(v) + (if (v < 0) 1 else 0)
 
-    println(s"Nbits: min=${idealBits.min} max=${idealBits.max}")
-    println(s"Ideal CR: ${TotalOrigBits.toFloat / idealBits.sum.toFloat}")
-    println(s"Code0 CR: ${TotalOrigBits.toFloat / code0Bits.sum.toFloat}")
-    println(s"Code1 CR: ${TotalOrigBits.toFloat / code1Bits.sum.toFloat}")
-    println(s"Code2 CR: ${TotalOrigBits.toFloat / code2Bits.sum.toFloat}")
-    println(s"Code3 CR: ${TotalOrigBits.toFloat / code3Bits.sum.toFloat}")
+  def bitLength(v: Long): Int = 64 - java.lang.Long.numberOfLeadingZeros(v ^ (v >> 63))
 
-    val recovered = backwardLP(lpenc)
-    if (!data.sameElements(recovered)) { // sanity check
-      println("Error: recovered data did not match with the original")
-      false
+  /** the Lagrange prediction of ints(i) from the values before it (zeros before index 0), all unsigned */
+  @inline private def prediction(ints: Array[Int], i: Int, c: Array[Int]): Long = {
+    var pred = 0L
+    var k = 0
+    while (k < c.length && k < i) {
+      pred += c(k) * (ints(i - 1 - k) & 0xffffffffL)
+      k += 1
     }
-    true
+    pred
+  }
+
+  @inline private def residual(ints: Array[Int], i: Int, c: Array[Int]): Long =
+    (ints(i) & 0xffffffffL) - prediction(ints, i, c)
+
+  /**
+   * Add the residuals of ints(start until end) to hist, in one pass. The predictor state is the
+   * coefficients.length values before start, which are read from ints (zeros before index 0);
+   * this is how a chunk carries the state of the one before it.
+   */
+  def accumulate(ints: Array[Int], start: Int, end: Int, coefficients: Array[Int], hist: ResidualHistogram): Unit = {
+    val nonNegative = hist.nonNegative
+    val negative = hist.negative
+    val negativeMagnitude = hist.negativeMagnitude
+    var i = start
+    while (i < end) {
+      val r = residual(ints, i, coefficients)
+      val l = bitLength(r)
+      if (r < 0) {
+        negative(l) += 1
+        negativeMagnitude(bitLength(-r)) += 1
+      } else nonNegative(l) += 1
+      i += 1
+    }
+  }
+
+  /**
+   * Forward and backward Lagrange coding of ints(start until end) with 64-bit arithmetic (exact for
+   * coefficients with less than 2^30 in total magnitude); the decoder starts from the same history.
+   */
+  def roundTrip(ints: Array[Int], start: Int, end: Int, coefficients: Array[Int]): Boolean = {
+    val res = Array.tabulate(end - start)(j => residual(ints, start + j, coefficients))
+    val dec = new Array[Int](end)
+    Array.copy(ints, 0, dec, 0, start) // the history
+    res.indices.forall { j =>
+      val v = res(j) + prediction(dec, start + j, coefficients)
+      dec(start + j) = v.toInt
+      v == (ints(start + j) & 0xffffffffL)
+    }
+  }
+
+  /** run the tasks on a pool of threads and return their results in order */
+  def parallel[T](threads: Int, tasks: Seq[() => T]): Seq[T] = {
+    val pool = Executors.newFixedThreadPool(math.max(1, threads))
+    implicit val ec: ExecutionContext = ExecutionContext.fromExecutorService(pool)
+    try Await.result(Future.sequence(tasks.map(t => Future(t()))), Duration.Inf)
+    finally pool.shutdown()
+  }
+
+  /** residual histogram of integerized values, chunk-parallel */
+  def histogram(ints: Array[Int], coefficients: Seq[Int], threads: Int = Runtime.getRuntime.availableProcessors,
+                chunkSize: Int = defaultChunkSize): ResidualHistogram = {
+    val c = coefficients.toArray
+    val tasks = (0 until ints.length by chunkSize).map { start => () =>
+      val h = new ResidualHistogram
+      accumulate(ints, start, math.min(start + chunkSize, ints.length), c, h)
+      h
+    }
+    parallel(threads, tasks).foldLeft(new ResidualHistogram)(_ add _)
+  }
+
+  def estimate(data: Array[Float], coefficients: Seq[Int]): CRReport = {
+    val t = System.nanoTime()
+    val h = histogram(integerize(data), coefficients)
+    CRReport(coefficients, h, (System.nanoTime() - t) * 1e-9)
+  }
+
+  /**
+   * Streaming estimate of a mapped array of any size: each task reads its chunk plus the predictor
+   * history before it, so at most threads chunks are in memory. With verify, every chunk is also
+   * decoded and compared; the result is None if one differs.
+   */
+  def estimate(array: NpyArray, coefficients: Seq[Int], threads: Int, chunkSize: Int,
+               verify: Boolean): Option[CRReport] = {
+    val t = System.nanoTime()
+    val c = coefficients.toArray
+    val tasks = (0L until array.nbElements by chunkSize.toLong).map { start => () =>
+      val hlen = math.min(c.length.toLong, start).toInt
+      val len = math.min(chunkSize.toLong, array.nbElements - start).toInt
+      val buf = new Array[Float](hlen + len)
+      array.read(start - hlen, buf, 0, buf.length)
+      val ints = integerize(buf)
+      val h = new ResidualHistogram
+      // the first hlen values are the predictor state carried over from the chunk before (none for the first)
+      accumulate(ints, hlen, ints.length, c, h)
+      val ok = !verify || (roundTrip(ints, hlen, ints.length, c) &&
+        (hlen until ints.length).forall(i => ifp32Backward(ints(i)) == java.lang.Float.floatToRawIntBits(buf(i))))
+      (h, ok)
+    }
+    val results = parallel(threads, tasks)
+    if (results.forall(_._2)) {
+      Some(CRReport(coefficients, results.foldLeft(new ResidualHistogram)(_ add _._1), (System.nanoTime() - t) * 1e-9))
+    } else None
+  }
+
+  def usage(): Unit = {
+    println("Usage: LPECompEstimateCR -i <input> [options]  (no arguments: run on synthetic data)")
+    println("  -i <file>     input file (.npy, or raw data of the -t type)")
+    println("  -t <dtype>    numpy type of raw data, e.g. <f4, <f8, <u2 (default <f4); values are taken as float32")
+    println("  -c <list>     predictor coefficients, comma separated (default 4,-6,4,-1)")
+    println("  -j <threads>  worker threads (default: all cores)")
+    println("  -b <values>   values per chunk (default 4194304)")
+    println("  -V            also check that every chunk decodes back to the input")
   }
 
   def main(args: Array[String]): Unit = {
-    val n = 1000
-    val t1 = List.tabulate(n) { i => 1.0f + i.toFloat / n.toFloat } ::: List.fill(n/10)(0f)
-    val t2 = List.tabulate(n) { i => math.sin(math.Pi * (i.toDouble/n.toDouble)).toFloat }  ::: List.fill(n/10)(0f)
-    println(f"sint_nbits=${sint_nbits}")
+    if (args.isEmpty) {
+      val n = 1000
+      val t1 = Array.tabulate(n) { i => 1.0f + i.toFloat / n.toFloat } ++ Array.fill(n/10)(0f)
+      val t2 = Array.tabulate(n) { i => math.sin(math.Pi * (i.toDouble/n.toDouble)).toFloat } ++ Array.fill(n/10)(0f)
+      println(f"sint_nbits=${sint_nbits}")
+      estimate(t1, lagrangepred).print()
+      estimate(t2, lagrangepred).print()
+      return
+    }
 
-    checkCompAndDecomp(t1)
-    checkCompAndDecomp(t2)
+    var input = ""
+    var dtype = "<f4"
+    var coefficients: Seq[Int] = lagrangepred
+    var threads = Runtime.getRuntime.availableProcessors
+    var chunkSize = defaultChunkSize
+    var verify = false
+    var ok = true
+    var rest = args.toList
+    while (rest.nonEmpty && ok) {
+      rest match {
+        case "-i" :: v :: tl => input = v; rest = tl
+        case "-t" :: v :: tl => dtype = v; rest = tl
+        case "-c" :: v :: tl => Try(v.split(",").map(_.trim.toInt).toSeq).toOption match {
+          case Some(cs) if cs.nonEmpty && cs.map(math.abs(_).toLong).sum < (1L << 30) => coefficients = cs; rest = tl
+          case _ => ok = false
+        }
+        case "-j" :: v :: tl => threads = v.toIntOption.getOrElse(0); rest = tl
+        case "-b" :: v :: tl => chunkSize = v.toIntOption.getOrElse(0); rest = tl
+        case "-V" :: tl => verify = true; rest = tl
+        case _ => ok = false
+      }
+    }
+    if (!ok || input.isEmpty || threads <= 0 || chunkSize <= 0) {
+      usage()
+      return
+    }
 
-    //val t3 = readFile("a.dat")
-    //checkCompAndDecomp(t3)
+    val array = if (input.endsWith(".npy")) NumpyReader.open(input) else NumpyReader.openRaw(input, dtype)
+    if (array.isFailure) {
+      println(s"Error: cannot read $input: ${array.failed.get.getMessage}")
+      return
+    }
+    println(s"$input: ${array.get.header.dataType}, ${array.get.nbElements} values, $threads threads")
+    estimate(array.get, coefficients, threads, chunkSize, verify) match {
+      case Some(report) =>
+        report.print()
+        if (verify) println("Round trip: exact")
+      case None =>
+        println("Error: recovered data did not match with the original")
+    }
   }
 }
@@ -0,0 +1,81 @@
+// See LICENSE.txt in the project root for license information.
+// Author: SZx compressed size model for StreamPressor
+
+package estimate
+
+/**
+ * Size of the SZxLite compressed stream of float32 data (SZx_compress_float), without producing it:
+ * the block statistics and the leading-byte counts of the C code, so the size is exact to the byte.
+ */
+object SZxSizeModel {
+
+  /** block counts and non-constant block bytes of a range of blocks; ranges add up */
+  case class Blocks(constant: Long, nonConstant: Long, nonConstantBytes: Long) {
+    def +(o: Blocks): Blocks =
+      Blocks(constant + o.constant, nonConstant + o.nonConstant, nonConstantBytes + o.nonConstantBytes)
+
+    def nbBlocks: Long = constant + nonConstant
+
+    /** the whole stream: header, non-constant block sizes, state bits, constant medians and block data */
+    def totalBytes: Long = 4 + 2 * 8 + 2 * nonConstant + (nbBlocks + 7) / 8 + 4 * constant + nonConstantBytes
+  }
+
+  val empty: Blocks = Blocks(0, 0, 0)
+
+  private def exponent(f: Float): Int = ((java.lang.Float.floatToRawIntBits(f) & 0x7f800000) >> 23) - 127
+  private def exponent(d: Double): Int = ((java.lang.Double.doubleToRawLongBits(d) >>> 52) & 0x7ff).toInt - 1023
+
+  /** bytes of the non-constant block data(off until off + n), as SZx_compress_one_block_float */
+  def nonConstantBlockBytes(data: Array[Float], off: Int, n: Int, absErrBound: Float, medianValue: Float,
+                            radius: Float): Int = {
+    var median = medianValue
+    var reqLength = 9 + exponent(radius) - exponent(absErrBound.toDouble) + 1
+    if (reqLength < 9) reqLength = 9
+    if (reqLength > 32) {
+      reqLength = 32
+      median = 0f
+    }
+    val resiBits = reqLength % 8
+    val reqBytes = reqLength / 8 + (if (resiBits != 0) 1 else 0)
+    val rightShift = if (resiBits != 0) 8 - resiBits else 0
+
+    var midBytes = 0
+    var pre = 0
+    for (i <- off until off + n) {
+      val cur = java.lang.Float.floatToRawIntBits(data(i) - median) >> rightShift
+      val x = cur ^ pre
+      val leadingNum = if ((x >> 8) == 0) 3 else if ((x >> 16) == 0) 2 else if ((x >> 24) == 0) 1 else 0
+      midBytes += math.max(0, reqBytes - leadingNum)
+      pre = cur
+    }
+    1 + 4 + (n + 3) / 4 + midBytes // reqLength, median, 2-bit leading numbers, mid bytes
+  }
+
+  /**
+   * The blocks of data(off until off + len); every block is blockSize values but the last one.
+   * A block is constant when half its value range is within absErrBound.
+   */
+  def blocks(data: Array[Float], off: Int, len: Int, blockSize: Int, absErrBound: Float): Blocks = {
+    var constant = 0L
+    var nonConstant = 0L
+    var bytes = 0L
+    for (start <- off until off + len by blockSize) {
+      val n = math.min(blockSize, off + len - start)
+      var min = data(start)
+      var max = data(start)
+      for (j <- start + 1 until start + n) {
+        val v = data(j)
+        if (min > v) min = v
+        else if (max < v) max = v
+      }
+      val radius = (max - min) / 2
+      val median = min + radius
+      if (radius <= absErrBound) constant += 1
+      else {
+        nonConstant += 1
+        bytes += nonConstantBlockBytes(data, start, n, absErrBound, median, radius)
+      }
+    }
+    Blocks(constant, nonConstant, bytes)
+  }
+}
@@ -111,15 +111,13 @@ object LagrangePredSpecUtil {
     val padding: List[BigInt] = List.fill(lagrangepred.length)(0)
     val nlagragepred = lagrangepred.length
 
-    def helper(diffs: List[BigInt], recovered: List[BigInt]) : List[BigInt] = {
-      if (diffs.length == 0) recovered
-      else {
-        val ln = recovered.takeRight(nlagragepred)
-        val r = ln.zip(lagrangepred.reverse).map { case(a, b) => a * b }.sum + diffs.head
-        helper(diffs.tail, recovered ::: List(r))
-      }
+    // appending to an ArrayBuffer keeps this linear; recovered ::: List(r) was O(n^2)
+    val recovered = scala.collection.mutable.ArrayBuffer[BigInt](padding: _*)
+    for (d <- diffs) {
+      val ln = recovered.takeRight(nlagragepred)
+      recovered += ln.zip(lagrangepred.reverse).map { case(a, b) => a * b }.sum + d
     }
-    helper(diffs, padding).drop(nlagragepred)
+    recovered.drop(nlagragepred).toList
   }
 
   def main(args: Array[String]): Unit = {
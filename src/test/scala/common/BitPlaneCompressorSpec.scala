@@ -0,0 +1,77 @@
+// See LICENSE.txt in the project root for license information.
+// Author: BitPlaneCompressor Test
+
+package common
+
+import org.scalatest.flatspec.AnyFlatSpec
+import org.scalatest.matchers.should.Matchers
+
+import scala.util.Random
+
+class BitPlaneCompressorSpec extends AnyFlatSpec with Matchers {
+
+  val rnd = new Random(22)
+
+  // mostly small values with a few large ones, so some bit planes are zero
+  def sparseData(n: Int): Array[Int] = Array.fill(n) {
+    if (rnd.nextInt(8) == 0) rnd.nextInt() else rnd.nextInt(1 << 10)
+  }
+
+  "BitPlaneCompressor" should "transpose a 32x32 bit matrix" in {
+    val a = Array.fill(32)(rnd.nextInt())
+    val t = a.clone()
+    BitPlaneCompressor.transpose32(t, 0)
+    for (p <- 0 until 32; i <- 0 until 32) {
+      ((t(p) >>> i) & 1) shouldBe ((a(i) >>> p) & 1)
+    }
+    BitPlaneCompressor.transpose32(t, 0)
+    t shouldBe a
+  }
+
+  it should "pack bit p of value i into bit i % 32 of word i / 32 of plane p" in {
+    val data = sparseData(100)
+    val wpp = BitPlaneCompressor.wordsPerPlane(data.length)
+    val planes = BitPlaneCompressor.packBitPlanes(data)
+    planes.length shouldBe 32 * wpp
+    for (p <- 0 until 32; i <- data.indices) {
+      ((planes(p * wpp + i / 32) >>> (i % 32)) & 1) shouldBe ((data(i) >>> p) & 1)
+    }
+    BitPlaneCompressor.unpackBitPlanes(planes, data.length) shouldBe data
+  }
+
+  it should "round trip through compress and decompress" in {
+    for (n <- Seq(1, 31, 32, 33, 1000, 4097)) {
+      val data = sparseData(n)
+      val (compressed, metadata) = BitPlaneCompressor.compress(data)
+      compressed.length shouldBe metadata.nonZeroBitPlaneIndices.length * BitPlaneCompressor.wordsPerPlane(n)
+      BitPlaneCompressor.decompress(compressed, metadata) shouldBe data
+    }
+  }
+
+  it should "keep the length of all-zero data" in {
+    val (compressed, metadata) = BitPlaneCompressor.compress(new Array[Int](40))
+    compressed shouldBe empty
+    metadata.nonZeroBitPlaneIndices shouldBe empty
+    BitPlaneCompressor.decompress(compressed, metadata) shouldBe new Array[Int](40)
+  }
+
+  it should "keep the non-zero words of bit-shuffled data" in {
+    for (n <- Seq(1, 32, 33, 1000)) {
+      val shuffled = BitShuffleUtils.shuffle(sparseData(n))
+      val (compressed, metadata) = BitPlaneCompressor.compressPlanes(shuffled)
+      compressed shouldBe shuffled.filter(_ != 0)
+      metadata.nonZeroBitPlaneIndices shouldBe shuffled.indices.filter(shuffled(_) != 0).toArray
+      BitPlaneCompressor.decompressPlanes(compressed, metadata) shouldBe shuffled
+    }
+  }
+
+  it should "count the set bits of each plane" in {
+    val data = sparseData(500)
+    val analysis = BitPlaneCompressor.analyzeBitPlaneSparsity(data)
+    analysis.totalNonZeroBits shouldBe data.map(Integer.bitCount).sum
+    for (p <- 0 until 32) {
+      val ones = data.count(v => ((v >>> p) & 1) == 1)
+      analysis.sparsityByPlane(p) shouldBe (1.0 - ones.toDouble / data.length) +- 1e-12
+    }
+  }
+}
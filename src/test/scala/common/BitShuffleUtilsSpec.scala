@@ -0,0 +1,56 @@
+// See LICENSE.txt in the project root for license information.
+// Author: BitShuffleUtils Test
+
+package common
+
+import org.scalatest.flatspec.AnyFlatSpec
+import org.scalatest.matchers.should.Matchers
+
+import scala.util.Random
+
+class BitShuffleUtilsSpec extends AnyFlatSpec with Matchers {
+
+  val rnd = new Random(23)
+
+  // out(b) of BitShuffle(values.length, 32), as in BitShuffleSpec
+  def hardwareOut(values: Seq[Int]): Seq[Long] = (0 until 32).map { b =>
+    values.zipWithIndex.map { case (v, j) => ((v >>> b) & 1L) << j }.reduce(_ | _)
+  }
+
+  "BitShuffleUtils" should "give the BitShuffle(32, 32) outputs for each block of 32 values" in {
+    val data = Array.fill(96)(rnd.nextInt())
+    val shuffled = BitShuffleUtils.shuffle(data)
+    for (g <- 0 until 3) {
+      val block = 32 * g until 32 * g + 32
+      block.map(shuffled(_) & 0xffffffffL) shouldBe hardwareOut(block.map(data(_)))
+    }
+  }
+
+  it should "pack two BitShuffle(16, 32) outputs per word for blocks of 16 values" in {
+    val data = Array.fill(16)(rnd.nextInt())
+    val out = hardwareOut(data.toIndexedSeq)
+    val shuffled = BitShuffleUtils.shuffle(data, 16)
+    for (w <- 0 until 16) shuffled(w) shouldBe (out(2 * w) | (out(2 * w + 1) << 16)).toInt
+  }
+
+  it should "put bit b of value j at bit b * n + j of a block of n values" in {
+    for (n <- Seq(5, 64, 100)) {
+      val data = Array.fill(n)(rnd.nextInt())
+      val shuffled = BitShuffleUtils.shuffle(data, n)
+      for (j <- 0 until n; b <- 0 until 32) {
+        val k = b * n + j
+        ((shuffled(k / 32) >>> (k % 32)) & 1) shouldBe ((data(j) >>> b) & 1)
+      }
+    }
+  }
+
+  it should "round trip for any length and block size" in {
+    for (n <- Seq(0, 1, 31, 32, 33, 1000, 4097); blockSize <- Seq(16, 32, 100, 1024)) {
+      val data = Array.fill(n)(rnd.nextInt())
+      val shuffled = BitShuffleUtils.shuffle(data, blockSize)
+      shuffled.length shouldBe n
+      BitShuffleUtils.unshuffle(shuffled, blockSize) shouldBe data
+    }
+    BitShuffleUtils.verifyRoundTrip(Array.fill(100)(rnd.nextInt())) shouldBe true
+  }
+}
@@ -0,0 +1,128 @@
+// See LICENSE.txt in the project root for license information.
+// Author: Pure-JVM NumpyReader Test
+
+package common
+
+import java.io.File
+import java.nio.{ByteBuffer, ByteOrder}
+import java.nio.charset.StandardCharsets
+import java.nio.file.{Files, Paths}
+import org.scalatest.flatspec.AnyFlatSpec
+import org.scalatest.matchers.should.Matchers
+
+class NumpyReaderSpec extends AnyFlatSpec with Matchers {
+
+  // write a .npy file the way numpy does (header padded to a multiple of 64 bytes)
+  def writeNpy(descr: String, shape: Seq[Long], fortran: Boolean, payload: Array[Byte], major: Int = 1): String = {
+    val shapeText = shape.mkString(", ") + (if (shape.length == 1) "," else "")
+    val dict = s"{'descr': '$descr', 'fortran_order': ${if (fortran) "True" else "False"}, 'shape': ($shapeText), }"
+    val preambleLength = if (major == 1) 10 else 12
+    val header = dict + " " * ((64 - (preambleLength + dict.length + 1) % 64) % 64) + "\n"
+    val buf = ByteBuffer.allocate(preambleLength + header.length + payload.length).order(ByteOrder.LITTLE_ENDIAN)
+    buf.put(Array[Int](0x93, 'N', 'U', 'M', 'P', 'Y').map(_.toByte))
+    buf.put(major.toByte)
+    buf.put(0.toByte)
+    if (major == 1) buf.putShort(header.length.toShort) else buf.putInt(header.length)
+    buf.put(header.getBytes(StandardCharsets.ISO_8859_1))
+    buf.put(payload)
+    val file = File.createTempFile("npyreader", ".npy")
+    file.deleteOnExit()
+    Files.write(file.toPath, buf.array())
+    file.getPath
+  }
+
+  def payload(order: ByteOrder, itemSize: Int, n: Int)(put: (ByteBuffer, Int) => Unit): Array[Byte] = {
+    val buf = ByteBuffer.allocate(itemSize * n).order(order)
+    for (i <- 0 until n) put(buf, i)
+    buf.array()
+  }
+
+  "NumpyReader" should "read a float32 C-order array" in {
+    val values = Array.tabulate(6)(_ * 1.5f)
+    val fn = writeNpy("<f4", Seq(2, 3), fortran = false,
+      payload(ByteOrder.LITTLE_ENDIAN, 4, 6)((b, i) => b.putFloat(values(i))))
+
+    val array = NumpyReader.open(fn).get
+    array.header.shape shouldBe Array(2L, 3L)
+    array.header.dataType shouldBe "float32"
+    array.header.fortranOrder shouldBe false
+    array.nbElements shouldBe 6
+    array.toArray shouldBe values
+    array(4) shouldBe 6.0f
+    array.floatBuffer.get(5) shouldBe 7.5f
+  }
+
+  it should "read chunks lazily in order" in {
+    val values = Array.tabulate(10)(_.toFloat)
+    val fn = writeNpy("<f4", Seq(10), fortran = false,
+      payload(ByteOrder.LITTLE_ENDIAN, 4, 10)((b, i) => b.putFloat(values(i))))
+
+    val chunks = NumpyReader.feedNumpyDataInChunks(fn, 4).toList
+    chunks.map(_.length) shouldBe List(4, 4, 2)
+    chunks.flatten.toArray shouldBe values
+    NumpyReader.feedNumpyData(fn).toArray shouldBe values
+  }
+
+  it should "return a Fortran-order array in C order" in {
+    // v(i, j) = 10 * i + j, stored column by column
+    val fortranValues = for (j <- 0 until 3; i <- 0 until 2) yield (10 * i + j).toDouble
+    val fn = writeNpy("<f8", Seq(2, 3), fortran = true,
+      payload(ByteOrder.LITTLE_ENDIAN, 8, 6)((b, i) => b.putDouble(fortranValues(i))))
+
+    val array = NumpyReader.open(fn).get
+    array.header.dataType shouldBe "float64"
+    array.toArray shouldBe Array(0f, 1f, 2f, 10f, 11f, 12f)
+    array.chunks(4).flatten.toArray shouldBe Array(0f, 1f, 2f, 10f, 11f, 12f)
+  }
+
+  it should "convert integer dtypes and big-endian payloads" in {
+    val u16 = Array(0, 1, 65535)
+    val fnU16 = writeNpy(">u2", Seq(3), fortran = false,
+      payload(ByteOrder.BIG_ENDIAN, 2, 3)((b, i) => b.putShort(u16(i).toShort)))
+    NumpyReader.readNumpyData(fnU16).get shouldBe Array(0f, 1f, 65535f)
+
+    val fnI16 = writeNpy("<i2", Seq(2), fortran = false,
+      payload(ByteOrder.LITTLE_ENDIAN, 2, 2)((b, i) => b.putShort((-2 * i).toShort)))
+    NumpyReader.readNumpyData(fnI16).get shouldBe Array(0f, -2f)
+
+    val fnU8 = writeNpy("|u1", Seq(2), fortran = false, Array(7.toByte, 255.toByte))
+    NumpyReader.readNumpyData(fnU8).get shouldBe Array(7f, 255f)
+  }
+
+  it should "read format version 2.0 headers" in {
+    val fn = writeNpy("<f4", Seq(1, 2), fortran = false,
+      payload(ByteOrder.LITTLE_ENDIAN, 4, 2)((b, i) => b.putFloat(i + 0.5f)), major = 2)
+    NumpyReader.readNumpyData(fn).get shouldBe Array(0.5f, 1.5f)
+  }
+
+  it should "reject files it cannot read" in {
+    val notNpy = File.createTempFile("npyreader", ".npy")
+    notNpy.deleteOnExit()
+    Files.write(notNpy.toPath, Array.fill(64)(1.toByte))
+    NumpyReader.open(notNpy.getPath).isFailure shouldBe true
+
+    val complex = writeNpy("<c8", Seq(1), fortran = false, new Array[Byte](8))
+    NumpyReader.open(complex).isFailure shouldBe true
+
+    val truncated = writeNpy("<f4", Seq(4), fortran = false, new Array[Byte](8))
+    NumpyReader.open(truncated).isFailure shouldBe true
+  }
+
+  it should "read the X-ray data file" in {
+    val filename = "test_data/25-trimmed.npy"
+
+    val array = NumpyReader.open(filename).get
+    array.header.shape shouldBe Array(2L, 128L, 128L)
+    array.header.dataType shouldBe "float32"
+
+    // the payload decoded directly from the file bytes
+    val bytes = ByteBuffer.wrap(Files.readAllBytes(Paths.get(filename))).order(ByteOrder.LITTLE_ENDIAN)
+    val expected = Array.tabulate(32768)(i => bytes.getFloat(array.header.dataOffset.toInt + 4 * i))
+    array.toArray shouldBe expected
+    array.chunks(1000).flatten.toArray shouldBe expected
+
+    val stats = NumpyReader.getDataStats(filename).get
+    stats.totalElements shouldBe 32768
+    stats.nonZeroCount shouldBe 12371
+  }
+}
@@ -9,11 +9,26 @@ import scala.util.{Try, Success, Failure}
 
 /**
  * Test the complete X-ray compression pipeline:
- * .npy file → reader → feeder → bit shuffling → run-length encoding → V2F → F2V → output
+ * .npy file → reader → feeder → bit shuffling → zero suppression → V2F → F2V → output
  */
 class XRayCompressionPipelineSpec extends AnyFlatSpec with Matchers {
   
   val filename = "test_data/25-trimmed.npy"
+
+  // BitShuffleUtils.shuffle's layout: in the block of n values at s (32 but for the last one), bit b of value s + j
+  // is bit k % 32 of word s + k / 32, with k = b * n + j
+  def checkBitShuffled(values: Array[Int], shuffled: Array[Int]): Unit = {
+    shuffled.length shouldBe values.length
+    for (s <- values.indices by 32) {
+      val n = math.min(32, values.length - s)
+      for (j <- 0 until n; b <- 0 until 32) {
+        val k = b * n + j
+        if (((shuffled(s + k / 32) >>> (k % 32)) & 1) != ((values(s + j) >>> b) & 1)) {
+          fail(s"bit $b of value ${s + j} is not bit ${k % 32} of shuffled word ${s + k / 32}")
+        }
+      }
+    }
+  }
   
   "X-Ray Compression Pipeline" should "process data through complete pipeline" in {
     
@@ -34,11 +49,13 @@ class XRayCompressionPipelineSpec extends AnyFlatSpec with Matchers {
     println("Step 3: Applying bit shuffling...")
     val bitShuffled = BitShuffleUtils.shuffle(uint32Data)
     println(s"Bit shuffled ${bitShuffled.length} elements")
+    checkBitShuffled(uint32Data, bitShuffled)
     
-    // Step 4: Apply bit plane compression (length calculation + zero suppression)
-    println("Step 4: Applying bit plane compression...")
-    val (compressedData, metadata) = BitPlaneCompressor.compress(bitShuffled)
-    println(s"Bit plane compressed to ${compressedData.length} bits")
+    // Step 4: Apply zero suppression to the bit planes of the shuffled blocks
+    println("Step 4: Applying bit plane zero suppression...")
+    val (compressedData, metadata) = BitPlaneCompressor.compressPlanes(bitShuffled)
+    println(s"Bit plane compressed to ${compressedData.length} words")
+    compressedData shouldBe bitShuffled.filter(_ != 0)
     
     // Step 5: Convert to float (V2F)
     println("Step 5: Converting to float (V2F)...")
@@ -52,13 +69,15 @@ class XRayCompressionPipelineSpec extends AnyFlatSpec with Matchers {
     
     // Step 7: Decompress bit planes
     println("Step 7: Decompressing bit planes...")
-    val decompressedData = BitPlaneCompressor.decompress(f2vConverted, metadata)
+    val decompressedData = BitPlaneCompressor.decompressPlanes(f2vConverted, metadata)
     println(s"Bit plane decompressed to ${decompressedData.length} elements")
+    decompressedData shouldBe bitShuffled
     
     // Step 8: Reverse bit shuffling
     println("Step 8: Reversing bit shuffling...")
     val bitUnshuffled = BitShuffleUtils.unshuffle(decompressedData)
     println(s"Bit unshuffled to ${bitUnshuffled.length} elements")
+    bitUnshuffled shouldBe uint32Data
     
     // Step 9: Convert back to float
     println("Step 9: Converting back to float...")
@@ -69,10 +88,9 @@ class XRayCompressionPipelineSpec extends AnyFlatSpec with Matchers {
     println("Step 10: Verifying reconstruction...")
     reconstructedData.length shouldBe data.length
     
-    // Check that the data matches (allowing for floating point precision)
-    val tolerance = 1e-6f
+    // The pipeline is lossless: every value comes back bit for bit
     val mismatches = data.zip(reconstructedData).count { case (original, reconstructed) =>
-      math.abs(original - reconstructed) > tolerance
+      java.lang.Float.floatToRawIntBits(original) != java.lang.Float.floatToRawIntBits(reconstructed)
     }
     
     println(s"Found $mismatches mismatches out of ${data.length} elements")
@@ -122,13 +140,14 @@ class XRayCompressionPipelineSpec extends AnyFlatSpec with Matchers {
     val originalData = NumpyReaderScalaPy.readNumpyData(filename).get
     val originalSize = originalData.length * 4 // 4 bytes per float
     
-    // Apply compression pipeline with bit plane compression
+    // Apply compression pipeline: bit shuffling, then zero suppression of the shuffled bit planes
     val uint32Data = originalData.map(java.lang.Float.floatToRawIntBits)
     val bitShuffled = BitShuffleUtils.shuffle(uint32Data)
-    val (compressedData, metadata) = BitPlaneCompressor.compress(bitShuffled)
+    checkBitShuffled(uint32Data, bitShuffled)
+    val (compressedData, metadata) = BitPlaneCompressor.compressPlanes(bitShuffled)
     
-    // Calculate compression statistics
-    val compressedSize = compressedData.length / 8 // Convert bits to bytes
+    // Calculate compression statistics: the kept words plus a 32-bit mask of the non-zero planes per block
+    val compressedSize = (compressedData.length + (bitShuffled.length + 31) / 32) * 4
     val stats = BitPlaneCompressor.calculateCompressionEffectiveness(originalSize, compressedSize, metadata)
     
     println(s"Original size: $originalSize bytes")
@@ -139,9 +158,14 @@ class XRayCompressionPipelineSpec extends AnyFlatSpec with Matchers {
     println(s"Non-zero bit planes: ${stats.nonZeroBitPlanes}")
     
     // Analyze bit plane sparsity
-    val analysis = BitPlaneCompressor.analyzeBitPlaneSparsity(bitShuffled)
+    val analysis = BitPlaneCompressor.analyzeBitPlaneSparsity(uint32Data)
     println(f"Overall bit plane sparsity: ${analysis.overallSparsity * 100}%.1f%%")
     println(s"Total non-zero bits: ${analysis.totalNonZeroBits}/${analysis.totalBits}")
+    println(s"Zero words after bit shuffling: ${bitShuffled.count(_ == 0)}/${bitShuffled.length}")
+    
+    // The shuffle only moves bits, and each zero word of its output is a suppressed plane
+    bitShuffled.map(Integer.bitCount).sum shouldBe analysis.totalNonZeroBits
+    stats.zeroBitPlanesEliminated shouldBe bitShuffled.count(_ == 0)
     
     // For X-ray data with high zero content, we should see good compression
     stats.compressionRatio should be > 1.0
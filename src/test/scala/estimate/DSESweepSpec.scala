@@ -0,0 +1,98 @@
+// See LICENSE.txt in the project root for license information.
+// Author: DSESweep Test
+
+package estimate
+
+import common.IntegerizeFPSpecUtil._
+import lpe.LagrangePredSpecUtil._
+import org.scalatest.flatspec.AnyFlatSpec
+import org.scalatest.matchers.should.Matchers
+
+import scala.util.Random
+
+class DSESweepSpec extends AnyFlatSpec with Matchers {
+  import DSESweep._
+
+  val rnd = new Random(25)
+
+  def testData(n: Int): Array[Float] = Array.tabulate(n) { i =>
+    if (rnd.nextInt(10) == 0) 0f else math.sin(i / 50.0).toFloat * 100f + rnd.nextFloat()
+  }
+
+  lazy val xray: Dataset = load("test_data/25-trimmed.npy").get
+
+  "SZxSizeModel" should "give the szx_cli compressed sizes of the X-ray data" in {
+    val data = xray.floats(0, xray.nbElements)
+    // SZxLite szx_cli -A 1e-3 / 1e-1 with block sizes 64 and 128
+    for (((blockSize, eb), bytes) <- Seq((64, 1e-3f) -> 50701, (64, 1e-1f) -> 35604,
+                                         (128, 1e-3f) -> 48910, (128, 1e-1f) -> 34384)) {
+      SZxSizeModel.blocks(data, 0, data.length, blockSize, eb).totalBytes shouldBe bytes
+    }
+  }
+
+  it should "add up block ranges" in {
+    val data = testData(10000)
+    val whole = SZxSizeModel.blocks(data, 0, data.length, 64, 0.5f)
+    val parts = (0 until data.length by 1024).map { s =>
+      SZxSizeModel.blocks(data, s, math.min(1024, data.length - s), 64, 0.5f)
+    }
+    parts.reduce(_ + _) shouldBe whole
+    whole.nbBlocks shouldBe (data.length + 63) / 64
+  }
+
+  "DSESweep" should "count V2F packets as V2FConv" in {
+    v2fBits(0, 4, 36) shouldBe 4
+    v2fBits(5, 4, 36) shouldBe 12
+    v2fBits(24, 4, 36) shouldBe 28
+    v2fBits(25, 4, 36) shouldBe 40
+    validV2F(4, 128, 36) shouldBe true
+    validV2F(4, 64, 36) shouldBe false
+    validV2F(3, 96, 36) shouldBe false
+  }
+
+  it should "sum the residual magnitudes as the BigInt model" in {
+    val data = testData(3000)
+    val coefficients = List(4, -6, 4, -1)
+    val lpenc = performLagrangeForward(data.toList.map(convFloat2Bin).map(LPECompEstimateCR.ifp32Forward),
+      coefficients)
+    val h = LPECompEstimateCR.histogram(LPECompEstimateCR.integerize(data), coefficients, 2, 500)
+    h.totalMagnitudeBits(m => m) shouldBe lpenc.map(_.abs.bitLength.toLong).sum
+  }
+
+  it should "give the estimator CRs and one point per configuration" in {
+    val data = testData(20000)
+    val d = Dataset("synthetic", LPECompEstimateCR.integerize(data))
+    val config = SweepConfig(coefficientSets = Seq(Seq(2, -1), Seq(4, -6, 4, -1)), packetbws = Seq(4, 8),
+      outbws = Seq(64, 128), blockSizes = Seq(64), errorBounds = Seq(1e-3, 1e-2), threads = 3, chunkSize = 4096)
+    val points = sweep(Seq(d), config)
+
+    for (c <- config.coefficientSets) {
+      val lpe = points.filter(p => p.codec == "lpe" && p.coefficients.contains(c))
+      lpe.filter(_.scheme != "V2F").map(p => (p.scheme, p.bits)) shouldBe
+        LPECompEstimateCR.estimate(data, c.toList).schemeBits
+      val v2f = lpe.filter(_.scheme == "V2F")
+      v2f.map(p => (p.packetbw.get, p.outbw.get)) shouldBe
+        (for (p <- config.packetbws; o <- config.outbws
+              if validV2F(p, o, LPECompEstimateCR.align(LPECompEstimateCR.sintNbits(c), p))) yield (p, o))
+      v2f.foreach(p => p.bits % p.outbw.get shouldBe 0)
+    }
+
+    val szx = points.filter(_.codec == "szx")
+    szx.map(p => (p.blockSize.get, p.errorBound.get)) shouldBe Seq((64, 1e-3), (64, 1e-2))
+    szx.head.bits shouldBe 8 * SZxSizeModel.blocks(data, 0, data.length, 64, (1e-3 * d.valueRange).toFloat).totalBytes
+    szx.head.bits should be > szx(1).bits
+  }
+
+  it should "write one CSV row and one JSON object per point" in {
+    val d = Dataset("a,b", LPECompEstimateCR.integerize(testData(1000)))
+    val points = sweep(Seq(d), SweepConfig(coefficientSets = Seq(Seq(1)), blockSizes = Seq(64), threads = 1))
+    val csv = toCSV(points).split("\n")
+    csv.length shouldBe points.length + 1
+    csv.head shouldBe points.head.fields.map(_._1).mkString(",")
+    csv(1) should startWith("\"a,b\",lpe,1,Ideal,,,,,1000,")
+    val json = toJSON(points)
+    json.linesIterator.count(_.startsWith("  {")) shouldBe points.length
+    json should include("\"block_size\": null")
+    json should include("\"block_size\": 64")
+  }
+}
@@ -0,0 +1,82 @@
+// See LICENSE.txt in the project root for license information.
+// Author: LPECompEstimateCR Test
+
+package estimate
+
+import common.IntegerizeFPSpecUtil._
+import common.NumpyReader
+import lpe.LagrangePredSpecUtil._
+import java.io.File
+import java.nio.{ByteBuffer, ByteOrder}
+import java.nio.file.Files
+import org.scalatest.flatspec.AnyFlatSpec
+import org.scalatest.matchers.should.Matchers
+
+import scala.util.Random
+
+class LPECompEstimateCRSpec extends AnyFlatSpec with Matchers {
+  import LPECompEstimateCR._
+
+  val rnd = new Random(24)
+
+  def testData(n: Int): Array[Float] = Array.tabulate(n) { i =>
+    if (rnd.nextInt(10) == 0) 0f else math.sin(i / 50.0).toFloat * 100f + rnd.nextFloat()
+  }
+
+  // the BigInt model: List residuals from performLagrangeForward
+  def referenceBits(data: Array[Float], coefficients: List[Int]): Seq[Long] = {
+    val lpenc = performLagrangeForward(data.toList.map(convFloat2Bin).map(ifp32Forward), coefficients)
+    val fullBits = sint_size_aligned(sintNbits(coefficients), 4)
+    lpenc.map(v => v.bitLength + (if (v < 0) 1L else 0L)).sum +:
+      codeSchemes.map(s => lpenc.map(v => s.bits(v.bitLength, fullBits).toLong).sum)
+  }
+
+  "LPECompEstimateCR" should "match the BigInt model for every code scheme" in {
+    for (coefficients <- Seq(List(4, -6, 4, -1), List(3, -3, 1), List(2, -1), List(1))) {
+      val data = testData(3000)
+      val report = estimate(data, coefficients)
+      report.nbElements shouldBe data.length
+      report.schemeBits.map(_._2) shouldBe referenceBits(data, coefficients)
+    }
+  }
+
+  it should "give the same histogram for any chunking and thread count" in {
+    val ints = integerize(testData(10000))
+    val whole = histogram(ints, lagrangepred, threads = 1, chunkSize = ints.length)
+    for ((threads, chunkSize) <- Seq((1, 7), (4, 1000), (3, 4096))) {
+      val h = histogram(ints, lagrangepred, threads, chunkSize)
+      h.nonNegative shouldBe whole.nonNegative
+      h.negative shouldBe whole.negative
+    }
+  }
+
+  it should "round trip the integerized values" in {
+    val data = testData(1000) ++ Array(Float.MaxValue, -Float.MaxValue, Float.MinPositiveValue, -0f)
+    val ints = integerize(data)
+    ints.map(ifp32Backward) shouldBe data.map(java.lang.Float.floatToRawIntBits)
+    roundTrip(ints, 0, ints.length, lagrangepred.toArray) shouldBe true
+    roundTrip(ints, 500, ints.length, Array(3, -3, 1)) shouldBe true
+  }
+
+  it should "stream a raw file in chunks with the predictor state carried over" in {
+    val data = testData(5000)
+    val buf = ByteBuffer.allocate(4 * data.length).order(ByteOrder.LITTLE_ENDIAN)
+    data.foreach(buf.putFloat)
+    val file = File.createTempFile("lpecr", ".f32")
+    file.deleteOnExit()
+    Files.write(file.toPath, buf.array())
+
+    val array = NumpyReader.openRaw(file.getPath, "f4").get
+    array.nbElements shouldBe data.length
+    val report = estimate(array, lagrangepred, threads = 3, chunkSize = 333, verify = true).get
+    report.schemeBits shouldBe estimate(data, lagrangepred).schemeBits
+  }
+
+  it should "estimate the X-ray data file" in {
+    val array = NumpyReader.open("test_data/25-trimmed.npy").get
+    val report = estimate(array, lagrangepred, threads = 2, chunkSize = 1 << 12, verify = true).get
+    report.nbElements shouldBe 32768
+    report.schemeBits shouldBe estimate(array.toArray, lagrangepred).schemeBits
+    report.schemeBits.foreach { case (_, bits) => bits should be < report.origBits }
+  }
+}